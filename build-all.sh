@@ -23,4 +23,13 @@ then
     echo "Error building engine-tester at errorlevel $ERRORLEVEL"
 fi
 
+pushd logDecoder
+source build.sh
+popd
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]; 
+then
+    echo "Error building log decoder at errorlevel $ERRORLEVEL"
+fi
+
 echo "Successfully built everything!"
@@ -14,7 +14,7 @@ SET assembly=Just_Forge_Engine
 SET compilerFlags=-g -shared -Wvarargs -Wall -Werror
 REM -Wall -Werror
 SET includeFlags=-Isrc -I%VULKAN_SDK%/Include
-SET linkerFlags=-luser32 -lvulkan-1 -L%VULKAN_SDK%/Lib
+SET linkerFlags=-luser32 -lsynchronization -lvulkan-1 -L%VULKAN_SDK%/Lib
 SET defines=-D_DEBUG -DFORGE_EXPORT -D_CRT_SECURE_NO_WARNINGS
 
 ECHO "Building %assembly%%..."
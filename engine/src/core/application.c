@@ -4,11 +4,14 @@
 #include "logger.h"
 #include "memory.h"
 #include "platform/platform.h"
+#include "platform/async_io.h"
 #include "game_types.h"
 #include "core/memory.h"
 #include "core/event.h"
+#include "core/event_recorder.h"
 #include "core/input.h"
 #include "core/clock.h"
+#include "core/cpu_dispatch.h"
 #include "renderer/renderer_frontend.h"
 
 // - - - | Application State | - - -
@@ -20,10 +23,18 @@ typedef struct applicationState
     bool8 isRunning;
     bool8 isSuspended;
     platformState platform;
-    short width;
-    short height;
-    double lastTime;
+    unsigned short width;
+    unsigned short height;
+    unsigned long long lastTicks;
     clock clock;
+    frameLimiter limiter;
+    platformCounterGroup counters;
+    platformCounterValues counterTotals; //Summed over the frames counted since the last stats reset
+    unsigned long long countedFrames;
+    eventHandle quitHandle;
+    eventHandle keyPressHandle;
+    eventHandle keyReleaseHandle;
+    eventHandle resizeHandle;
 } applicationState;
 
 static bool8 initialized = FALSE;
@@ -39,6 +50,18 @@ bool8 applicationOnEvent(unsigned short CODE, void* SENDER, void* LISTENER, even
 
 bool8 applicationOnKey(unsigned short CODE, void* SENDER, void* LISTENER, eventContext context);
 
+bool8 applicationOnResize(unsigned short CODE, void* SENDER, void* LISTENER, eventContext CONTEXT);
+
+// - - - Frame Pacing - - -
+
+#define APPLICATION_SUSPENDED_SLEEP_MILLISECONDS 16
+
+void applicationLogFrameStats();
+
+void applicationResetFrameStats();
+
+void applicationCountFrame(const platformCounterValues* START);
+
 
 // - - - Create Application
 bool8 createApplication(game* GAME)
@@ -53,12 +76,23 @@ bool8 createApplication(game* GAME)
 
     //Initialise logging system
     initializeLogger();
+    if (GAME->config.binaryLogPath)
+    {
+        loggerSetMode(LOGGER_MODE_BINARY, GAME->config.binaryLogPath);
+    }
+    if (GAME->config.logFilePath)
+    {
+        loggerOpenFile(GAME->config.logFilePath, GAME->config.logFileSize, GAME->config.logFileCount);
+    }
+    loggerSetConsole(!GAME->config.isConsoleLogDisabled, !GAME->config.isConsoleLogPlain);
 
-    //Intialise input system
-    inputInitialize();
+    //Report the processor and settle the kernels registered so far
+    cpuDispatchInitialize();
 
     appState.isRunning = TRUE;
     appState.isSuspended = FALSE;
+    appState.width = GAME->config.startWidth;
+    appState.height = GAME->config.startHeight;
 
     //Initialise the event system
     if (!eventInitialize())
@@ -66,20 +100,56 @@ bool8 createApplication(game* GAME)
         FORGE_LOG_FATAL("Event system failed initialisation");
         return FALSE;
     }
+
+    //Intialise input system, after events since it sets up coalescing for its events
+    inputInitialize();
     
     //Register event listeners
-    eventRegister(EVENT_CODE_APPLICATION_QUIT, 0, applicationOnEvent);
-    eventRegister(EVENT_CODE_KEY_PRESS, 0, applicationOnKey);
-    eventRegister(EVENT_CODE_KEY_RELEASE, 0, applicationOnKey);
+    appState.quitHandle = eventSubscribe(EVENT_CODE_APPLICATION_QUIT, 0, applicationOnEvent, EVENT_PRIORITY_DEFAULT);
+    appState.keyPressHandle = eventSubscribe(EVENT_CODE_KEY_PRESS, 0, applicationOnKey, EVENT_PRIORITY_DEFAULT);
+    appState.keyReleaseHandle = eventSubscribe(EVENT_CODE_KEY_RELEASE, 0, applicationOnKey, EVENT_PRIORITY_DEFAULT);
+    appState.resizeHandle = eventSubscribe(EVENT_CODE_RESIZE, 0, applicationOnResize, EVENT_PRIORITY_DEFAULT);
+
+    //Only the final size of a frame matters
+    eventSetCoalescing(EVENT_CODE_RESIZE, EVENT_COALESCE_KEEP_LAST, 0);
+
+    //Streaming and saves, before the game can ask for either and before the event recorder writes through it
+    if (!asyncIoInitialize())
+    {
+        FORGE_LOG_FATAL("Failed to initialise async IO");
+        return FALSE;
+    }
+
+    //Replaying takes precedence, recording a replay would just copy the file
+    if (GAME->config.eventReplayPath)
+    {
+        eventReplayStart(GAME->config.eventReplayPath);
+    }
+    else if (GAME->config.eventRecordPath)
+    {
+        eventRecorderStart(GAME->config.eventRecordPath);
+    }
 
     //Intitialise the platform
+    appState.platform.isHeadless = GAME->config.isHeadless;
     if(!platformInit(&appState.platform, GAME->config.name, GAME->config.startPositionX, GAME->config.startPositionY, GAME->config.startWidth, GAME->config.startHeight)) 
     {
         return FALSE;
     }
+
+    if (GAME->config.isHeadless)
+    {
+        platformSetSyntheticEventSource(&appState.platform, GAME->config.syntheticEventSource, GAME->config.syntheticEventUser);
+    }
+    //The message pump reads the window itself when there is no input thread
+    else if (GAME->config.useInputThread && !platformStartInputThread(&appState.platform))
+    {
+        FORGE_LOG_WARNING("Input thread could not start, reading input once per frame");
+    }
     
-    //Initialise the renderer
-    if (!rendererIntitialize(GAME->config.name, &appState.platform))
+    //Initialise the renderer, there is nothing to draw to without a window
+    rendererBackendType rendererType = GAME->config.isHeadless ? RENDERER_NULL : RENDERER_VULKAN;
+    if (!rendererIntitialize(rendererType, GAME->config.name, &appState.platform))
     {
         FORGE_LOG_FATAL("Failed to initialize the renderer");
         return FALSE;
@@ -103,25 +173,52 @@ bool8 runApplication()
 {
     clockStart(&appState.clock);
     clockUpdate(&appState.clock);
-    appState.lastTime = appState.clock.elapsedTime;
-    double runningTime = 0.0;
-    unsigned char frameCount = 0;
-    double targetFrameTime = 1.0f / 60.0; // 60 fps
+    appState.lastTicks = appState.clock.elapsedTicks;
+    frameLimiterStart(&appState.limiter, appState.gameInstance->config.targetFrameRate);
+
+    //Counts this thread's work, frame statistics fall back to wall time alone without them
+    platformCountersOpen(&appState.counters);
+    applicationResetFrameStats();
 
     while (appState.isRunning) 
     {
-        if (!platformGiveMessages(&appState.platform))
+        //The frame's work starts here, the message pump, IO callbacks and event flush all count towards it
+        platformCounterValues frameStart;
+        platformCountersRead(&appState.counters, &frameStart);
+
+        if (eventReplayIsActive())
         {
-            appState.isRunning = FALSE;
+            //Live platform messages are left alone so they cannot mix with the recorded ones
+            if (!eventReplayGiveMessages())
+            {
+                appState.isRunning = FALSE;
+            }
         }
+        else
+        {
+            eventRecorderBeginPlatformMessages();
+            if (!platformGiveMessages(&appState.platform))
+            {
+                appState.isRunning = FALSE;
+            }
+            eventRecorderEndPlatformMessages();
+        }
+
+        //Submit the IO queued last frame and run the callbacks of what finished, events they post go out with this flush
+        asyncIoUpdate();
+
+        //Deliver everything posted since the last frame in one batch
+        eventFlush();
 
         // TODO: take care of delta time.
         if (!appState.isSuspended)
         {
             clockUpdate(&appState.clock);
-            double currentTime = appState.clock.elapsedTime;
-            double deltaTime = currentTime - appState.lastTime;
-            double frameStartTime = platformGetTime();
+            unsigned long long currentTicks = appState.clock.elapsedTicks;
+            double deltaTime = clockTicksToSeconds(currentTicks - appState.lastTicks);
+
+            //Latch this frame's input, everything the pump and the flush just processed is visible from here on
+            inputUpdate(deltaTime);
 
             if (!appState.gameInstance->update(appState.gameInstance, deltaTime))
             {
@@ -141,39 +238,47 @@ bool8 runApplication()
             packet.deltaTime = deltaTime;
             rendererDrawFrame(&packet);  
 
-            double frameEndTime = platformGetTime();
-            double frameElapsedTime = frameEndTime - frameStartTime;
-            runningTime += frameElapsedTime;
-            double remainingSeconds = targetFrameTime - frameElapsedTime;
-
-            if (remainingSeconds > 0)
-            {
-                unsigned long long remainingMiliseconds = (remainingSeconds * 1000);
-                bool8 limitFrames = FALSE; //give time back to os
-                if (remainingMiliseconds > 0 && limitFrames)
-                {
-                    platformSleep(remainingMiliseconds - 1);
-                }
-                ++frameCount;
-            }
+            //Event payloads from last frame have all been delivered by now
+            eventEndFrame();
 
-            //NOTE: input state should be handled after input recorded or before this line
-            inputUpdate(deltaTime);
+            //Before the limiter, its sleeping and spinning is not the frame's work
+            applicationCountFrame(&frameStart);
             
-            appState.lastTime = currentTime;
+            appState.lastTicks = currentTicks;
+
+            //Hold the next frame back until it is due
+            frameLimiterWait(&appState.limiter);
+        }
+        else
+        {
+            //Payloads posted while minimised were just flushed, their arena still has to be handed back
+            eventEndFrame();
+
+            //Nothing is shown while minimised, no reason to spin until the window comes back
+            platformSleep(APPLICATION_SUSPENDED_SLEEP_MILLISECONDS);
         }
     }
 
     appState.isRunning = FALSE;
+    applicationLogFrameStats();
+    platformCountersClose(&appState.counters);
 
     //Unregister event listeners
-    eventUnregister(EVENT_CODE_APPLICATION_QUIT, 0, applicationOnEvent);
-    eventUnregister(EVENT_CODE_KEY_PRESS, 0, applicationOnKey);
-    eventUnregister(EVENT_CODE_KEY_RELEASE, 0, applicationOnKey);
+    eventUnsubscribe(appState.quitHandle);
+    eventUnsubscribe(appState.keyPressHandle);
+    eventUnsubscribe(appState.keyReleaseHandle);
+    eventUnsubscribe(appState.resizeHandle);
+    eventRecorderStop();
+    eventReplayStop();
     eventShutdown();
     inputShutdown();
+    asyncIoShutdown();
     rendererShutdown();
     platformShutdown(&appState.platform);
+    cpuDispatchShutdown();
+
+    //Last, everything above may still log
+    shutdownLogger();
     return TRUE;
 }
 
@@ -193,6 +298,38 @@ bool8 applicationOnEvent(unsigned short CODE, void* SENDER, void* LISTENER, even
     return FALSE;
 }
 
+bool8 applicationOnResize(unsigned short CODE, void* SENDER, void* LISTENER, eventContext CONTEXT)
+{
+    unsigned short width = CONTEXT.data.u16[0];
+    unsigned short height = CONTEXT.data.u16[1];
+    if (width == appState.width && height == appState.height)
+    {
+        return FALSE;
+    }
+
+    appState.width = width;
+    appState.height = height;
+    FORGE_LOG_DEBUG("Window resized to %i x %i", width, height);
+
+    //Minimised, stop updating and rendering until the window comes back
+    if (width == 0 || height == 0)
+    {
+        FORGE_LOG_INFO("Window minimised, suspending application");
+        appState.isSuspended = TRUE;
+        return TRUE;
+    }
+
+    if (appState.isSuspended)
+    {
+        FORGE_LOG_INFO("Window restored, resuming application");
+        appState.isSuspended = FALSE;
+    }
+
+    appState.gameInstance->onResize(appState.gameInstance, width, height);
+    rendererResized(width, height);
+    return FALSE;
+}
+
 bool8 applicationOnKey(unsigned short CODE, void* SENDER, void* LISTENER, eventContext CONTEXT)
 {
     unsigned short keyCode;
@@ -208,7 +345,16 @@ bool8 applicationOnKey(unsigned short CODE, void* SENDER, void* LISTENER, eventC
                     return TRUE;
 
                 case KEY_F1:
-                    FORGE_LOG_DEBUG(forgeGetMemoryStats());
+                    FORGE_LOG_DEBUG("%s", forgeGetMemoryStats());
+                    return TRUE;
+
+                case KEY_F2:
+                    eventDumpStats();
+                    return TRUE;
+
+                case KEY_F3:
+                    applicationLogFrameStats();
+                    applicationResetFrameStats();
                     return TRUE;
 
                 default:
@@ -230,3 +376,45 @@ bool8 applicationOnKey(unsigned short CODE, void* SENDER, void* LISTENER, eventC
     return FALSE;
 }
 
+
+// - - - Frame Pacing - - -
+
+void applicationLogFrameStats()
+{
+    frameLimiterStats stats = frameLimiterGetStats(&appState.limiter);
+    FORGE_LOG_DEBUG("Frames: %llu, %llu missed, average %.3f ms, jitter %.3f ms, min %.3f ms, max %.3f ms", stats.frames, stats.missedFrames, stats.averageMilliseconds, stats.jitterMilliseconds, stats.minimumMilliseconds, stats.maximumMilliseconds);
+
+    if (!appState.counters.available || !appState.countedFrames)
+    {
+        return;
+    }
+
+    //Low instructions per cycle with many cache misses means the frame waits on memory, not on arithmetic
+    const unsigned long long* totals = appState.counterTotals.values;
+    double frames = (double) appState.countedFrames;
+    double instructionsPerCycle = totals[PLATFORM_COUNTER_CYCLES] ? (double) totals[PLATFORM_COUNTER_INSTRUCTIONS] / totals[PLATFORM_COUNTER_CYCLES] : 0.0;
+    FORGE_LOG_DEBUG("Per frame: %.0f cycles, %.0f instructions, %.2f IPC, %.0f cache misses, %.0f branch misses", totals[PLATFORM_COUNTER_CYCLES] / frames, totals[PLATFORM_COUNTER_INSTRUCTIONS] / frames, instructionsPerCycle, totals[PLATFORM_COUNTER_CACHE_MISSES] / frames, totals[PLATFORM_COUNTER_BRANCH_MISSES] / frames);
+}
+
+void applicationResetFrameStats()
+{
+    frameLimiterResetStats(&appState.limiter);
+    platformZeroMemory(&appState.counterTotals, sizeof(appState.counterTotals));
+    appState.countedFrames = 0;
+}
+
+void applicationCountFrame(const platformCounterValues* START)
+{
+    if (!appState.counters.available)
+    {
+        return;
+    }
+
+    platformCounterValues end;
+    platformCountersRead(&appState.counters, &end);
+    for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX; ++i)
+    {
+        appState.counterTotals.values[i] += end.values[i] - START->values[i];
+    }
+    appState.countedFrames++;
+}
@@ -15,6 +15,19 @@ typedef struct applicationConfig
     short startWidth;
     short startHeight;
     char* name;
+    const char* eventRecordPath; //Record every event raised this run to this file, zero to disable
+    const char* eventReplayPath; //Replay a recording instead of reading the platform messages, zero to disable
+    bool8 useInputThread; //Sample input on its own thread with per message timestamps
+    unsigned short targetFrameRate; //Frames per second the loop is paced to, zero runs unlimited
+    bool8 isHeadless; //No display or window and the null renderer, for servers and automated tests
+    bool8 (*syntheticEventSource)(double TIME, void* USER); //Feeds a headless run once per frame, return FALSE to quit. Zero for none
+    void* syntheticEventUser;
+    const char* binaryLogPath; //Log warnings and below unformatted to this file for the log decoder, zero logs text to the console
+    const char* logFilePath; //Also log every message as text to this file, rotated as it fills. Zero for none
+    unsigned long long logFileSize; //Bytes per log file, zero for LOGGER_FILE_DEFAULT_SIZE
+    unsigned int logFileCount; //Older log files kept on rotation
+    bool8 isConsoleLogDisabled; //For production, where the log file is enough
+    bool8 isConsoleLogPlain; //No color escapes, for output going to a file or a pipe
 } applicationConfig;
 
 
@@ -1,24 +1,177 @@
 #include "clock.h"
 #include "platform/platform.h"
 
+#include <math.h>
+
 
 // - - - Clock Functions - - -
 
 void clockUpdate(clock* CLOCK)
 {
-    if (CLOCK->startTime != 0)
+    if (CLOCK->startTicks != 0)
     {
-        CLOCK->elapsedTime = platformGetTime() - CLOCK->startTime;
+        CLOCK->elapsedTicks = platformGetTicks() - CLOCK->startTicks;
     }
 }
 
 void clockStart(clock* CLOCK)
 {
-    CLOCK->startTime = platformGetTime();
-    CLOCK->elapsedTime = 0;
+    CLOCK->startTicks = platformGetTicks();
+    CLOCK->elapsedTicks = 0;
 }
 
 void clockStop(clock* CLOCK)
 {
-    CLOCK->startTime = 0;
+    CLOCK->startTicks = 0;
+}
+
+
+// - - - Tick Conversions - - -
+
+double clockTicksToSeconds(unsigned long long TICKS)
+{
+    return TICKS * 0.000000001;
+}
+
+double clockTicksToMilliseconds(unsigned long long TICKS)
+{
+    return TICKS * 0.000001;
+}
+
+double clockTicksToMicroseconds(unsigned long long TICKS)
+{
+    return TICKS * 0.001;
+}
+
+unsigned long long clockSecondsToTicks(double SECONDS)
+{
+    return SECONDS > 0.0 ? (unsigned long long) (SECONDS * CLOCK_TICKS_PER_SECOND) : 0;
+}
+
+
+// - - - | Frame Limiter | - - -
+
+
+// - - - Spin Tuning
+#define FRAME_LIMITER_INITIAL_SPIN_TICKS 500000ULL //Half a millisecond
+#define FRAME_LIMITER_MINIMUM_SPIN_TICKS 50000ULL
+#define FRAME_LIMITER_MAXIMUM_SPIN_TICKS 2000000ULL
+
+void frameLimiterRecordPeriod(frameLimiter* LIMITER, unsigned long long PERIOD);
+
+
+// - - - Frame Limiter Functions - - -
+
+void frameLimiterStart(frameLimiter* LIMITER, double RATE)
+{
+    LIMITER->wakeLatency = FRAME_LIMITER_INITIAL_SPIN_TICKS;
+    LIMITER->lastWake = platformGetTicks();
+    frameLimiterSetRate(LIMITER, RATE);
+    frameLimiterResetStats(LIMITER);
+}
+
+void frameLimiterSetRate(frameLimiter* LIMITER, double RATE)
+{
+    LIMITER->periodTicks = RATE > 0.0 ? clockSecondsToTicks(1.0 / RATE) : 0;
+    LIMITER->deadline = platformGetTicks() + LIMITER->periodTicks;
+}
+
+void frameLimiterWait(frameLimiter* LIMITER)
+{
+    unsigned long long now = platformGetTicks();
+    if (LIMITER->periodTicks)
+    {
+        if (now >= LIMITER->deadline)
+        {
+            LIMITER->missedFrames++;
+
+            //More than a whole frame behind, start over from now instead of rushing frames out to catch up
+            if (now - LIMITER->deadline >= LIMITER->periodTicks)
+            {
+                LIMITER->deadline = now;
+            }
+        }
+        else
+        {
+            //Give the processor back for most of the wait
+            if (LIMITER->deadline - now > LIMITER->wakeLatency)
+            {
+                unsigned long long sleepUntil = LIMITER->deadline - LIMITER->wakeLatency;
+                platformSleepUntil(sleepUntil);
+
+                //Follow a rise in wake up latency at once, a fall slowly
+                unsigned long long woke = platformGetTicks();
+                unsigned long long latency = woke > sleepUntil ? woke - sleepUntil : 0;
+                if (latency > LIMITER->wakeLatency)
+                {
+                    LIMITER->wakeLatency = latency;
+                }
+                else
+                {
+                    LIMITER->wakeLatency -= (LIMITER->wakeLatency - latency) / 16;
+                }
+                LIMITER->wakeLatency = FORGE_CLAMP(LIMITER->wakeLatency, FRAME_LIMITER_MINIMUM_SPIN_TICKS, FRAME_LIMITER_MAXIMUM_SPIN_TICKS);
+            }
+
+            //Spin out the last fraction
+            do
+            {
+                PLATFORM_SPIN_PAUSE();
+                now = platformGetTicks();
+            } while (now < LIMITER->deadline);
+        }
+        LIMITER->deadline += LIMITER->periodTicks;
+    }
+
+    frameLimiterRecordPeriod(LIMITER, now - LIMITER->lastWake);
+    LIMITER->lastWake = now;
+}
+
+frameLimiterStats frameLimiterGetStats(const frameLimiter* LIMITER)
+{
+    frameLimiterStats stats = {};
+    stats.frames = LIMITER->frames;
+    stats.missedFrames = LIMITER->missedFrames;
+    if (LIMITER->frames > 0)
+    {
+        stats.averageMilliseconds = LIMITER->meanPeriod * 0.000001;
+        stats.minimumMilliseconds = clockTicksToMilliseconds(LIMITER->minimumPeriod);
+        stats.maximumMilliseconds = clockTicksToMilliseconds(LIMITER->maximumPeriod);
+    }
+    if (LIMITER->frames > 1)
+    {
+        stats.jitterMilliseconds = sqrt(LIMITER->periodSquares / (LIMITER->frames - 1)) * 0.000001;
+    }
+    return stats;
+}
+
+void frameLimiterResetStats(frameLimiter* LIMITER)
+{
+    LIMITER->frames = 0;
+    LIMITER->missedFrames = 0;
+    LIMITER->minimumPeriod = ~0ULL;
+    LIMITER->maximumPeriod = 0;
+    LIMITER->meanPeriod = 0.0;
+    LIMITER->periodSquares = 0.0;
+}
+
+
+// - - - Helpers - - -
+
+void frameLimiterRecordPeriod(frameLimiter* LIMITER, unsigned long long PERIOD)
+{
+    //Welford's running mean and variance, no history to keep
+    LIMITER->frames++;
+    double delta = (double) PERIOD - LIMITER->meanPeriod;
+    LIMITER->meanPeriod += delta / LIMITER->frames;
+    LIMITER->periodSquares += delta * ((double) PERIOD - LIMITER->meanPeriod);
+
+    if (PERIOD < LIMITER->minimumPeriod)
+    {
+        LIMITER->minimumPeriod = PERIOD;
+    }
+    if (PERIOD > LIMITER->maximumPeriod)
+    {
+        LIMITER->maximumPeriod = PERIOD;
+    }
 }
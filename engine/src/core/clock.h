@@ -4,10 +4,11 @@
 
 // - - - Clock - - -
 
+// Ticks are platformGetTicks nanoseconds, integers so long uptimes keep their precision
 typedef struct clock 
 {
-    double startTime;
-    double elapsedTime;
+    unsigned long long startTicks;
+    unsigned long long elapsedTicks;
 } clock;
 
 
@@ -16,3 +17,63 @@ typedef struct clock
 void clockUpdate(clock* CLOCK);
 void clockStart(clock* CLOCK);
 void clockStop(clock* CLOCK);
+
+
+// - - - Tick Conversions - - -
+
+#define CLOCK_TICKS_PER_SECOND 1000000000ULL
+
+double clockTicksToSeconds(unsigned long long TICKS);
+double clockTicksToMilliseconds(unsigned long long TICKS);
+double clockTicksToMicroseconds(unsigned long long TICKS);
+unsigned long long clockSecondsToTicks(double SECONDS);
+
+
+// - - - | Frame Limiter | - - -
+
+/*
+- - - | Frame pacing | - - -
+    Frames are due at absolute deadlines one period apart, so a late frame does not push back every frame after it.
+    The limiter sleeps until just before the deadline and spins the rest, sleeps wake up late by a varying amount
+    and the spin covers how late they have been waking recently.
+    Frame to frame periods are tracked either way, jitter is their standard deviation.
+*/
+
+typedef struct frameLimiter
+{
+    unsigned long long periodTicks; //Zero runs unlimited
+    unsigned long long deadline;
+    unsigned long long wakeLatency; //Spin this long before the deadline
+    unsigned long long lastWake;
+
+    //Statistics since the last reset
+    unsigned long long frames;
+    unsigned long long missedFrames;
+    unsigned long long minimumPeriod;
+    unsigned long long maximumPeriod;
+    double meanPeriod;
+    double periodSquares; //Sum of squared differences from the mean
+} frameLimiter;
+
+typedef struct frameLimiterStats
+{
+    unsigned long long frames;
+    unsigned long long missedFrames; //Frames that were not done by their deadline
+    double averageMilliseconds;
+    double jitterMilliseconds;
+    double minimumMilliseconds;
+    double maximumMilliseconds;
+} frameLimiterStats;
+
+
+// - - - Frame Limiter Functions - - -
+
+// RATE is in frames per second, zero for unlimited
+void frameLimiterStart(frameLimiter* LIMITER, double RATE);
+void frameLimiterSetRate(frameLimiter* LIMITER, double RATE);
+
+// Call once at the end of every frame, returns when the next frame is due
+void frameLimiterWait(frameLimiter* LIMITER);
+
+frameLimiterStats frameLimiterGetStats(const frameLimiter* LIMITER);
+void frameLimiterResetStats(frameLimiter* LIMITER);
@@ -0,0 +1,126 @@
+#include "cpu_dispatch.h"
+#include "logger.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+
+
+// - - - | CPU Dispatch State | - - -
+
+
+typedef struct cpuDispatchState
+{
+    bool8 isInitialized;
+    unsigned int features;
+    unsigned int kernelCount;
+    cpuKernel* kernels[CPU_DISPATCH_MAX_KERNELS];
+} cpuDispatchState;
+
+static cpuDispatchState state;
+
+// - - - Feature Names, in platformCpuFeature bit order
+static const char* featureNames[PLATFORM_CPU_FEATURE_COUNT] = {"SSE2", "SSE4.1", "SSE4.2", "POPCNT", "AVX", "AVX2", "FMA", "BMI2", "AVX-512F", "AVX-512BW", "AVX-512VL", "NEON"};
+
+#define CPU_DISPATCH_DESCRIPTION_LENGTH 128
+
+void cpuDispatchLogKernel(const cpuKernel* KERNEL);
+
+
+// - - - | CPU Dispatch Functions | - - -
+
+
+bool8 cpuDispatchInitialize()
+{
+    state.features = platformGetCpuFeatures();
+
+    char features[CPU_DISPATCH_DESCRIPTION_LENGTH];
+    cpuDispatchDescribeFeatures(state.features, features, sizeof(features));
+    platformCpuInfo info;
+    platformGetCpuInfo(&info);
+    FORGE_LOG_INFO("CPU: %u logical cores, %u physical, L1d %u KB, L2 %u KB, L3 %u KB, features %s", info.logicalCores, info.physicalCores, info.l1DataCacheSize / 1024, info.l2CacheSize / 1024, info.l3CacheSize / 1024, features);
+
+    //Kernels registered before this, from modules brought up ahead of the application
+    for (unsigned int i = 0; i < state.kernelCount; ++i)
+    {
+        cpuDispatchLogKernel(state.kernels[i]);
+    }
+
+    state.isInitialized = TRUE;
+    return TRUE;
+}
+
+void cpuDispatchShutdown()
+{
+    state.isInitialized = FALSE;
+    state.kernelCount = 0;
+}
+
+bool8 cpuDispatchRegister(cpuKernel* KERNEL)
+{
+    //Features are read on first use, so kernels can register before initialisation
+    unsigned int features = platformGetCpuFeatures();
+
+    KERNEL->function = 0;
+    for (unsigned int i = 0; i < CPU_KERNEL_MAX_VARIANTS && KERNEL->variants[i].function; ++i)
+    {
+        if ((KERNEL->variants[i].features & features) == KERNEL->variants[i].features)
+        {
+            KERNEL->function = KERNEL->variants[i].function;
+            KERNEL->chosen = i;
+            break;
+        }
+    }
+
+    if (!KERNEL->function)
+    {
+        FORGE_LOG_ERROR("No implementation of kernel %s runs on this CPU, it needs a portable variant", KERNEL->name);
+        return FALSE;
+    }
+
+    if (state.kernelCount < CPU_DISPATCH_MAX_KERNELS)
+    {
+        state.kernels[state.kernelCount++] = KERNEL;
+    }
+
+    if (state.isInitialized)
+    {
+        cpuDispatchLogKernel(KERNEL);
+    }
+    return TRUE;
+}
+
+bool8 cpuDispatchHasFeatures(unsigned int FEATURES)
+{
+    return (platformGetCpuFeatures() & FEATURES) == FEATURES;
+}
+
+void cpuDispatchDescribeFeatures(unsigned int FEATURES, char* BUFFER, unsigned int SIZE)
+{
+    if (!SIZE)
+    {
+        return;
+    }
+
+    BUFFER[0] = 0;
+    unsigned int length = 0;
+    for (unsigned int i = 0; i < PLATFORM_CPU_FEATURE_COUNT && length < SIZE; ++i)
+    {
+        if (FEATURES & (1u << i))
+        {
+            int written = snprintf(BUFFER + length, SIZE - length, length ? " %s" : "%s", featureNames[i]);
+            length += written > 0 ? written : 0;
+        }
+    }
+
+    if (!length)
+    {
+        snprintf(BUFFER, SIZE, "portable");
+    }
+}
+
+void cpuDispatchLogKernel(const cpuKernel* KERNEL)
+{
+    char features[CPU_DISPATCH_DESCRIPTION_LENGTH];
+    cpuDispatchDescribeFeatures(KERNEL->variants[KERNEL->chosen].features, features, sizeof(features));
+    FORGE_LOG_DEBUG("Kernel %s using its %s implementation", KERNEL->name, features);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "defines.h"
+
+
+// - - - | CPU Dispatch | - - -
+
+/*
+- - - | One build, every processor | - - -
+    A kernel is a hot function with several implementations, each needing a set of platformCpuFeature flags.
+    The best one the running processor supports is picked when the kernel registers, callers then go through
+    the function pointer with no checks of their own.
+
+    List variants from most to least capable, the first one whose features are all present wins. The last variant
+    should need nothing so some implementation always runs. Implementations built for a wider instruction set than
+    the rest of the engine mark themselves with __attribute__((target("avx2"))) or similar.
+*/
+
+#define CPU_KERNEL_MAX_VARIANTS 6
+#define CPU_DISPATCH_MAX_KERNELS 64
+
+typedef struct cpuKernelVariant
+{
+    unsigned int features; //platformCpuFeature flags, zero for the portable fallback
+    void* function;
+} cpuKernelVariant;
+
+typedef struct cpuKernel
+{
+    const char* name;
+    cpuKernelVariant variants[CPU_KERNEL_MAX_VARIANTS]; //Ends at the first empty function
+    void* function; //Chosen by cpuDispatchRegister, cast back to the kernel's own type to call it
+    unsigned int chosen; //Index into variants
+} cpuKernel;
+
+
+// - - - | CPU Dispatch Functions | - - -
+
+
+// Logs the processor's features and the kernels registered so far
+bool8 cpuDispatchInitialize();
+
+void cpuDispatchShutdown();
+
+// Choose the kernel's implementation. KERNEL must outlive the engine, usually a static in the module that owns it
+FORGE_API bool8 cpuDispatchRegister(cpuKernel* KERNEL);
+
+// TRUE when every one of the platformCpuFeature FEATURES is present
+FORGE_API bool8 cpuDispatchHasFeatures(unsigned int FEATURES);
+
+// Feature flags as text, e.g. "SSE4.2 AVX2 FMA", "portable" when there are none
+FORGE_API void cpuDispatchDescribeFeatures(unsigned int FEATURES, char* BUFFER, unsigned int SIZE);
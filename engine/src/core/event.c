@@ -1,32 +1,153 @@
 #include "core/event.h"
+#include "core/event_recorder.h"
 #include "core/memory.h"
 #include "core/logger.h"
+#include "core/clock.h"
 #include "event.h"
 #include "dataStructures/list.h"
+#include "platform/platform.h"
 
 typedef struct registeredEvent
 {
     void* listener;
-    eventCallback callback;
+    eventCallback callback; //Zero once unsubscribed, the entry is dropped at the next compaction
+    short priority;
+    unsigned int subscription; //Slot in the subscription table
 } registeredEvent;
 
 typedef struct eventCodeEntry
 {
-    registeredEvent* events;
+    registeredEvent* events; //Sorted by priority, highest first
+    registeredEvent* pending; //Subscribed since the last compaction, merged into events before the next dispatch
+    unsigned int listenerCount; //Live subscriptions in either list, holes left by unsubscribing are not counted
+    unsigned int queuedCount; //Events of this code waiting for the next flush
+    unsigned int lastQueued; //Queue position of the newest of those events
+    unsigned short queuedGroup; //Dispatch group of those events when the code is batched
+    eventMergeFunction merge;
+    unsigned char coalescePolicy;
+    bool8 isBatched; //Order independent, dispatched together at the first post of the flush
+    bool8 needsCompaction;
+    unsigned short dispatchDepth; //Dispatches of this code in progress, its list cannot be compacted under them
+#ifdef FORGE_EVENT_STATS_ENABLED
+    eventCodeStats* stats; //Allocated on first use
+#endif
 } eventCodeEntry;
 
+//Where the listener entry behind a handle currently lives
+typedef struct eventSubscription
+{
+    unsigned int generation; //Bumped when the slot is freed so stale handles stop matching
+    unsigned int index; //Position in the events or pending list of the code
+    unsigned short code;
+    bool8 isPending;
+    bool8 isActive;
+#ifdef FORGE_EVENT_STATS_ENABLED
+    eventCallbackStats stats;
+    void* listener;
+#endif
+} eventSubscription;
+
+typedef struct queuedEvent
+{
+    unsigned short code;
+    unsigned short group; //Where the event lands in the flush, set once it reaches the main queue
+    void* sender;
+    eventContext context;
+} queuedEvent;
+
 // This should be enough number of codes
 #define MAX_MESSAGE_CODES 16384
 
+// Posted events per frame, must be a power of two
+#define EVENT_QUEUE_CAPACITY 4096
+
+// Bytes of payload per frame, two arenas are alive at a time
+#define EVENT_PAYLOAD_ARENA_SIZE (1024 * 1024)
+#define EVENT_PAYLOAD_ALIGNMENT 16
+
+// Marks a context as carrying a payload, spells PAYL
+#define EVENT_PAYLOAD_MAGIC 0x4C594150
+
+// Worker threads that can post at the same time, and their queue sizes (power of two)
+#define EVENT_MAX_POSTING_THREADS 16
+#define EVENT_THREAD_QUEUE_CAPACITY 256
+
+//Single producer single consumer ring, owned by one posting thread and drained by the main thread
+typedef struct eventThreadQueue
+{
+    queuedEvent events[EVENT_THREAD_QUEUE_CAPACITY];
+    unsigned int write; //Only written by the owning thread
+    unsigned int read; //Only written by the main thread
+    bool8 isDetaching; //Set by the owner when it leaves, cleared by the main thread once the queue is drained
+} eventThreadQueue;
+
 //State structure
 typedef struct eventSystemState
 {
     eventCodeEntry registry[MAX_MESSAGE_CODES];
+
+    //Ring buffer of posted events, read and write are free running counters
+    queuedEvent queue[EVENT_QUEUE_CAPACITY];
+    unsigned int queueRead;
+    unsigned int queueWrite;
+
+    //Dispatch groups in post order: one per event, except a batched code shares one for all its events.
+    //Event counts while queueing, turned into offsets into the batch during a flush
+    unsigned int groupOffsets[EVENT_QUEUE_CAPACITY];
+    unsigned int groupCount;
+
+    //Just past the newest keep all post of an ordered code, coalescing never folds a post back across it
+    unsigned int orderBarrier;
+
+    //The queue is sorted into here by group during a flush
+    queuedEvent batch[EVENT_QUEUE_CAPACITY];
+    bool8 isFlushing;
+
+    //Listener lists are only compacted once no dispatch is running
+    unsigned int dispatchDepth;
+    unsigned short* compactionCodes;
+
+    //Handle table, freed slots are reused
+    eventSubscription* subscriptions;
+    unsigned int* freeSubscriptions;
+
+    //Linear payload arenas, the one for frame N is reset at the end of frame N + 1
+    unsigned char* payloadArenas[2];
+    unsigned long long payloadOffset[2];
+    unsigned int payloadFrame;
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+    double statsDumpInterval;
+    double lastStatsDump;
+#endif
+
+    //Worker thread queues, drained in slot order at the start of every flush
+    eventThreadQueue threadQueues[EVENT_MAX_POSTING_THREADS];
+    unsigned int threadQueueCount;
+    unsigned int freeThreadQueues; //Bit per drained slot whose thread detached, reused before a new slot is taken
 } eventSystemState;
 
 static bool8 isInitialized = FALSE;
 static eventSystemState state;
 
+//Bumped on every initialization so threads attached to an older run claim a new slot
+static unsigned int systemGeneration = 0;
+static _Thread_local unsigned int threadGeneration = 0;
+static _Thread_local unsigned int threadSlot = 0;
+
+bool8 eventEnqueue(unsigned short CODE, void* SENDER, eventContext CONTEXT);
+bool8 eventDispatch(unsigned short CODE, void* SENDER, eventContext CONTEXT);
+void eventDrainThreadQueues();
+void eventMarkForCompaction(unsigned short CODE);
+void eventCompactCode(unsigned short CODE);
+void eventCompact();
+eventHandle eventFind(unsigned short CODE, void* LISTENER, eventCallback CALLBACK);
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+eventCodeStats* eventStatsForCode(unsigned short CODE);
+void eventRecordCallback(unsigned int SUBSCRIPTION, double ELAPSED);
+#endif
+
 
 // - - - | Event System functions | - - -
 
@@ -39,8 +160,14 @@ bool8 eventInitialize()
     {
         return FALSE;
     }
-    isInitialized = TRUE;
     forgeZeroMemory(&state, sizeof(state));
+    state.compactionCodes = listCreate(unsigned short);
+    state.subscriptions = listCreate(eventSubscription);
+    state.freeSubscriptions = listCreate(unsigned int);
+    state.payloadArenas[0] = forgeAllocateMemory(EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+    state.payloadArenas[1] = forgeAllocateMemory(EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+    __atomic_add_fetch(&systemGeneration, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&isInitialized, TRUE, __ATOMIC_RELEASE);
     FORGE_LOG_INFO("Event System Initialized");
     return TRUE;
 }
@@ -52,47 +179,205 @@ void eventShutdown()
         if (state.registry[i].events != 0)
         {
             listDestroy(state.registry[i].events);
+            listDestroy(state.registry[i].pending);
             state.registry[i].events = 0;
+            state.registry[i].pending = 0;
+            state.registry[i].listenerCount = 0;
+        }
+#ifdef FORGE_EVENT_STATS_ENABLED
+        if (state.registry[i].stats != 0)
+        {
+            forgeFreeMemory(state.registry[i].stats, sizeof(eventCodeStats), MEMORY_TAG_EVENT);
+            state.registry[i].stats = 0;
         }
+#endif
     }
-    isInitialized = FALSE;
+    listDestroy(state.compactionCodes);
+    listDestroy(state.subscriptions);
+    listDestroy(state.freeSubscriptions);
+    state.compactionCodes = 0;
+    state.subscriptions = 0;
+    state.freeSubscriptions = 0;
+    forgeFreeMemory(state.payloadArenas[0], EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+    forgeFreeMemory(state.payloadArenas[1], EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+    state.payloadArenas[0] = 0;
+    state.payloadArenas[1] = 0;
+    __atomic_store_n(&isInitialized, FALSE, __ATOMIC_RELEASE);
     FORGE_LOG_INFO("Event System Shutdown");
 }
 
+void eventFlush()
+{
+    if (isInitialized == FALSE || state.isFlushing)
+    {
+        return;
+    }
 
-// - - - Game developer functions - - -
+    eventDrainThreadQueues();
 
-bool8 eventRegister(unsigned short CODE,  void* LISTENER, eventCallback CALLBACK)
+#ifdef FORGE_EVENT_STATS_ENABLED
+    if (state.statsDumpInterval > 0)
+    {
+        double now = platformGetTime();
+        if (now - state.lastStatsDump >= state.statsDumpInterval)
+        {
+            state.lastStatsDump = now;
+            eventDumpStats();
+        }
+    }
+#endif
+
+    unsigned int count = state.queueWrite - state.queueRead;
+    if (count == 0)
+    {
+        return;
+    }
+
+    //Counting sort by group: turn the per group counts into offsets into the batch
+    unsigned int offset = 0;
+    for (unsigned int i = 0; i < state.groupCount; ++i)
+    {
+        unsigned int groupCount = state.groupOffsets[i];
+        state.groupOffsets[i] = offset;
+        offset += groupCount;
+    }
+
+    //Scatter the queue. Press and release, motion and clicks keep their post order, only batched codes move up to their first post.
+    //Reset as we go, anything posted by a listener waits for the next flush
+    for (unsigned int i = state.queueRead; i != state.queueWrite; ++i)
+    {
+        queuedEvent* event = &state.queue[i & (EVENT_QUEUE_CAPACITY - 1)];
+        state.batch[state.groupOffsets[event->group]++] = *event;
+        state.registry[event->code].queuedCount = 0;
+    }
+    state.groupCount = 0;
+    state.queueRead = state.queueWrite;
+    state.orderBarrier = state.queueWrite;
+
+    state.isFlushing = TRUE;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        queuedEvent* event = &state.batch[i];
+        eventDispatch(event->code, event->sender, event->context);
+    }
+    state.isFlushing = FALSE;
+}
+
+void eventEndFrame()
 {
     if (isInitialized == FALSE)
     {
-        return FALSE;
+        return;
     }
 
-    if (state.registry[CODE].events == 0)
+    //The arena of the frame before this one has been flushed, it becomes next frame's arena
+    state.payloadFrame++;
+    state.payloadOffset[state.payloadFrame & 1] = 0;
+
+    eventRecorderEndFrame();
+}
+
+
+// - - - Game developer functions - - -
+
+eventHandle eventSubscribe(unsigned short CODE, void* LISTENER, eventCallback CALLBACK, short PRIORITY)
+{
+    if (isInitialized == FALSE || CALLBACK == 0)
     {
-        state.registry[CODE].events = listCreate(registeredEvent);
+        return EVENT_INVALID_HANDLE;
     }
 
-    unsigned long long registeredCount = listLength(state.registry[CODE].events);
-    for (unsigned long long i = 0; i < registeredCount; ++i)
+    eventCodeEntry* entry = &state.registry[CODE];
+    if (entry->events == 0)
     {
-        if (state.registry[CODE].events[i].listener == LISTENER)
-        {
-            // TODO: warn
-            return FALSE;
-        }
+        entry->events = listCreate(registeredEvent);
+        entry->pending = listCreate(registeredEvent);
     }
 
-    //Safe to register
+    unsigned int slot;
+    if (listLength(state.freeSubscriptions) > 0)
+    {
+        listPop(state.freeSubscriptions, &slot);
+    }
+    else
+    {
+        eventSubscription emptySubscription = {};
+        slot = listLength(state.subscriptions);
+        listAppend(state.subscriptions, emptySubscription);
+    }
+
+    //Appending is O(1), the priority ordered insert happens in the next compaction
+    eventSubscription* subscription = &state.subscriptions[slot];
+    subscription->code = CODE;
+    subscription->index = listLength(entry->pending);
+    subscription->isPending = TRUE;
+    subscription->isActive = TRUE;
+#ifdef FORGE_EVENT_STATS_ENABLED
+    forgeZeroMemory(&subscription->stats, sizeof(eventCallbackStats));
+    subscription->listener = LISTENER;
+#endif
+
     registeredEvent event;
     event.listener = LISTENER;
     event.callback = CALLBACK;
-    listAppend(state.registry[CODE].events, event);
+    event.priority = PRIORITY;
+    event.subscription = slot;
+    listAppend(entry->pending, event);
+    entry->listenerCount++;
+    eventMarkForCompaction(CODE);
+
+    return ((unsigned long long) subscription->generation << 32) | (slot + 1);
+}
+
+bool8 eventUnsubscribe(eventHandle HANDLE)
+{
+    if (isInitialized == FALSE)
+    {
+        return FALSE;
+    }
+
+    //Handle zero wraps around to an out of range slot
+    unsigned int slot = (unsigned int) (HANDLE & 0xFFFFFFFF) - 1;
+    if (slot >= listLength(state.subscriptions))
+    {
+        return FALSE;
+    }
 
+    eventSubscription* subscription = &state.subscriptions[slot];
+    if (!subscription->isActive || subscription->generation != (unsigned int) (HANDLE >> 32))
+    {
+        return FALSE;
+    }
+
+    //Leave a hole, a dispatch may be walking this list right now
+    eventCodeEntry* entry = &state.registry[subscription->code];
+    registeredEvent* events = subscription->isPending ? entry->pending : entry->events;
+    events[subscription->index].callback = 0;
+    entry->listenerCount--;
+    eventMarkForCompaction(subscription->code);
+
+    subscription->isActive = FALSE;
+    subscription->generation++;
+    listAppend(state.freeSubscriptions, slot);
     return TRUE;
 }
 
+bool8 eventRegister(unsigned short CODE,  void* LISTENER, eventCallback CALLBACK)
+{
+    if (isInitialized == FALSE)
+    {
+        return FALSE;
+    }
+
+    if (eventFind(CODE, LISTENER, CALLBACK) != EVENT_INVALID_HANDLE)
+    {
+        FORGE_LOG_WARNING("Listener is already registered for event %i", CODE);
+        return FALSE;
+    }
+
+    return eventSubscribe(CODE, LISTENER, CALLBACK, EVENT_PRIORITY_DEFAULT) != EVENT_INVALID_HANDLE;
+}
+
 bool8 eventUnregister(unsigned short CODE, void* LISTENER, eventCallback CALLBACK)
 {
     if (isInitialized == FALSE)
@@ -100,52 +385,658 @@ bool8 eventUnregister(unsigned short CODE, void* LISTENER, eventCallback CALLBAC
         return FALSE;
     }
 
-    if (state.registry[CODE].events == 0)
+    eventHandle handle = eventFind(CODE, LISTENER, CALLBACK);
+    if (handle == EVENT_INVALID_HANDLE)
     {
-        // TODO: warn
+        FORGE_LOG_WARNING("Tried to unregister a listener that is not registered for event %i", CODE);
         return FALSE;
     }
 
-    unsigned long long registeredCount = listLength(state.registry[CODE].events);
+    return eventUnsubscribe(handle);
+}
 
-    for (unsigned long long i = 0; i < registeredCount; ++i)
+bool8 eventTrigger(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+{
+    if (isInitialized == FALSE)
     {
-        registeredEvent event = state.registry[CODE].events[i];
-        if (event.listener == LISTENER && event.callback == CALLBACK)
+        return FALSE;
+    }
+
+    //Events raised by listeners are recreated by the replay itself
+    if (state.dispatchDepth == 0)
+    {
+        eventRecorderCapture(CODE, CONTEXT, FALSE);
+    }
+
+    return eventDispatch(CODE, SENDER, CONTEXT);
+}
+
+bool8 eventPost(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+{
+    if (isInitialized == FALSE)
+    {
+        return FALSE;
+    }
+
+    if (state.dispatchDepth == 0)
+    {
+        eventRecorderCapture(CODE, CONTEXT, TRUE);
+    }
+
+    return eventEnqueue(CODE, SENDER, CONTEXT);
+}
+
+void eventSetCoalescing(unsigned short CODE, eventCoalescePolicy POLICY, eventMergeFunction MERGE)
+{
+    if (isInitialized == FALSE)
+    {
+        return;
+    }
+
+    if (POLICY == EVENT_COALESCE_ACCUMULATE && MERGE == 0)
+    {
+        FORGE_LOG_WARNING("Event %i needs a merge function to accumulate, keeping the last post instead", CODE);
+        POLICY = EVENT_COALESCE_KEEP_LAST;
+    }
+
+    state.registry[CODE].coalescePolicy = POLICY;
+    state.registry[CODE].merge = MERGE;
+}
+
+void eventSetBatching(unsigned short CODE, bool8 IS_BATCHED)
+{
+    if (isInitialized == FALSE)
+    {
+        return;
+    }
+
+    //A code never has events in both kinds of group
+    if (state.registry[CODE].queuedCount > 0)
+    {
+        FORGE_LOG_WARNING("Event %i has posts waiting, change its batching between flushes", CODE);
+        return;
+    }
+    state.registry[CODE].isBatched = IS_BATCHED;
+}
+
+bool8 eventHasListeners(unsigned short CODE)
+{
+    if (isInitialized == FALSE)
+    {
+        return FALSE;
+    }
+    return state.registry[CODE].listenerCount > 0;
+}
+
+void* eventPayloadReserve(unsigned long long SIZE, eventContext* OUT_CONTEXT)
+{
+    if (isInitialized == FALSE)
+    {
+        return 0;
+    }
+
+    unsigned int arena = state.payloadFrame & 1;
+    unsigned long long offset = (state.payloadOffset[arena] + EVENT_PAYLOAD_ALIGNMENT - 1) & ~(unsigned long long) (EVENT_PAYLOAD_ALIGNMENT - 1);
+    //Compared against what is left so a huge SIZE cannot wrap around, the aligned offset never passes the arena's end
+    if (SIZE > EVENT_PAYLOAD_ARENA_SIZE - offset)
+    {
+        FORGE_LOG_WARNING("Event payload arena is full, could not reserve %llu bytes", SIZE);
+        return 0;
+    }
+    state.payloadOffset[arena] = offset + SIZE;
+
+    OUT_CONTEXT->data.u32[0] = (unsigned int) offset;
+    OUT_CONTEXT->data.u32[1] = (unsigned int) SIZE;
+    OUT_CONTEXT->data.u32[2] = state.payloadFrame;
+    OUT_CONTEXT->data.u32[3] = EVENT_PAYLOAD_MAGIC;
+    return state.payloadArenas[arena] + offset;
+}
+
+void* eventPayloadGet(eventContext CONTEXT, unsigned long long* OUT_SIZE)
+{
+    *OUT_SIZE = 0;
+    if (isInitialized == FALSE || CONTEXT.data.u32[3] != EVENT_PAYLOAD_MAGIC)
+    {
+        return 0;
+    }
+
+    //Only this frame's and last frame's arenas are still intact
+    unsigned int frame = CONTEXT.data.u32[2];
+    if (state.payloadFrame - frame > 1)
+    {
+        FORGE_LOG_WARNING("Event payload from frame %u has expired", frame);
+        return 0;
+    }
+
+    *OUT_SIZE = CONTEXT.data.u32[1];
+    return state.payloadArenas[frame & 1] + CONTEXT.data.u32[0];
+}
+
+unsigned int eventAttachThread()
+{
+    unsigned int generation = __atomic_load_n(&systemGeneration, __ATOMIC_ACQUIRE);
+    if (threadGeneration == generation)
+    {
+        return threadSlot;
+    }
+    threadGeneration = generation;
+
+    //Lowest detached slot first, so a fixed attach order still gives a fixed flush order
+    unsigned int freeSlots = __atomic_load_n(&state.freeThreadQueues, __ATOMIC_ACQUIRE);
+    while (freeSlots != 0)
+    {
+        unsigned int slot = (unsigned int) __builtin_ctz(freeSlots);
+        if (__atomic_compare_exchange_n(&state.freeThreadQueues, &freeSlots, freeSlots & ~(1u << slot), FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
         {
-            registeredEvent poppedEvent;
-            listRemove(state.registry[CODE].events, i, &poppedEvent);
-            return TRUE;
+            threadSlot = slot;
+            return threadSlot;
         }
     }
 
-    //Not found
-    return FALSE;
+    unsigned int count = __atomic_load_n(&state.threadQueueCount, __ATOMIC_ACQUIRE);
+    do
+    {
+        if (count >= EVENT_MAX_POSTING_THREADS)
+        {
+            FORGE_LOG_ERROR("Too many threads posting events, the limit is %i", EVENT_MAX_POSTING_THREADS);
+            threadSlot = EVENT_MAX_POSTING_THREADS;
+            return threadSlot;
+        }
+    } while (!__atomic_compare_exchange_n(&state.threadQueueCount, &count, count + 1, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    threadSlot = count;
+    return threadSlot;
 }
 
-bool8 eventTrigger(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+void eventDetachThread()
 {
-    if (isInitialized == FALSE)
+    unsigned int generation = __atomic_load_n(&systemGeneration, __ATOMIC_ACQUIRE);
+    if (threadGeneration != generation)
+    {
+        //Never attached to this run, or its slot went away with the last shutdown
+        threadGeneration = 0;
+        return;
+    }
+    threadGeneration = 0;
+    if (threadSlot >= EVENT_MAX_POSTING_THREADS)
+    {
+        return;
+    }
+
+    //Everything posted so far is still delivered, the main thread frees the slot after draining it
+    __atomic_store_n(&state.threadQueues[threadSlot].isDetaching, TRUE, __ATOMIC_RELEASE);
+}
+
+bool8 eventPostFromThread(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+{
+    if (__atomic_load_n(&isInitialized, __ATOMIC_ACQUIRE) == FALSE)
+    {
+        return FALSE;
+    }
+
+    unsigned int slot = eventAttachThread();
+    if (slot >= EVENT_MAX_POSTING_THREADS)
     {
         return FALSE;
     }
 
+    eventThreadQueue* queue = &state.threadQueues[slot];
+    unsigned int write = queue->write;
+    if (write - __atomic_load_n(&queue->read, __ATOMIC_ACQUIRE) >= EVENT_THREAD_QUEUE_CAPACITY)
+    {
+        //Full until the next flush, the caller decides whether to retry
+        return FALSE;
+    }
+
+    queuedEvent* event = &queue->events[write & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+    event->code = CODE;
+    event->sender = SENDER;
+    event->context = CONTEXT;
+
+    //Publish the event to the main thread
+    __atomic_store_n(&queue->write, write + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+
+// - - - Queueing - - -
+
+bool8 eventEnqueue(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+{
+    eventCodeEntry* entry = &state.registry[CODE];
+#ifdef FORGE_EVENT_STATS_ENABLED
+    eventStatsForCode(CODE)->posted++;
+#endif
+
+    //Fold into the newest queued event of this code from the same sender, unless an ordered event went out after it
+    bool8 isBehindBarrier = entry->lastQueued - state.queueRead < state.orderBarrier - state.queueRead;
+    if (entry->coalescePolicy != EVENT_COALESCE_KEEP_ALL && entry->queuedCount > 0 && (entry->isBatched || !isBehindBarrier))
+    {
+        queuedEvent* last = &state.queue[entry->lastQueued & (EVENT_QUEUE_CAPACITY - 1)];
+        if (last->sender == SENDER)
+        {
+            if (entry->coalescePolicy == EVENT_COALESCE_ACCUMULATE)
+            {
+                entry->merge(&last->context, CONTEXT);
+            }
+            else
+            {
+                last->context = CONTEXT;
+            }
+#ifdef FORGE_EVENT_STATS_ENABLED
+            entry->stats->coalesced++;
+#endif
+            return TRUE;
+        }
+    }
+
+    if (state.queueWrite - state.queueRead >= EVENT_QUEUE_CAPACITY)
+    {
+        //Never drop an event, deliver it the old way instead
+        FORGE_LOG_WARNING("Event queue is full, triggering event %i immediately", CODE);
+        return eventDispatch(CODE, SENDER, CONTEXT);
+    }
+
+    queuedEvent* event = &state.queue[state.queueWrite & (EVENT_QUEUE_CAPACITY - 1)];
+    event->code = CODE;
+    event->sender = SENDER;
+    event->context = CONTEXT;
+    entry->lastQueued = state.queueWrite;
+    state.queueWrite++;
+
+    if (!entry->isBatched || entry->queuedCount == 0)
+    {
+        entry->queuedGroup = (unsigned short) state.groupCount;
+        state.groupOffsets[state.groupCount++] = 0;
+    }
+    event->group = entry->queuedGroup;
+    state.groupOffsets[event->group]++;
+    entry->queuedCount++;
+
+    if (!entry->isBatched && entry->coalescePolicy == EVENT_COALESCE_KEEP_ALL)
+    {
+        state.orderBarrier = state.queueWrite;
+    }
+    return TRUE;
+}
+
+
+// - - - Dispatch - - -
+
+void eventDrainThreadQueues()
+{
+    unsigned int threadCount = __atomic_load_n(&state.threadQueueCount, __ATOMIC_ACQUIRE);
+    if (threadCount > EVENT_MAX_POSTING_THREADS)
+    {
+        threadCount = EVENT_MAX_POSTING_THREADS;
+    }
+
+    //Slot order then post order, so the result does not depend on thread timing
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        eventThreadQueue* queue = &state.threadQueues[i];
+        //Read before the write index, the owner posts nothing after it asks to detach
+        bool8 isDetaching = __atomic_load_n(&queue->isDetaching, __ATOMIC_ACQUIRE);
+        unsigned int read = queue->read;
+        unsigned int write = __atomic_load_n(&queue->write, __ATOMIC_ACQUIRE);
+        for (; read != write; ++read)
+        {
+            queuedEvent* event = &queue->events[read & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+            eventEnqueue(event->code, event->sender, event->context);
+        }
+
+        //Hand the slots back to the producer
+        __atomic_store_n(&queue->read, read, __ATOMIC_RELEASE);
+
+        if (isDetaching)
+        {
+            queue->isDetaching = FALSE;
+            __atomic_or_fetch(&state.freeThreadQueues, 1u << i, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+
+// - - - Dispatch - - -
+
+bool8 eventDispatch(unsigned short CODE, void* SENDER, eventContext CONTEXT)
+{
+#ifdef FORGE_EVENT_STATS_ENABLED
+    eventCodeStats* stats = eventStatsForCode(CODE);
+    stats->triggered++;
+#endif
+
     if (state.registry[CODE].events == 0)
     {
+#ifdef FORGE_EVENT_STATS_ENABLED
+        stats->unhandled++;
+#endif
         return FALSE;
     }
 
+    //Bring in new subscriptions and drop old ones, unless an outer dispatch is walking this code's list
+    if (state.registry[CODE].dispatchDepth == 0 && state.registry[CODE].needsCompaction)
+    {
+        eventCompactCode(CODE);
+    }
+
+    bool8 handled = FALSE;
+    state.dispatchDepth++;
+    state.registry[CODE].dispatchDepth++;
+
+    //Listeners registered by a callback are not called until the next dispatch
     unsigned long long registeredCount = listLength(state.registry[CODE].events);
     for (unsigned long long i = 0; i < registeredCount; ++i)
     {
+        //The list may have been reallocated by a callback, always index it fresh
         registeredEvent event = state.registry[CODE].events[i];
-        if (event.callback(CODE, SENDER, event.listener, CONTEXT))
+        if (event.callback == 0)
+        {
+            //Unregistered during this dispatch
+            continue;
+        }
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+        unsigned long long callbackStart = platformGetTicks();
+        handled = event.callback(CODE, SENDER, event.listener, CONTEXT);
+        double elapsed = clockTicksToSeconds(platformGetTicks() - callbackStart);
+        stats->callbackTime += elapsed;
+        eventRecordCallback(event.subscription, elapsed);
+#else
+        handled = event.callback(CODE, SENDER, event.listener, CONTEXT);
+#endif
+
+        if (handled)
         {
             //Message has been handled, no need to send for other listeners
-            return TRUE;
+            break;
         }
     }
-    
-    //Not found
-    return FALSE;
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+    if (handled)
+    {
+        stats->handled++;
+    }
+    else
+    {
+        stats->unhandled++;
+    }
+#endif
+
+    state.registry[CODE].dispatchDepth--;
+    state.dispatchDepth--;
+    if (state.dispatchDepth == 0 && listLength(state.compactionCodes) > 0)
+    {
+        eventCompact();
+    }
+    return handled;
+}
+
+
+// - - - Registry Maintenance - - -
+
+void eventMarkForCompaction(unsigned short CODE)
+{
+    if (!state.registry[CODE].needsCompaction)
+    {
+        state.registry[CODE].needsCompaction = TRUE;
+        listAppend(state.compactionCodes, CODE);
+    }
 }
+
+void eventCompactCode(unsigned short CODE)
+{
+    eventCodeEntry* entry = &state.registry[CODE];
+
+    //Drop the holes left by unsubscribing
+    unsigned long long registeredCount = listLength(entry->events);
+    unsigned long long kept = 0;
+    for (unsigned long long i = 0; i < registeredCount; ++i)
+    {
+        if (entry->events[i].callback != 0)
+        {
+            entry->events[kept++] = entry->events[i];
+        }
+    }
+
+    unsigned long long pendingCount = listLength(entry->pending);
+    unsigned long long added = 0;
+    for (unsigned long long i = 0; i < pendingCount; ++i)
+    {
+        if (entry->pending[i].callback != 0)
+        {
+            entry->pending[added++] = entry->pending[i];
+        }
+    }
+
+    //Stable insertion sort of the new subscriptions, usually only a handful
+    for (unsigned long long i = 1; i < added; ++i)
+    {
+        registeredEvent event = entry->pending[i];
+        unsigned long long j = i;
+        while (j > 0 && entry->pending[j - 1].priority < event.priority)
+        {
+            entry->pending[j] = entry->pending[j - 1];
+            --j;
+        }
+        entry->pending[j] = event;
+    }
+
+    //Grow the list, then merge from the back. Equal priorities keep registration order
+    listLengthSet(entry->events, kept);
+    for (unsigned long long i = 0; i < added; ++i)
+    {
+        listAppend(entry->events, entry->pending[i]);
+    }
+    long long read = (long long) kept - 1;
+    long long pendingRead = (long long) added - 1;
+    long long write = (long long) (kept + added) - 1;
+    while (pendingRead >= 0)
+    {
+        if (read >= 0 && entry->events[read].priority < entry->pending[pendingRead].priority)
+        {
+            entry->events[write--] = entry->events[read--];
+        }
+        else
+        {
+            entry->events[write--] = entry->pending[pendingRead--];
+        }
+    }
+    listClear(entry->pending);
+
+    //Point the handles at their new positions
+    registeredCount = kept + added;
+    for (unsigned long long i = 0; i < registeredCount; ++i)
+    {
+        eventSubscription* subscription = &state.subscriptions[entry->events[i].subscription];
+        subscription->index = i;
+        subscription->isPending = FALSE;
+    }
+    entry->needsCompaction = FALSE;
+}
+
+void eventCompact()
+{
+    unsigned long long codeCount = listLength(state.compactionCodes);
+    for (unsigned long long i = 0; i < codeCount; ++i)
+    {
+        unsigned short code = state.compactionCodes[i];
+        if (state.registry[code].needsCompaction)
+        {
+            eventCompactCode(code);
+        }
+    }
+    listClear(state.compactionCodes);
+}
+
+eventHandle eventFind(unsigned short CODE, void* LISTENER, eventCallback CALLBACK)
+{
+    eventCodeEntry* entry = &state.registry[CODE];
+    if (entry->events == 0)
+    {
+        return EVENT_INVALID_HANDLE;
+    }
+
+    registeredEvent* lists[2] = {entry->events, entry->pending};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        unsigned long long registeredCount = listLength(lists[i]);
+        for (unsigned long long j = 0; j < registeredCount; ++j)
+        {
+            registeredEvent* event = &lists[i][j];
+            if (event->callback == CALLBACK && event->listener == LISTENER)
+            {
+                unsigned int generation = state.subscriptions[event->subscription].generation;
+                return ((unsigned long long) generation << 32) | (event->subscription + 1);
+            }
+        }
+    }
+    return EVENT_INVALID_HANDLE;
+}
+
+
+// - - - | Statistics | - - -
+
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+
+eventCodeStats* eventStatsForCode(unsigned short CODE)
+{
+    if (state.registry[CODE].stats == 0)
+    {
+        state.registry[CODE].stats = forgeAllocateMemory(sizeof(eventCodeStats), MEMORY_TAG_EVENT);
+    }
+    return state.registry[CODE].stats;
+}
+
+void eventRecordCallback(unsigned int SUBSCRIPTION, double ELAPSED)
+{
+    eventCallbackStats* stats = &state.subscriptions[SUBSCRIPTION].stats;
+    stats->calls++;
+    stats->totalTime += ELAPSED;
+    if (ELAPSED > stats->maxTime)
+    {
+        stats->maxTime = ELAPSED;
+    }
+
+    //Log2 buckets in microseconds
+    unsigned long long microseconds = (unsigned long long) (ELAPSED * 1000000.0);
+    unsigned int bucket = 0;
+    while (bucket < EVENT_LATENCY_BUCKETS - 1 && microseconds >= (1ULL << bucket))
+    {
+        ++bucket;
+    }
+    stats->latency[bucket]++;
+}
+
+bool8 eventGetCodeStats(unsigned short CODE, eventCodeStats* OUT_STATS)
+{
+    if (isInitialized == FALSE || state.registry[CODE].stats == 0)
+    {
+        forgeZeroMemory(OUT_STATS, sizeof(eventCodeStats));
+        return FALSE;
+    }
+    *OUT_STATS = *state.registry[CODE].stats;
+    return TRUE;
+}
+
+bool8 eventGetCallbackStats(eventHandle HANDLE, eventCallbackStats* OUT_STATS)
+{
+    unsigned int slot = (unsigned int) (HANDLE & 0xFFFFFFFF) - 1;
+    if (isInitialized == FALSE || slot >= listLength(state.subscriptions))
+    {
+        return FALSE;
+    }
+
+    eventSubscription* subscription = &state.subscriptions[slot];
+    if (!subscription->isActive || subscription->generation != (unsigned int) (HANDLE >> 32))
+    {
+        return FALSE;
+    }
+    *OUT_STATS = subscription->stats;
+    return TRUE;
+}
+
+void eventResetStats()
+{
+    if (isInitialized == FALSE)
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < MAX_MESSAGE_CODES; ++i)
+    {
+        if (state.registry[i].stats != 0)
+        {
+            forgeZeroMemory(state.registry[i].stats, sizeof(eventCodeStats));
+        }
+    }
+
+    unsigned long long subscriptionCount = listLength(state.subscriptions);
+    for (unsigned long long i = 0; i < subscriptionCount; ++i)
+    {
+        forgeZeroMemory(&state.subscriptions[i].stats, sizeof(eventCallbackStats));
+    }
+}
+
+void eventDumpStats()
+{
+    if (isInitialized == FALSE)
+    {
+        return;
+    }
+
+    FORGE_LOG_DEBUG("Event statistics:");
+    for (unsigned int i = 0; i < MAX_MESSAGE_CODES; ++i)
+    {
+        eventCodeStats* stats = state.registry[i].stats;
+        if (stats == 0 || (stats->triggered == 0 && stats->posted == 0))
+        {
+            continue;
+        }
+
+        double handledPercent = stats->triggered ? 100.0 * stats->handled / stats->triggered : 0.0;
+        FORGE_LOG_DEBUG("  Event 0x%04x: %llu dispatched, %.1f%% handled, %llu posted, %llu coalesced, %.3f ms in listeners",
+                        i, stats->triggered, handledPercent, stats->posted, stats->coalesced, stats->callbackTime * 1000.0);
+
+        //Every live listener of this code
+        unsigned long long subscriptionCount = listLength(state.subscriptions);
+        for (unsigned long long j = 0; j < subscriptionCount; ++j)
+        {
+            eventSubscription* subscription = &state.subscriptions[j];
+            if (!subscription->isActive || subscription->code != i || subscription->stats.calls == 0)
+            {
+                continue;
+            }
+
+            //Upper bound of the bucket holding the 99th percentile call
+            unsigned long long target = subscription->stats.calls - subscription->stats.calls / 100;
+            unsigned long long seen = 0;
+            unsigned int bucket = 0;
+            for (; bucket < EVENT_LATENCY_BUCKETS - 1; ++bucket)
+            {
+                seen += subscription->stats.latency[bucket];
+                if (seen >= target)
+                {
+                    break;
+                }
+            }
+
+            FORGE_LOG_DEBUG("    listener %p: %llu calls, %.2f us average, p99 < %llu us, %.2f us max",
+                            subscription->listener,
+                            subscription->stats.calls,
+                            subscription->stats.totalTime * 1000000.0 / subscription->stats.calls,
+                            1ULL << bucket,
+                            subscription->stats.maxTime * 1000000.0);
+        }
+    }
+}
+
+void eventSetStatsDumpInterval(double SECONDS)
+{
+    state.statsDumpInterval = SECONDS;
+    state.lastStatsDump = platformGetTime();
+}
+
+#endif
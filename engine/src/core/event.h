@@ -36,14 +36,17 @@ typedef enum systemEventCode
     */
     EVENT_CODE_MOUSE_MOVE = 0x06,
     /*
-      The mouse moved
+      The mouse moved. Consecutive moves are coalesced into one event with the deltas summed, a click, key or raw
+      sample posted in between starts a new one so motion stays in order with them
       Context: unsigned short x = CONTEXT.data.u16[0] : X position
                unsigned short y = CONTEXT.data.u16[1] : Y position
+               short dx = CONTEXT.data.i16[2] : X movement
+               short dy = CONTEXT.data.i16[3] : Y movement
     */
     EVENT_CODE_MOUSE_WHEEL = 0x07,
     /*
-      The mouse wheel moved. -1 is down, 1 is up
-      Context: unsigned short delta = CONTEXT.data.u18[0] : Wheel delta
+      The mouse wheel moved. -1 is down, 1 is up. Consecutive wheel steps are coalesced with the summed delta
+      Context: char delta = CONTEXT.data.i8[0] : Wheel delta
     */
     EVENT_CODE_RESIZE = 0x08,
     /*
@@ -56,6 +59,33 @@ typedef enum systemEventCode
       Request for memory statistics
       Context: None required
     */
+    EVENT_CODE_MOUSE_MOVE_RAW = 0x0A,
+    /*
+      Every mouse motion sample, only sent while something listens for it
+      Context: same as EVENT_CODE_MOUSE_MOVE, the deltas are for this sample only
+    */
+    EVENT_CODE_MOUSE_WHEEL_RAW = 0x0B,
+    /*
+      Every mouse wheel sample, only sent while something listens for it
+      Context: same as EVENT_CODE_MOUSE_WHEEL
+    */
+    EVENT_CODE_GAMEPAD_BUTTON_PRESS = 0x0C,
+    /*
+      Gamepad button pressed
+      Context: unsigned short button = CONTEXT.data.u16[0] : Gamepad button
+               unsigned short pad = CONTEXT.data.u16[1] : Gamepad index
+    */
+    EVENT_CODE_GAMEPAD_BUTTON_RELEASE = 0x0D,
+    /*
+      Gamepad button released
+      Context: same as EVENT_CODE_GAMEPAD_BUTTON_PRESS
+    */
+    EVENT_CODE_GAMEPAD_CONNECTION = 0x0E,
+    /*
+      Gamepad plugged in or removed
+      Context: unsigned short pad = CONTEXT.data.u16[0] : Gamepad index
+               unsigned short connected = CONTEXT.data.u16[1] : 1 when connected, 0 when removed
+    */
     MAX_SYSTEM_EVENT_CODE = 0xFF
 } systemEventCode;
 
@@ -92,6 +122,51 @@ typedef struct eventContext
 // Return true to stop the event from being passed to other listeners and if you handled the event
 typedef bool8 (*eventCallback)(unsigned short CODE, void* SENDER, void* LISTENER, eventContext CONTEXT);
 
+// - - - Coalescing
+typedef enum eventCoalescePolicy
+{
+    EVENT_COALESCE_KEEP_ALL, //Every post is dispatched, the default
+    EVENT_COALESCE_KEEP_LAST, //Only the newest post per sender is dispatched each flush
+    EVENT_COALESCE_ACCUMULATE //Posts per sender are folded together with a merge function
+} eventCoalescePolicy;
+
+// Fold INCOMING into the already queued context
+typedef void (*eventMergeFunction)(eventContext* QUEUED, eventContext INCOMING);
+
+// - - - Statistics enable toggle, compiled out of release builds
+#if FORGE_RELEASE != 1
+#define FORGE_EVENT_STATS_ENABLED
+#endif
+
+#define EVENT_LATENCY_BUCKETS 16
+
+typedef struct eventCodeStats
+{
+    unsigned long long triggered; //Dispatches, posted or triggered
+    unsigned long long handled; //Dispatches a listener returned true for
+    unsigned long long unhandled;
+    unsigned long long posted;
+    unsigned long long coalesced; //Posts folded into an already queued event
+    double callbackTime; //Seconds spent inside listeners
+} eventCodeStats;
+
+typedef struct eventCallbackStats
+{
+    unsigned long long calls;
+    double totalTime;
+    double maxTime;
+    unsigned long long latency[EVENT_LATENCY_BUCKETS]; //Bucket i counts calls under 2^i microseconds, the last one also counts everything slower
+} eventCallbackStats;
+
+// - - - Subscription handle
+// Opaque, zero is never a valid handle
+typedef unsigned long long eventHandle;
+
+#define EVENT_INVALID_HANDLE 0
+
+// Higher priorities are called first, equal priorities in registration order
+#define EVENT_PRIORITY_DEFAULT 0
+
 
 // - - - | Event System functions | - - -
 
@@ -102,13 +177,91 @@ bool8 eventInitialize();
 
 void eventShutdown();
 
+// Dispatch every event posted since the last flush in post order, the events of a batched code together at its first post. Called once per frame by the application
+void eventFlush();
+
+// Free the payloads reserved during the previous frame in bulk. Called once at the end of every frame
+void eventEndFrame();
+
 
 // - - - Game developer functions - - -
 
-// Register to listen for events. Events with duplicate listener/callback pairs will be ignored and returned as false
+// Registration, triggering and eventPost are main thread only. Listeners may register and unregister from inside a callback
+
+// Subscribe to an event and get a handle back for unsubscribing. No duplicate check, subscribing twice calls twice.
+// The subscription takes part in dispatches from the next top level trigger or flush onwards
+FORGE_API eventHandle eventSubscribe(unsigned short CODE, void* LISTENER, eventCallback CALLBACK, short PRIORITY);
+
+// O(1) unsubscribe, the listener list is compacted after the current dispatch. Stale handles return false
+FORGE_API bool8 eventUnsubscribe(eventHandle HANDLE);
+
+// Register to listen for events at the default priority. Events with duplicate listener/callback pairs will be ignored and returned as false
 FORGE_API bool8 eventRegister(unsigned short CODE, void* LISTENER, eventCallback CALLBACK);
 
-// Unregister to listen for events. Events with duplicate listener/callback pairs will be ignored and returned as false
+// Unregister to listen for events. Searches for the listener/callback pair, prefer eventUnsubscribe with a handle
 FORGE_API bool8 eventUnregister(unsigned short CODE, void* LISTENER, eventCallback CALLBACK);
 
+// Call every listener of the event right now, at the call site
 FORGE_API bool8 eventTrigger(unsigned short CODE, void* SENDER, eventContext CONTEXT);
+
+// Queue the event for the next eventFlush. Only the code, sender and context are copied, no listener is called here
+FORGE_API bool8 eventPost(unsigned short CODE, void* SENDER, eventContext CONTEXT);
+
+// How posts of this code are combined before the next flush. Does not affect eventTrigger. A post is only folded into an
+// earlier one when no keep all event of an unbatched code was posted in between
+FORGE_API void eventSetCoalescing(unsigned short CODE, eventCoalescePolicy POLICY, eventMergeFunction MERGE);
+
+// For codes whose listeners do not care when they run relative to other codes, physics contacts for example. A batched code's
+// events are dispatched back to back at its first post, keeping their order among themselves. Off by default, input stays in post order
+FORGE_API void eventSetBatching(unsigned short CODE, bool8 IS_BATCHED);
+
+// True if anything is subscribed, lets producers skip building events nobody wants
+FORGE_API bool8 eventHasListeners(unsigned short CODE);
+
+
+// - - - Payload functions - - -
+
+// For data that does not fit in a context. Reserve SIZE bytes from the frame arena, write the payload into them and send the event with the context that was filled in.
+// The payload stays valid until the end of the frame after this one, long enough for a posted event to be flushed. Returns zero if the arena is full
+FORGE_API void* eventPayloadReserve(unsigned long long SIZE, eventContext* OUT_CONTEXT);
+
+// Read a payload in place. Returns zero if the context carries no payload or the payload has expired
+FORGE_API void* eventPayloadGet(eventContext CONTEXT, unsigned long long* OUT_SIZE);
+
+
+// - - - Worker thread functions - - -
+
+// Claim this thread's posting queue. Optional, posting claims one on first use. Threads attached in a fixed order get a fixed flush order.
+// A queue belongs to its thread until eventDetachThread or the next eventShutdown, a thread that exits without detaching keeps its slot
+FORGE_API unsigned int eventAttachThread();
+
+// Give this thread's posting queue back before the thread exits. Events it already posted are still delivered at the next flush, after which the slot can be claimed by another thread.
+// Posting again from this thread claims a new slot
+FORGE_API void eventDetachThread();
+
+// Lock free post from any thread. Dispatched on the main thread at the next eventFlush, after the thread queues are drained in slot order.
+// Returns false if the engine is not running or this thread's queue is full until the next flush
+FORGE_API bool8 eventPostFromThread(unsigned short CODE, void* SENDER, eventContext CONTEXT);
+
+
+// - - - Statistics functions - - -
+
+#ifdef FORGE_EVENT_STATS_ENABLED
+FORGE_API bool8 eventGetCodeStats(unsigned short CODE, eventCodeStats* OUT_STATS);
+
+FORGE_API bool8 eventGetCallbackStats(eventHandle HANDLE, eventCallbackStats* OUT_STATS);
+
+FORGE_API void eventResetStats();
+
+// Log every code that has seen traffic and every callback that has been called
+FORGE_API void eventDumpStats();
+
+// Dump from eventFlush every SECONDS, zero turns it off
+FORGE_API void eventSetStatsDumpInterval(double SECONDS);
+#else
+#define eventGetCodeStats(CODE, OUT_STATS) FALSE //Does nothing at all
+#define eventGetCallbackStats(HANDLE, OUT_STATS) FALSE //Does nothing at all
+#define eventResetStats() //Does nothing at all
+#define eventDumpStats() //Does nothing at all
+#define eventSetStatsDumpInterval(SECONDS) //Does nothing at all
+#endif
@@ -0,0 +1,391 @@
+#include "core/event_recorder.h"
+#include "core/event.h"
+#include "core/input.h"
+#include "core/logger.h"
+#include "core/memory.h"
+#include "platform/platform.h"
+#include "platform/async_io.h"
+
+#include <string.h>
+
+
+// - - - | Recorder State | - - -
+
+
+#define EVENT_RECORDING_VERSION 1
+#define EVENT_RECORDING_BUFFER_SIZE (64 * 1024)
+#define EVENT_RECORDING_BUFFER_COUNT 2 //One fills while the other is written
+#define EVENT_RECORDING_HEADER_SIZE 8
+
+typedef struct eventRecord
+{
+    unsigned int frame;
+    unsigned short code;
+    unsigned char flags;
+    unsigned char reserved;
+    unsigned long long timestamp;
+    eventContext context;
+} eventRecord;
+
+STATIC_ASSERT(sizeof(eventRecord) == 32, "eventRecord is not 32 bytes");
+
+typedef struct eventRecorderState
+{
+    unsigned int frame;
+
+    //Recording, records collect in a buffer that is written out asynchronously once full
+    asyncIoFile file;
+    unsigned char* buffers[EVENT_RECORDING_BUFFER_COUNT];
+    asyncIoTicket writes[EVENT_RECORDING_BUFFER_COUNT]; //Write in flight from each buffer
+    unsigned int buffer; //Filling this one
+    unsigned int bufferUsed;
+    unsigned long long fileOffset; //Where the current buffer goes in the file
+    unsigned long long startTicks;
+    bool8 inPlatformMessages;
+    unsigned long long recordCount;
+
+    //Replay, the whole file is read in up front so replaying never touches the disk
+    memoryFileView replayView;
+    const unsigned char* replayData; //Past the header
+    unsigned long long replaySize;
+    unsigned long long replayCursor;
+} eventRecorderState;
+
+static bool8 isRecording = FALSE;
+static bool8 isReplaying = FALSE;
+static eventRecorderState state;
+
+// - - - Helpers
+void eventRecorderWrite(const void* DATA, unsigned long long SIZE);
+bool8 eventRecorderWriteBuffer();
+bool8 eventRecorderWaitBuffer(unsigned int BUFFER);
+
+
+// - - - | Recorder Functions | - - -
+
+
+// - - - Game engine functions - - -
+
+bool8 eventRecorderStart(const char* PATH)
+{
+    if (isRecording || isReplaying)
+    {
+        FORGE_LOG_ERROR("Cannot record events while already recording or replaying");
+        return FALSE;
+    }
+
+    forgeZeroMemory(&state, sizeof(state));
+    state.file = asyncIoOpen(PATH, ASYNC_IO_OPEN_WRITE);
+    if (state.file == ASYNC_IO_INVALID_FILE)
+    {
+        FORGE_LOG_ERROR("Failed to open event recording %s", PATH);
+        return FALSE;
+    }
+
+    //Batch the small record writes into big ones
+    for (unsigned int i = 0; i < EVENT_RECORDING_BUFFER_COUNT; ++i)
+    {
+        state.buffers[i] = forgeAllocateMemory(EVENT_RECORDING_BUFFER_SIZE, MEMORY_TAG_EVENT);
+    }
+
+    unsigned int version = EVENT_RECORDING_VERSION;
+    isRecording = TRUE;
+    eventRecorderWrite("FEVR", 4);
+    eventRecorderWrite(&version, sizeof(version));
+
+    state.startTicks = platformGetTicks();
+    FORGE_LOG_INFO("Recording events to %s", PATH);
+    return TRUE;
+}
+
+void eventRecorderStop()
+{
+    if (!isRecording)
+    {
+        return;
+    }
+
+    //The buffers stay alive until the kernel is done with them
+    eventRecorderWriteBuffer();
+    for (unsigned int i = 0; i < EVENT_RECORDING_BUFFER_COUNT; ++i)
+    {
+        eventRecorderWaitBuffer(i);
+        forgeFreeMemory(state.buffers[i], EVENT_RECORDING_BUFFER_SIZE, MEMORY_TAG_EVENT);
+        state.buffers[i] = 0;
+    }
+    asyncIoClose(state.file);
+    state.file = ASYNC_IO_INVALID_FILE;
+    isRecording = FALSE;
+    FORGE_LOG_INFO("Recorded %llu events over %u frames", state.recordCount, state.frame);
+}
+
+void eventRecorderBeginPlatformMessages()
+{
+    state.inPlatformMessages = TRUE;
+}
+
+void eventRecorderEndPlatformMessages()
+{
+    state.inPlatformMessages = FALSE;
+}
+
+void eventRecorderCapture(unsigned short CODE, eventContext CONTEXT, bool8 POSTED)
+{
+    if (!isRecording)
+    {
+        return;
+    }
+
+    eventRecord record;
+    record.frame = state.frame;
+    record.code = CODE;
+    record.flags = 0;
+    record.reserved = 0;
+    record.timestamp = platformGetTicks() - state.startTicks;
+    record.context = CONTEXT;
+
+    if (POSTED)
+    {
+        record.flags |= EVENT_RECORD_FLAG_POSTED;
+    }
+    if (state.inPlatformMessages)
+    {
+        record.flags |= EVENT_RECORD_FLAG_PLATFORM;
+    }
+
+    //Payload handles mean nothing in another run, store the bytes instead
+    unsigned long long payloadSize = 0;
+    void* payload = eventPayloadGet(CONTEXT, &payloadSize);
+    if (payload)
+    {
+        record.flags |= EVENT_RECORD_FLAG_PAYLOAD;
+    }
+
+    eventRecorderWrite(&record, sizeof(record));
+    if (payload)
+    {
+        eventRecorderWrite(payload, payloadSize);
+    }
+    state.recordCount++;
+}
+
+void eventRecorderEndFrame()
+{
+    state.frame++;
+}
+
+
+// - - - Replay functions - - -
+
+bool8 eventReplayStart(const char* PATH)
+{
+    if (isRecording || isReplaying)
+    {
+        FORGE_LOG_ERROR("Cannot replay events while already recording or replaying");
+        return FALSE;
+    }
+
+    forgeZeroMemory(&state, sizeof(state));
+    if (!forgeMapFile(PATH, MEMORY_MAP_POPULATE, &state.replayView))
+    {
+        FORGE_LOG_ERROR("Failed to open event recording %s", PATH);
+        return FALSE;
+    }
+
+    const unsigned char* data = state.replayView.data;
+    unsigned int version = 0;
+    if (state.replayView.size >= EVENT_RECORDING_HEADER_SIZE)
+    {
+        memcpy(&version, data + 4, sizeof(version));
+    }
+    if (state.replayView.size < EVENT_RECORDING_HEADER_SIZE || memcmp(data, "FEVR", 4) != 0 || version != EVENT_RECORDING_VERSION)
+    {
+        FORGE_LOG_ERROR("%s is not an event recording this engine can replay", PATH);
+        forgeUnmapFile(&state.replayView);
+        return FALSE;
+    }
+
+    state.replayData = data + EVENT_RECORDING_HEADER_SIZE;
+    state.replaySize = state.replayView.size - EVENT_RECORDING_HEADER_SIZE;
+
+    isReplaying = TRUE;
+    FORGE_LOG_INFO("Replaying events from %s", PATH);
+    return TRUE;
+}
+
+void eventReplayStop()
+{
+    if (!isReplaying)
+    {
+        return;
+    }
+
+    forgeUnmapFile(&state.replayView);
+    state.replayData = 0;
+    isReplaying = FALSE;
+}
+
+bool8 eventReplayIsActive()
+{
+    return isReplaying;
+}
+
+bool8 eventReplayGiveMessages()
+{
+    if (!isReplaying)
+    {
+        return FALSE;
+    }
+
+    while (state.replayCursor + sizeof(eventRecord) <= state.replaySize)
+    {
+        //Payloads leave records unaligned, copy each one out
+        eventRecord record;
+        forgeCopyMemory(&record, state.replayData + state.replayCursor, sizeof(record));
+        if (record.frame > state.frame)
+        {
+            //Belongs to a later frame
+            return TRUE;
+        }
+
+        eventContext context = record.context;
+        state.replayCursor += sizeof(eventRecord);
+        if (record.flags & EVENT_RECORD_FLAG_PAYLOAD)
+        {
+            unsigned long long payloadSize = record.context.data.u32[1];
+            if (payloadSize > state.replaySize - state.replayCursor)
+            {
+                FORGE_LOG_ERROR("Event recording is cut short, a payload runs past its end");
+                return FALSE;
+            }
+            void* payload = eventPayloadReserve(payloadSize, &context);
+            if (payload)
+            {
+                forgeCopyMemory(payload, state.replayData + state.replayCursor, payloadSize);
+            }
+            else
+            {
+                //The recorded offset would point into whatever this run put in the arena, send it without a payload
+                FORGE_LOG_WARNING("Replayed event %i lost its %llu byte payload, the payload arena is full", record.code, payloadSize);
+                context.data.u32[0] = 0;
+                context.data.u32[1] = 0;
+                context.data.u32[2] = 0;
+                context.data.u32[3] = 0;
+            }
+            state.replayCursor += payloadSize;
+        }
+
+        //Everything else was raised by the engine or the game in response to these
+        if (!(record.flags & EVENT_RECORD_FLAG_PLATFORM))
+        {
+            continue;
+        }
+
+        //Input goes back through the input system so its state matches the recorded run
+        switch (record.code)
+        {
+            case EVENT_CODE_KEY_PRESS:
+            case EVENT_CODE_KEY_RELEASE:
+                inputProcessKey(context.data.u16[0], record.code == EVENT_CODE_KEY_PRESS);
+                break;
+
+            case EVENT_CODE_BUTTON_PRESS:
+            case EVENT_CODE_BUTTON_RELEASE:
+                inputProcessButton(context.data.u16[0], record.code == EVENT_CODE_BUTTON_PRESS);
+                break;
+
+            case EVENT_CODE_MOUSE_MOVE:
+                inputProcessMouseMovement(context.data.u16[0], context.data.u16[1]);
+                break;
+
+            case EVENT_CODE_MOUSE_WHEEL:
+                inputProcessMouseWheel(context.data.i8[0]);
+                break;
+
+            case EVENT_CODE_GAMEPAD_BUTTON_PRESS:
+            case EVENT_CODE_GAMEPAD_BUTTON_RELEASE:
+                inputProcessGamepadButton(context.data.u16[1], context.data.u16[0], record.code == EVENT_CODE_GAMEPAD_BUTTON_PRESS);
+                break;
+
+            case EVENT_CODE_GAMEPAD_CONNECTION:
+                inputProcessGamepadConnection(context.data.u16[0], context.data.u16[1]);
+                break;
+
+            case EVENT_CODE_MOUSE_MOVE_RAW:
+            case EVENT_CODE_MOUSE_WHEEL_RAW:
+                //The input system raises these again by itself
+                break;
+
+            default:
+                if (record.flags & EVENT_RECORD_FLAG_POSTED)
+                {
+                    eventPost(record.code, 0, context);
+                }
+                else
+                {
+                    eventTrigger(record.code, 0, context);
+                }
+                break;
+        }
+    }
+
+    FORGE_LOG_INFO("Event replay finished after %u frames", state.frame + 1);
+    return FALSE;
+}
+
+
+// - - - Recording Buffers - - -
+
+void eventRecorderWrite(const void* DATA, unsigned long long SIZE)
+{
+    const unsigned char* data = DATA;
+    while (SIZE > 0 && isRecording)
+    {
+        unsigned long long room = EVENT_RECORDING_BUFFER_SIZE - state.bufferUsed;
+        unsigned long long size = SIZE < room ? SIZE : room;
+        forgeCopyMemory(state.buffers[state.buffer] + state.bufferUsed, data, size);
+        state.bufferUsed += size;
+        data += size;
+        SIZE -= size;
+
+        if (state.bufferUsed == EVENT_RECORDING_BUFFER_SIZE && !eventRecorderWriteBuffer())
+        {
+            FORGE_LOG_ERROR("Event recording could not be written, recording stopped");
+            eventRecorderStop();
+        }
+    }
+}
+
+bool8 eventRecorderWriteBuffer()
+{
+    if (state.bufferUsed == 0)
+    {
+        return TRUE;
+    }
+
+    asyncIoTicket ticket = asyncIoWrite(state.file, state.buffers[state.buffer], state.fileOffset, state.bufferUsed, ASYNC_IO_PRIORITY_LOW, 0, 0);
+    if (ticket == ASYNC_IO_INVALID_TICKET)
+    {
+        return FALSE;
+    }
+    state.writes[state.buffer] = ticket;
+    state.fileOffset += state.bufferUsed;
+
+    //Only waits when the disk has fallen a whole buffer behind
+    state.buffer = (state.buffer + 1) % EVENT_RECORDING_BUFFER_COUNT;
+    state.bufferUsed = 0;
+    return eventRecorderWaitBuffer(state.buffer);
+}
+
+bool8 eventRecorderWaitBuffer(unsigned int BUFFER)
+{
+    if (state.writes[BUFFER] == ASYNC_IO_INVALID_TICKET)
+    {
+        return TRUE;
+    }
+
+    asyncIoResult result;
+    asyncIoStatus status = asyncIoWait(state.writes[BUFFER], &result);
+    state.writes[BUFFER] = ASYNC_IO_INVALID_TICKET;
+    return status == ASYNC_IO_STATUS_COMPLETE;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "defines.h"
+#include "core/event.h"
+
+
+// - - - | Event Recorder | - - -
+
+/*
+- - - | Recording file | - - -
+    Header : "FEVR", unsigned int version
+    Then one record per event raised outside of a listener, in the order they were raised:
+        unsigned int frame : Frame the event was raised in
+        unsigned short code : Event code
+        unsigned char flags : EVENT_RECORD_FLAG_*
+        unsigned char reserved
+        unsigned long long timestamp : Nanoseconds since the recording started
+        eventContext context
+        Followed by the payload bytes if the event carried one
+*/
+
+
+// - - - Record Flags
+typedef enum eventRecordFlag
+{
+    EVENT_RECORD_FLAG_POSTED = 0x01, //Raised with eventPost, otherwise eventTrigger
+    EVENT_RECORD_FLAG_PLATFORM = 0x02, //Raised while the platform gave its messages, these are what a replay feeds back
+    EVENT_RECORD_FLAG_PAYLOAD = 0x04 //Payload bytes follow the record
+} eventRecordFlag;
+
+
+// - - - | Recorder Functions | - - -
+
+
+// - - - Game engine functions - - -
+
+bool8 eventRecorderStart(const char* PATH);
+
+void eventRecorderStop();
+
+// Bracket the platform message pump, events raised in between are replayed later
+void eventRecorderBeginPlatformMessages();
+void eventRecorderEndPlatformMessages();
+
+// Called by the event system for every event raised outside of a listener
+void eventRecorderCapture(unsigned short CODE, eventContext CONTEXT, bool8 POSTED);
+
+// Called by the event system at the end of every frame
+void eventRecorderEndFrame();
+
+
+// - - - Replay functions - - -
+
+// Load a recording, the replay then stands in for the platform message pump
+bool8 eventReplayStart(const char* PATH);
+
+void eventReplayStop();
+
+bool8 eventReplayIsActive();
+
+// Feed this frame's recorded platform events back into the engine. Returns false once the recording is over
+bool8 eventReplayGiveMessages();
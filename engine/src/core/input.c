@@ -1,4 +1,5 @@
 #include "core/input.h"
+#include "core/input_actions.h"
 #include "core/memory.h"
 #include "core/logger.h"
 #include "core/event.h"
@@ -9,32 +10,74 @@
 // - - - | Input Tracking | - - -
 
 
+#define INPUT_KEY_MASK_WORDS 4
+
 // - - - Keyboard
+// Edges are accumulated while messages are processed so a press and release within one frame is not lost
 typedef struct keyBoardState
 {
-    bool8 keys[256];
+    inputKeyMask live; //Written as messages come in
+    inputKeyMask current; //Latched at the start of the frame
+    inputKeyMask previous;
+    inputKeyMask pressed;
+    inputKeyMask released;
+    inputKeyMask livePressed;
+    inputKeyMask liveReleased;
+    double times[256]; //Last press or release of each key
 } keyBoardState;
 
 // - - - Mouse
+// One bit per button
 typedef struct mouseState
 {
-    unsigned char buttons[BUTTON_MAX_BUTTONS];
+    unsigned char live;
+    unsigned char current;
+    unsigned char previous;
+    unsigned char pressed;
+    unsigned char released;
+    unsigned char livePressed;
+    unsigned char liveReleased;
+    short liveX, liveY;
     short x, y;
+    short previousX, previousY;
+    int liveWheel; //Summed until the next latch
+    int wheel;
+    double times[BUTTON_MAX_BUTTONS];
 } mouseState;
 
+// - - - Gamepad
+// One bit per button, same live and latched split as the keyboard
+typedef struct gamepadState
+{
+    bool8 isConnected;
+    unsigned short live;
+    unsigned short current;
+    unsigned short previous;
+    unsigned short pressed;
+    unsigned short released;
+    unsigned short livePressed;
+    unsigned short liveReleased;
+    float liveAxes[GAMEPAD_AXIS_MAX_AXES];
+    float axes[GAMEPAD_AXIS_MAX_AXES];
+} gamepadState;
+
 // - - - Input State 
 typedef struct inputState
 {
-    keyBoardState keyBoardCurrent;
-    keyBoardState keyBoardPrevious;
-    mouseState mouseCurrent;
-    mouseState mousePrevious;
+    keyBoardState keyBoard;
+    mouseState mouse;
+    gamepadState gamepads[INPUT_MAX_GAMEPADS];
+    double eventTime; //Stamp of the message being processed
 } inputState;
 
 // - - - Input State
 static bool8 isInitialized =  FALSE;
 static inputState state;
 
+// - - - Coalescing
+void inputMergeMouseMove(eventContext* QUEUED, eventContext INCOMING);
+void inputMergeMouseWheel(eventContext* QUEUED, eventContext INCOMING);
+
 
 // - - - | Input Functions | - - -
 
@@ -44,13 +87,23 @@ static inputState state;
 void inputInitialize()
 {
     forgeZeroMemory(&state, sizeof(inputState));
+
+    //Runs of motion and wheel steps become one event each, raw samples go out under their own codes
+    eventSetCoalescing(EVENT_CODE_MOUSE_MOVE, EVENT_COALESCE_ACCUMULATE, inputMergeMouseMove);
+    eventSetCoalescing(EVENT_CODE_MOUSE_WHEEL, EVENT_COALESCE_ACCUMULATE, inputMergeMouseWheel);
+
+    inputActionsInitialize();
+
     isInitialized = TRUE;
     FORGE_LOG_INFO("Input initialized");
 }
 
 void inputShutdown()
 {
-    //TODO: Shutdown routines
+    inputActionsShutdown();
+
+    //Queries keep working on the zeroed state, everything reads as up
+    forgeZeroMemory(&state, sizeof(inputState));
     isInitialized = FALSE;
     FORGE_LOG_INFO("Input shutdown");
 }
@@ -61,10 +114,54 @@ void inputUpdate(double DELTA_TIME)
     {
         return;
     }
-    
-    //Copy current state to previous state 
-    forgeCopyMemory(&state.keyBoardPrevious, &state.keyBoardCurrent, sizeof(keyBoardState));
-    forgeCopyMemory(&state.mousePrevious, &state.mouseCurrent, sizeof(mouseState));
+
+    //Whole keyboard in four words, the compiler turns these loops into a handful of vector ops
+    keyBoardState* keyBoard = &state.keyBoard;
+    for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
+    {
+        unsigned long long previous = keyBoard->current.bits[i];
+        unsigned long long current = keyBoard->live.bits[i];
+        keyBoard->previous.bits[i] = previous;
+        keyBoard->current.bits[i] = current;
+        keyBoard->pressed.bits[i] = (current & ~previous) | keyBoard->livePressed.bits[i];
+        keyBoard->released.bits[i] = (previous & ~current) | keyBoard->liveReleased.bits[i];
+        keyBoard->livePressed.bits[i] = 0;
+        keyBoard->liveReleased.bits[i] = 0;
+    }
+
+    mouseState* mouse = &state.mouse;
+    mouse->previous = mouse->current;
+    mouse->current = mouse->live;
+    mouse->pressed = (mouse->current & ~mouse->previous) | mouse->livePressed;
+    mouse->released = (mouse->previous & ~mouse->current) | mouse->liveReleased;
+    mouse->livePressed = 0;
+    mouse->liveReleased = 0;
+    mouse->previousX = mouse->x;
+    mouse->previousY = mouse->y;
+    mouse->x = mouse->liveX;
+    mouse->y = mouse->liveY;
+    mouse->wheel = mouse->liveWheel;
+    mouse->liveWheel = 0;
+
+    for (unsigned int pad = 0; pad < INPUT_MAX_GAMEPADS; ++pad)
+    {
+        gamepadState* gamepad = &state.gamepads[pad];
+        gamepad->previous = gamepad->current;
+        gamepad->current = gamepad->live;
+        gamepad->pressed = (gamepad->current & ~gamepad->previous) | gamepad->livePressed;
+        gamepad->released = (gamepad->previous & ~gamepad->current) | gamepad->liveReleased;
+        gamepad->livePressed = 0;
+        gamepad->liveReleased = 0;
+        forgeCopyMemory(gamepad->axes, gamepad->liveAxes, sizeof(gamepad->axes));
+    }
+
+    //Actions read the state latched above
+    inputActionsEvaluate();
+}
+
+void inputSetEventTime(double TIME)
+{
+    state.eventTime = TIME;
 }
 
 
@@ -73,50 +170,157 @@ void inputUpdate(double DELTA_TIME)
 // - - - Key Functions
 bool8 inputIsKeyDown(keys KEY)
 {
-    if (!isInitialized)
+    return inputKeyMaskTest(&state.keyBoard.current, KEY);
+}
+
+bool8 inputIsKeyUp(keys KEY)
+{
+    return !inputKeyMaskTest(&state.keyBoard.current, KEY);
+}
+
+bool8 inputWasKeyDown(keys KEY)
+{
+    return inputKeyMaskTest(&state.keyBoard.previous, KEY);
+}
+
+bool8 inputWasKeyUp(keys KEY)
+{
+    return !inputKeyMaskTest(&state.keyBoard.previous, KEY);
+}
+
+bool8 inputIsKeyPressed(keys KEY)
+{
+    return inputKeyMaskTest(&state.keyBoard.pressed, KEY);
+}
+
+bool8 inputIsKeyReleased(keys KEY)
+{
+    return inputKeyMaskTest(&state.keyBoard.released, KEY);
+}
+
+double inputGetKeyTime(keys KEY)
+{
+    return state.keyBoard.times[KEY & 0xFF];
+}
+
+// - - - Batch Functions
+inputKeyMask inputKeyMaskFromKeys(const keys* KEYS, unsigned int COUNT)
+{
+    inputKeyMask mask = {};
+    for (unsigned int i = 0; i < COUNT; ++i)
     {
-        return FALSE;
+        inputKeyMaskSet(&mask, KEYS[i]);
     }
-    return state.keyBoardCurrent.keys[KEY] == TRUE;
+    return mask;
 }
 
-bool8 inputIsKeyUp(keys KEY)
+bool8 inputIsChordDown(const inputKeyMask* CHORD)
 {
-    if (!isInitialized)
+    unsigned long long missing = 0;
+    for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
     {
-        return TRUE;
+        missing |= CHORD->bits[i] & ~state.keyBoard.current.bits[i];
     }
-    return state.keyBoardCurrent.keys[KEY] == FALSE;
+    return missing == 0;
 }
 
-bool8 inputWasKeyDown(keys KEY)
+bool8 inputWasChordPressed(const inputKeyMask* CHORD)
 {
-    if (!isInitialized)
+    //Every key down now and at least one of them went down this frame
+    unsigned long long missing = 0;
+    unsigned long long pressed = 0;
+    for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
     {
-        return FALSE;
+        missing |= CHORD->bits[i] & ~state.keyBoard.current.bits[i];
+        pressed |= CHORD->bits[i] & state.keyBoard.pressed.bits[i];
     }
-    return state.keyBoardPrevious.keys[KEY] == TRUE;
+    return missing == 0 && pressed != 0;
 }
 
-bool8 inputWasKeyUp(keys KEY)
+bool8 inputIsAnyKeyDown(const inputKeyMask* MASK)
 {
-    if (!isInitialized)
+    unsigned long long down = 0;
+    for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
+    {
+        down |= MASK->bits[i] & state.keyBoard.current.bits[i];
+    }
+    return down != 0;
+}
+
+unsigned int inputTestBindings(const inputKeyMask* BINDINGS, unsigned int COUNT, unsigned char* OUT_STATES)
+{
+    //Hoist the frame state into locals so the loop is pure register work
+    unsigned long long current[INPUT_KEY_MASK_WORDS];
+    unsigned long long pressed[INPUT_KEY_MASK_WORDS];
+    unsigned long long released[INPUT_KEY_MASK_WORDS];
+    for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
     {
-        return TRUE;
+        current[i] = state.keyBoard.current.bits[i];
+        pressed[i] = state.keyBoard.pressed.bits[i];
+        released[i] = state.keyBoard.released.bits[i];
     }
-    return state.keyBoardPrevious.keys[KEY] == FALSE;
+
+    unsigned int downCount = 0;
+    for (unsigned int binding = 0; binding < COUNT; ++binding)
+    {
+        const unsigned long long* chord = BINDINGS[binding].bits;
+        unsigned long long missing = 0;
+        unsigned long long missingBefore = 0;
+        unsigned long long anyPressed = 0;
+        unsigned long long anyReleased = 0;
+        for (unsigned int i = 0; i < INPUT_KEY_MASK_WORDS; ++i)
+        {
+            missing |= chord[i] & ~current[i];
+            missingBefore |= chord[i] & ~(current[i] | released[i]);
+            anyPressed |= chord[i] & pressed[i];
+            anyReleased |= chord[i] & released[i];
+        }
+
+        unsigned char result = 0;
+        if (missing == 0)
+        {
+            result |= INPUT_BINDING_DOWN;
+            downCount++;
+            if (anyPressed)
+            {
+                result |= INPUT_BINDING_PRESSED;
+            }
+        }
+        else if (missingBefore == 0 && anyReleased)
+        {
+            //Every key was held until part of the chord let go this frame, pressing one of them too makes it a tap
+            result |= INPUT_BINDING_RELEASED;
+            if (anyPressed)
+            {
+                result |= INPUT_BINDING_PRESSED;
+            }
+        }
+        OUT_STATES[binding] = result;
+    }
+
+    return downCount;
 }
 
 // - - - Input Processing Functions
 void inputProcessKey(keys KEY, bool8 IS_DOWN)
 {
-    if (state.keyBoardCurrent.keys[KEY] != IS_DOWN)
+    if (inputKeyMaskTest(&state.keyBoard.live, KEY) != IS_DOWN)
     {
-        state.keyBoardCurrent.keys[KEY] = IS_DOWN;
+        if (IS_DOWN)
+        {
+            inputKeyMaskSet(&state.keyBoard.live, KEY);
+            inputKeyMaskSet(&state.keyBoard.livePressed, KEY);
+        }
+        else
+        {
+            inputKeyMaskClear(&state.keyBoard.live, KEY);
+            inputKeyMaskSet(&state.keyBoard.liveReleased, KEY);
+        }
+        state.keyBoard.times[KEY & 0xFF] = state.eventTime;
 
         eventContext context;
         context.data.u16[0] = KEY;
-        eventTrigger(IS_DOWN ? EVENT_CODE_KEY_PRESS : EVENT_CODE_KEY_RELEASE, 0, context);
+        eventPost(IS_DOWN ? EVENT_CODE_KEY_PRESS : EVENT_CODE_KEY_RELEASE, 0, context);
     }
 }
 
@@ -126,97 +330,233 @@ void inputProcessKey(keys KEY, bool8 IS_DOWN)
 // - - - Button Functions
 bool8 inputIsButtonDown(buttons BUTTON)
 {
-    if (!isInitialized)
-    {
-        return FALSE;
-    }
-    return state.mouseCurrent.buttons[BUTTON] == TRUE;
+    return (state.mouse.current >> BUTTON) & 1;
 }
 
 bool8 inputIsButtonUp(buttons BUTTON)
 {
-    if (!isInitialized)
-    {
-        return TRUE;
-    }
-    return state.mouseCurrent.buttons[BUTTON] == FALSE;
+    return !((state.mouse.current >> BUTTON) & 1);
 }
 
 bool8 inputWasButtonDown(buttons BUTTON)
 {
-    if (!isInitialized)
-    {
-        return FALSE;
-    }
-    return state.mousePrevious.buttons[BUTTON] == TRUE;
+    return (state.mouse.previous >> BUTTON) & 1;
 }
 
 bool8 inputWasButtonUp(buttons BUTTON)
 {
-    if (!isInitialized)
-    {
-        return TRUE;
-    }
-    return state.mousePrevious.buttons[BUTTON] == FALSE;
+    return !((state.mouse.previous >> BUTTON) & 1);
+}
+
+bool8 inputIsButtonPressed(buttons BUTTON)
+{
+    return (state.mouse.pressed >> BUTTON) & 1;
+}
+
+bool8 inputIsButtonReleased(buttons BUTTON)
+{
+    return (state.mouse.released >> BUTTON) & 1;
 }
 
 void inputGetMousePosition(int *X, int *Y)
 {
-    if (!isInitialized)
-    {
-        *X = 0;
-        *Y = 0;
-        return;
-    }
-    *X = state.mouseCurrent.x;
-    *Y = state.mouseCurrent.y;
+    *X = state.mouse.x;
+    *Y = state.mouse.y;
 }
 
 void inputGetPreviousMousePosition(int *X, int *Y)
 {
-    if (!isInitialized)
+    *X = state.mouse.previousX;
+    *Y = state.mouse.previousY;
+}
+
+int inputGetMouseWheel()
+{
+    return state.mouse.wheel;
+}
+
+double inputGetButtonTime(buttons BUTTON)
+{
+    if (BUTTON >= BUTTON_MAX_BUTTONS)
     {
-        *X = 0;
-        *Y = 0;
-        return;
+        return 0.0;
     }
-    *X = state.mousePrevious.x;
-    *Y = state.mousePrevious.y;
+    return state.mouse.times[BUTTON];
 }
 
 // - - - Input Processing Functions
 void inputProcessButton(buttons BUTTON, bool8 IS_DOWN)
 {
-    if (state.mouseCurrent.buttons[BUTTON] != IS_DOWN)
+    unsigned char bit = 1 << BUTTON;
+    if (((state.mouse.live & bit) != 0) != IS_DOWN)
     {
-        state.mouseCurrent.buttons[BUTTON] = IS_DOWN;
+        if (IS_DOWN)
+        {
+            state.mouse.live |= bit;
+            state.mouse.livePressed |= bit;
+        }
+        else
+        {
+            state.mouse.live &= ~bit;
+            state.mouse.liveReleased |= bit;
+        }
+        state.mouse.times[BUTTON] = state.eventTime;
 
         eventContext context;
         context.data.u16[0] = BUTTON;
-        eventTrigger(IS_DOWN ? EVENT_CODE_BUTTON_PRESS : EVENT_CODE_BUTTON_RELEASE, 0, context);
+        eventPost(IS_DOWN ? EVENT_CODE_BUTTON_PRESS : EVENT_CODE_BUTTON_RELEASE, 0, context);
     }
 }
 
 void inputProcessMouseMovement(short X, short Y)
 {
-    if (state.mouseCurrent.x != X || state.mouseCurrent.y != Y)
+    if (state.mouse.liveX != X || state.mouse.liveY != Y)
     {
-        FORGE_LOG_TRACE("Mouse Position: %i, %i", X, Y);
-
-        state.mouseCurrent.x = X;
-        state.mouseCurrent.y = Y;
-
         eventContext context;
         context.data.u16[0] = X;
         context.data.u16[1] = Y;
-        eventTrigger(EVENT_CODE_MOUSE_MOVE, 0 , context);
+        context.data.i16[2] = X - state.mouse.liveX;
+        context.data.i16[3] = Y - state.mouse.liveY;
+
+        state.mouse.liveX = X;
+        state.mouse.liveY = Y;
+
+        eventPost(EVENT_CODE_MOUSE_MOVE, 0 , context);
+        if (eventHasListeners(EVENT_CODE_MOUSE_MOVE_RAW))
+        {
+            eventPost(EVENT_CODE_MOUSE_MOVE_RAW, 0, context);
+        }
     }
 }
 
 void inputProcessMouseWheel(char WHEEL_DELTA)
 {
-    // NOTE: no internal state to update
+    state.mouse.liveWheel += WHEEL_DELTA;
+
+    eventContext context;
+    context.data.i8[0] = WHEEL_DELTA;
+    eventPost(EVENT_CODE_MOUSE_WHEEL, 0, context);
+    if (eventHasListeners(EVENT_CODE_MOUSE_WHEEL_RAW))
+    {
+        eventPost(EVENT_CODE_MOUSE_WHEEL_RAW, 0, context);
+    }
+}
+
+
+// - - - Gamepad Functions - - -
+
+bool8 inputIsGamepadConnected(unsigned char PAD)
+{
+    return PAD < INPUT_MAX_GAMEPADS && state.gamepads[PAD].isConnected;
+}
+
+bool8 inputIsGamepadButtonDown(unsigned char PAD, gamepadButtons BUTTON)
+{
+    return PAD < INPUT_MAX_GAMEPADS && ((state.gamepads[PAD].current >> BUTTON) & 1);
+}
+
+bool8 inputWasGamepadButtonDown(unsigned char PAD, gamepadButtons BUTTON)
+{
+    return PAD < INPUT_MAX_GAMEPADS && ((state.gamepads[PAD].previous >> BUTTON) & 1);
+}
+
+bool8 inputIsGamepadButtonPressed(unsigned char PAD, gamepadButtons BUTTON)
+{
+    return PAD < INPUT_MAX_GAMEPADS && ((state.gamepads[PAD].pressed >> BUTTON) & 1);
+}
+
+bool8 inputIsGamepadButtonReleased(unsigned char PAD, gamepadButtons BUTTON)
+{
+    return PAD < INPUT_MAX_GAMEPADS && ((state.gamepads[PAD].released >> BUTTON) & 1);
+}
+
+float inputGetGamepadAxis(unsigned char PAD, gamepadAxes AXIS)
+{
+    if (PAD >= INPUT_MAX_GAMEPADS || AXIS >= GAMEPAD_AXIS_MAX_AXES)
+    {
+        return 0.0f;
+    }
+    return state.gamepads[PAD].axes[AXIS];
+}
+
+// - - - Input Processing Functions
+void inputProcessGamepadConnection(unsigned char PAD, bool8 IS_CONNECTED)
+{
+    if (PAD >= INPUT_MAX_GAMEPADS || state.gamepads[PAD].isConnected == IS_CONNECTED)
+    {
+        return;
+    }
+
+    //Release everything a removed pad was holding so nothing stays stuck down
+    if (!IS_CONNECTED)
+    {
+        for (unsigned int button = 0; button < GAMEPAD_BUTTON_MAX_BUTTONS; ++button)
+        {
+            inputProcessGamepadButton(PAD, button, FALSE);
+        }
+        forgeZeroMemory(state.gamepads[PAD].liveAxes, sizeof(state.gamepads[PAD].liveAxes));
+    }
+    state.gamepads[PAD].isConnected = IS_CONNECTED;
+
     eventContext context;
-    context.data.u8[0] = WHEEL_DELTA;
-    eventTrigger(EVENT_CODE_MOUSE_WHEEL, 0, context);
+    context.data.u16[0] = PAD;
+    context.data.u16[1] = IS_CONNECTED;
+    eventPost(EVENT_CODE_GAMEPAD_CONNECTION, 0, context);
+}
+
+void inputProcessGamepadButton(unsigned char PAD, gamepadButtons BUTTON, bool8 IS_DOWN)
+{
+    if (PAD >= INPUT_MAX_GAMEPADS || BUTTON >= GAMEPAD_BUTTON_MAX_BUTTONS)
+    {
+        return;
+    }
+
+    gamepadState* gamepad = &state.gamepads[PAD];
+    unsigned short bit = 1 << BUTTON;
+    if (((gamepad->live & bit) != 0) != IS_DOWN)
+    {
+        if (IS_DOWN)
+        {
+            gamepad->live |= bit;
+            gamepad->livePressed |= bit;
+        }
+        else
+        {
+            gamepad->live &= ~bit;
+            gamepad->liveReleased |= bit;
+        }
+
+        eventContext context;
+        context.data.u16[0] = BUTTON;
+        context.data.u16[1] = PAD;
+        eventPost(IS_DOWN ? EVENT_CODE_GAMEPAD_BUTTON_PRESS : EVENT_CODE_GAMEPAD_BUTTON_RELEASE, 0, context);
+    }
+}
+
+void inputProcessGamepadAxis(unsigned char PAD, gamepadAxes AXIS, float VALUE)
+{
+    // NOTE: axes are polled, they do not raise events
+    if (PAD >= INPUT_MAX_GAMEPADS || AXIS >= GAMEPAD_AXIS_MAX_AXES)
+    {
+        return;
+    }
+    state.gamepads[PAD].liveAxes[AXIS] = VALUE;
+}
+
+
+// - - - Coalescing - - -
+
+void inputMergeMouseMove(eventContext* QUEUED, eventContext INCOMING)
+{
+    //Latest position, summed movement
+    QUEUED->data.u16[0] = INCOMING.data.u16[0];
+    QUEUED->data.u16[1] = INCOMING.data.u16[1];
+    QUEUED->data.i16[2] += INCOMING.data.i16[2];
+    QUEUED->data.i16[3] += INCOMING.data.i16[3];
+}
+
+void inputMergeMouseWheel(eventContext* QUEUED, eventContext INCOMING)
+{
+    int delta = QUEUED->data.i8[0] + INCOMING.data.i8[0];
+    QUEUED->data.i8[0] = FORGE_CLAMP(delta, -127, 127);
 }
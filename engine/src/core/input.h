@@ -14,6 +14,42 @@ typedef enum buttons
     BUTTON_MAX_BUTTONS
 } buttons;
 
+// - - - Gamepad
+// Positional names, A is the bottom face button
+typedef enum gamepadButtons
+{
+    GAMEPAD_BUTTON_A,
+    GAMEPAD_BUTTON_B,
+    GAMEPAD_BUTTON_X,
+    GAMEPAD_BUTTON_Y,
+    GAMEPAD_BUTTON_LEFT_SHOULDER,
+    GAMEPAD_BUTTON_RIGHT_SHOULDER,
+    GAMEPAD_BUTTON_BACK,
+    GAMEPAD_BUTTON_START,
+    GAMEPAD_BUTTON_GUIDE,
+    GAMEPAD_BUTTON_LEFT_THUMB,
+    GAMEPAD_BUTTON_RIGHT_THUMB,
+    GAMEPAD_BUTTON_DPAD_UP,
+    GAMEPAD_BUTTON_DPAD_DOWN,
+    GAMEPAD_BUTTON_DPAD_LEFT,
+    GAMEPAD_BUTTON_DPAD_RIGHT,
+    GAMEPAD_BUTTON_MAX_BUTTONS
+} gamepadButtons;
+
+// Sticks go from -1 to 1, triggers from 0 to 1
+typedef enum gamepadAxes
+{
+    GAMEPAD_AXIS_LEFT_X,
+    GAMEPAD_AXIS_LEFT_Y,
+    GAMEPAD_AXIS_RIGHT_X,
+    GAMEPAD_AXIS_RIGHT_Y,
+    GAMEPAD_AXIS_LEFT_TRIGGER,
+    GAMEPAD_AXIS_RIGHT_TRIGGER,
+    GAMEPAD_AXIS_MAX_AXES
+} gamepadAxes;
+
+#define INPUT_MAX_GAMEPADS 4
+
 // - - - Keyboard
 // Taken from asciichart.com
 typedef enum keys 
@@ -149,6 +185,32 @@ typedef enum keys
     KEYS_MAX_KEYS
 } keys;
 
+STATIC_ASSERT(KEYS_MAX_KEYS <= 256, "keys do not fit in an inputKeyMask");
+
+
+// - - - Key Masks
+// One bit per key, 256 keys in four 64 bit words
+typedef struct inputKeyMask
+{
+    unsigned long long bits[4];
+} inputKeyMask;
+
+#define inputKeyMaskSet(MASK, KEY) ((MASK)->bits[(KEY) >> 6] |= 1ULL << ((KEY) & 63))
+#define inputKeyMaskClear(MASK, KEY) ((MASK)->bits[(KEY) >> 6] &= ~(1ULL << ((KEY) & 63)))
+#define inputKeyMaskTest(MASK, KEY) (((MASK)->bits[(KEY) >> 6] >> ((KEY) & 63)) & 1ULL)
+
+// Build a mask from a list of keys: inputKeyChord(KEY_CONTROL, KEY_S)
+#define inputKeyChord(...) \
+    inputKeyMaskFromKeys((keys[]) {__VA_ARGS__}, sizeof((keys[]) {__VA_ARGS__}) / sizeof(keys))
+
+// - - - Binding Results
+typedef enum inputBindingState
+{
+    INPUT_BINDING_DOWN = 0x01, //Every key of the binding is down
+    INPUT_BINDING_PRESSED = 0x02, //The binding became down this frame, a tap within one frame sets both edges
+    INPUT_BINDING_RELEASED = 0x04 //The binding stopped being down this frame
+} inputBindingState;
+
 
 // - - - | Input Functions | - - -
 
@@ -157,8 +219,13 @@ typedef enum keys
 
 void inputInitialize();
 void inputShutdown();
+
+// Latch everything processed since the last update into this frame's state. Call once per frame after the messages are pumped
 void inputUpdate(double DELTA_TIME);
 
+// The platform stamps each message before processing it, in platformGetTime seconds
+void inputSetEventTime(double TIME);
+
 
 // - - - Keyboard Functions - - -
 
@@ -168,6 +235,23 @@ FORGE_API bool8 inputIsKeyUp(keys KEY);
 FORGE_API bool8 inputWasKeyDown(keys KEY);
 FORGE_API bool8 inputWasKeyUp(keys KEY);
 
+// Went down or up this frame, a tap within one frame counts as both
+FORGE_API bool8 inputIsKeyPressed(keys KEY);
+FORGE_API bool8 inputIsKeyReleased(keys KEY);
+
+// When the key last went down or up, as stamped by the platform. Compare against platformGetTime for latency
+FORGE_API double inputGetKeyTime(keys KEY);
+
+// - - - Batch Functions
+FORGE_API inputKeyMask inputKeyMaskFromKeys(const keys* KEYS, unsigned int COUNT);
+
+FORGE_API bool8 inputIsChordDown(const inputKeyMask* CHORD);
+FORGE_API bool8 inputWasChordPressed(const inputKeyMask* CHORD);
+FORGE_API bool8 inputIsAnyKeyDown(const inputKeyMask* MASK);
+
+// Evaluate COUNT chords at once, OUT_STATES receives the inputBindingState bits of each. Returns how many are down
+FORGE_API unsigned int inputTestBindings(const inputKeyMask* BINDINGS, unsigned int COUNT, unsigned char* OUT_STATES);
+
 // - - - Input Processing Functions
 void inputProcessKey(keys KEY, bool8 IS_DOWN);
 
@@ -179,11 +263,32 @@ FORGE_API bool8 inputIsButtonDown(buttons BUTTON);
 FORGE_API bool8 inputIsButtonUp(buttons BUTTON);
 FORGE_API bool8 inputWasButtonDown(buttons BUTTON);
 FORGE_API bool8 inputWasButtonUp(buttons BUTTON);
+FORGE_API bool8 inputIsButtonPressed(buttons BUTTON);
+FORGE_API bool8 inputIsButtonReleased(buttons BUTTON);
 FORGE_API void inputGetMousePosition(int* X, int* Y);
 FORGE_API void inputGetPreviousMousePosition(int* X, int* Y);
 
+// Wheel movement summed over the frame
+FORGE_API int inputGetMouseWheel();
+
+FORGE_API double inputGetButtonTime(buttons BUTTON);
+
 // - - - Input Processing Functions
 void inputProcessButton(buttons BUTTON, bool8 IS_DOWN);
 void inputProcessMouseMovement(short X, short Y);
 void inputProcessMouseWheel(char WHEEL_DELTA);
 
+
+// - - - Gamepad Functions - - -
+
+FORGE_API bool8 inputIsGamepadConnected(unsigned char PAD);
+FORGE_API bool8 inputIsGamepadButtonDown(unsigned char PAD, gamepadButtons BUTTON);
+FORGE_API bool8 inputWasGamepadButtonDown(unsigned char PAD, gamepadButtons BUTTON);
+FORGE_API bool8 inputIsGamepadButtonPressed(unsigned char PAD, gamepadButtons BUTTON);
+FORGE_API bool8 inputIsGamepadButtonReleased(unsigned char PAD, gamepadButtons BUTTON);
+FORGE_API float inputGetGamepadAxis(unsigned char PAD, gamepadAxes AXIS);
+
+// - - - Input Processing Functions
+void inputProcessGamepadConnection(unsigned char PAD, bool8 IS_CONNECTED);
+void inputProcessGamepadButton(unsigned char PAD, gamepadButtons BUTTON, bool8 IS_DOWN);
+void inputProcessGamepadAxis(unsigned char PAD, gamepadAxes AXIS, float VALUE);
@@ -0,0 +1,506 @@
+#include "core/input_actions.h"
+#include "core/input.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "dataStructures/list.h"
+
+#include <string.h>
+
+
+// - - - | Action Tracking | - - -
+
+
+// - - - Bindings as they were declared
+typedef enum inputBindingKind
+{
+    INPUT_BIND_ACTION_CHORD,
+    INPUT_BIND_ACTION_BUTTON,
+    INPUT_BIND_AXIS_KEY,
+    INPUT_BIND_AXIS_MOUSE
+} inputBindingKind;
+
+typedef struct inputBinding
+{
+    unsigned short target; //Action or axis ID
+    unsigned char kind;
+    unsigned char code; //Button or mouse source
+    float scale;
+    inputKeyMask chord;
+} inputBinding;
+
+// - - - Compiled mouse axis binding
+typedef struct inputMouseAxisBinding
+{
+    unsigned short axis;
+    unsigned char source;
+    float scale;
+} inputMouseAxisBinding;
+
+//Evaluation only, never reported
+#define INPUT_ACTION_WAS_DOWN 0x80
+
+// - - - Action State
+typedef struct inputActionState
+{
+    //Definitions
+    char** actionNames; //list
+    char** axisNames; //list
+    inputBinding* bindings; //list
+    bool8 isDirty;
+
+    //Compiled tables: action chords first, then one single key chord per axis key binding
+    inputKeyMask* chords; //list
+    unsigned short* chordTargets; //list
+    float* chordScales; //list, only meaningful for axis chords
+    unsigned char* chordStates; //list, scratch for inputTestBindings
+    unsigned int actionChordCount;
+    unsigned char* actionButtons; //list, button mask per action
+    inputMouseAxisBinding* mouseAxes; //list
+
+    //Results
+    unsigned char* actionStates; //list, inputBindingState bits per action
+    float* axisValues; //list
+} inputActionState;
+
+static bool8 isInitialized = FALSE;
+static inputActionState state;
+
+// - - - Helpers
+char* inputActionCopyName(const char* NAME);
+unsigned short inputActionFindName(char** NAMES, const char* NAME);
+void inputActionAddBinding(inputBinding BINDING);
+
+
+// - - - | Input Action Functions | - - -
+
+
+// - - - System Functions - - -
+
+void inputActionsInitialize()
+{
+    if (isInitialized)
+    {
+        return;
+    }
+
+    forgeZeroMemory(&state, sizeof(inputActionState));
+    state.actionNames = listCreate(char*);
+    state.axisNames = listCreate(char*);
+    state.bindings = listCreate(inputBinding);
+    state.chords = listCreate(inputKeyMask);
+    state.chordTargets = listCreate(unsigned short);
+    state.chordScales = listCreate(float);
+    state.chordStates = listCreate(unsigned char);
+    state.actionButtons = listCreate(unsigned char);
+    state.mouseAxes = listCreate(inputMouseAxisBinding);
+    state.actionStates = listCreate(unsigned char);
+    state.axisValues = listCreate(float);
+    isInitialized = TRUE;
+}
+
+void inputActionsShutdown()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    for (unsigned long long i = 0; i < listLength(state.actionNames); ++i)
+    {
+        forgeFreeMemory(state.actionNames[i], strlen(state.actionNames[i]) + 1, MEMORY_TAG_ARRAY);
+    }
+    for (unsigned long long i = 0; i < listLength(state.axisNames); ++i)
+    {
+        forgeFreeMemory(state.axisNames[i], strlen(state.axisNames[i]) + 1, MEMORY_TAG_ARRAY);
+    }
+
+    listDestroy(state.actionNames);
+    listDestroy(state.axisNames);
+    listDestroy(state.bindings);
+    listDestroy(state.chords);
+    listDestroy(state.chordTargets);
+    listDestroy(state.chordScales);
+    listDestroy(state.chordStates);
+    listDestroy(state.actionButtons);
+    listDestroy(state.mouseAxes);
+    listDestroy(state.actionStates);
+    listDestroy(state.axisValues);
+    forgeZeroMemory(&state, sizeof(inputActionState));
+    isInitialized = FALSE;
+}
+
+void inputActionsEvaluate()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    if (state.isDirty)
+    {
+        inputActionsCompile();
+    }
+
+    //Every key chord, action and axis alike, in one pass over the keyboard masks
+    unsigned int chordCount = listLength(state.chords);
+    if (chordCount > 0)
+    {
+        inputTestBindings(state.chords, chordCount, state.chordStates);
+    }
+
+    unsigned char buttonsDown = 0;
+    unsigned char buttonsPressed = 0;
+    unsigned char buttonsReleased = 0;
+    for (unsigned int button = 0; button < BUTTON_MAX_BUTTONS; ++button)
+    {
+        buttonsDown |= inputIsButtonDown(button) << button;
+        buttonsPressed |= inputIsButtonPressed(button) << button;
+        buttonsReleased |= inputIsButtonReleased(button) << button;
+    }
+
+    //Actions: remember last frame, gather what every binding did this frame, then derive the edges
+    unsigned int actionCount = listLength(state.actionStates);
+    for (unsigned int action = 0; action < actionCount; ++action)
+    {
+        unsigned char buttons = state.actionButtons[action];
+        unsigned char actionState = (state.actionStates[action] & INPUT_BINDING_DOWN) ? INPUT_ACTION_WAS_DOWN : 0;
+        actionState |= (buttons & buttonsDown) ? INPUT_BINDING_DOWN : 0;
+        actionState |= (buttons & buttonsPressed) ? INPUT_BINDING_PRESSED : 0;
+        actionState |= (buttons & buttonsReleased) ? INPUT_BINDING_RELEASED : 0;
+        state.actionStates[action] = actionState;
+    }
+
+    for (unsigned int chord = 0; chord < state.actionChordCount; ++chord)
+    {
+        state.actionStates[state.chordTargets[chord]] |= state.chordStates[chord];
+    }
+
+    for (unsigned int action = 0; action < actionCount; ++action)
+    {
+        unsigned char actionState = state.actionStates[action];
+        bool8 isDown = (actionState & INPUT_BINDING_DOWN) != 0;
+        bool8 wasDown = (actionState & INPUT_ACTION_WAS_DOWN) != 0;
+        unsigned char result = actionState & INPUT_BINDING_DOWN;
+
+        //A binding tapped within the frame is pressed and released without ever being seen down, that is both edges
+        if (!wasDown && (isDown || (actionState & INPUT_BINDING_PRESSED)))
+        {
+            result |= INPUT_BINDING_PRESSED;
+        }
+        if (!isDown && (wasDown || (actionState & INPUT_BINDING_RELEASED)))
+        {
+            result |= INPUT_BINDING_RELEASED;
+        }
+        state.actionStates[action] = result;
+    }
+
+    //Axes: sum every binding
+    unsigned int axisCount = listLength(state.axisValues);
+    for (unsigned int axis = 0; axis < axisCount; ++axis)
+    {
+        state.axisValues[axis] = 0.0f;
+    }
+
+    for (unsigned int chord = state.actionChordCount; chord < chordCount; ++chord)
+    {
+        if (state.chordStates[chord] & INPUT_BINDING_DOWN)
+        {
+            state.axisValues[state.chordTargets[chord]] += state.chordScales[chord];
+        }
+    }
+
+    unsigned int mouseAxisCount = listLength(state.mouseAxes);
+    if (mouseAxisCount > 0)
+    {
+        int x, y, previousX, previousY;
+        inputGetMousePosition(&x, &y);
+        inputGetPreviousMousePosition(&previousX, &previousY);
+        float sources[3];
+        sources[INPUT_AXIS_MOUSE_X] = (float) (x - previousX);
+        sources[INPUT_AXIS_MOUSE_Y] = (float) (y - previousY);
+        sources[INPUT_AXIS_MOUSE_WHEEL] = (float) inputGetMouseWheel();
+
+        for (unsigned int i = 0; i < mouseAxisCount; ++i)
+        {
+            inputMouseAxisBinding* binding = &state.mouseAxes[i];
+            state.axisValues[binding->axis] += sources[binding->source] * binding->scale;
+        }
+    }
+}
+
+
+// - - - Definition Functions - - -
+
+inputActionId inputActionCreate(const char* NAME)
+{
+    if (!isInitialized)
+    {
+        return INPUT_ACTION_INVALID;
+    }
+
+    inputActionId action = inputActionFindName(state.actionNames, NAME);
+    if (action != INPUT_ACTION_INVALID)
+    {
+        return action;
+    }
+
+    action = listLength(state.actionNames);
+    if (action == INPUT_ACTION_INVALID)
+    {
+        FORGE_LOG_ERROR("Cannot create action %s, out of action IDs", NAME);
+        return INPUT_ACTION_INVALID;
+    }
+
+    listAppend(state.actionNames, inputActionCopyName(NAME));
+    listAppend(state.actionStates, (unsigned char) 0);
+    listAppend(state.actionButtons, (unsigned char) 0);
+    return action;
+}
+
+inputActionId inputActionFind(const char* NAME)
+{
+    if (!isInitialized)
+    {
+        return INPUT_ACTION_INVALID;
+    }
+    return inputActionFindName(state.actionNames, NAME);
+}
+
+void inputActionBindKey(inputActionId ACTION, keys KEY)
+{
+    inputKeyMask chord = {};
+    inputKeyMaskSet(&chord, KEY);
+    inputActionBindChord(ACTION, chord);
+}
+
+void inputActionBindChord(inputActionId ACTION, inputKeyMask CHORD)
+{
+    if (!isInitialized || ACTION >= listLength(state.actionNames))
+    {
+        FORGE_LOG_WARNING("Cannot bind to unknown action %i", ACTION);
+        return;
+    }
+
+    inputBinding binding = {};
+    binding.target = ACTION;
+    binding.kind = INPUT_BIND_ACTION_CHORD;
+    binding.chord = CHORD;
+    inputActionAddBinding(binding);
+}
+
+void inputActionBindButton(inputActionId ACTION, buttons BUTTON)
+{
+    if (!isInitialized || ACTION >= listLength(state.actionNames))
+    {
+        FORGE_LOG_WARNING("Cannot bind to unknown action %i", ACTION);
+        return;
+    }
+    if (BUTTON >= BUTTON_MAX_BUTTONS)
+    {
+        FORGE_LOG_WARNING("Cannot bind unknown mouse button %i", BUTTON);
+        return;
+    }
+
+    inputBinding binding = {};
+    binding.target = ACTION;
+    binding.kind = INPUT_BIND_ACTION_BUTTON;
+    binding.code = BUTTON;
+    inputActionAddBinding(binding);
+}
+
+inputAxisId inputAxisCreate(const char* NAME)
+{
+    if (!isInitialized)
+    {
+        return INPUT_AXIS_INVALID;
+    }
+
+    inputAxisId axis = inputActionFindName(state.axisNames, NAME);
+    if (axis != INPUT_AXIS_INVALID)
+    {
+        return axis;
+    }
+
+    axis = listLength(state.axisNames);
+    if (axis == INPUT_AXIS_INVALID)
+    {
+        FORGE_LOG_ERROR("Cannot create axis %s, out of axis IDs", NAME);
+        return INPUT_AXIS_INVALID;
+    }
+
+    listAppend(state.axisNames, inputActionCopyName(NAME));
+    listAppend(state.axisValues, 0.0f);
+    return axis;
+}
+
+inputAxisId inputAxisFind(const char* NAME)
+{
+    if (!isInitialized)
+    {
+        return INPUT_AXIS_INVALID;
+    }
+    return inputActionFindName(state.axisNames, NAME);
+}
+
+void inputAxisBindKey(inputAxisId AXIS, keys KEY, float SCALE)
+{
+    if (!isInitialized || AXIS >= listLength(state.axisNames))
+    {
+        FORGE_LOG_WARNING("Cannot bind to unknown axis %i", AXIS);
+        return;
+    }
+
+    inputBinding binding = {};
+    binding.target = AXIS;
+    binding.kind = INPUT_BIND_AXIS_KEY;
+    binding.scale = SCALE;
+    inputKeyMaskSet(&binding.chord, KEY);
+    inputActionAddBinding(binding);
+}
+
+void inputAxisBindMouse(inputAxisId AXIS, inputAxisSource SOURCE, float SCALE)
+{
+    if (!isInitialized || AXIS >= listLength(state.axisNames))
+    {
+        FORGE_LOG_WARNING("Cannot bind to unknown axis %i", AXIS);
+        return;
+    }
+
+    inputBinding binding = {};
+    binding.target = AXIS;
+    binding.kind = INPUT_BIND_AXIS_MOUSE;
+    binding.code = SOURCE;
+    binding.scale = SCALE;
+    inputActionAddBinding(binding);
+}
+
+void inputActionsCompile()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    listClear(state.chords);
+    listClear(state.chordTargets);
+    listClear(state.chordScales);
+    listClear(state.chordStates);
+    listClear(state.mouseAxes);
+
+    unsigned long long actionCount = listLength(state.actionButtons);
+    for (unsigned long long action = 0; action < actionCount; ++action)
+    {
+        state.actionButtons[action] = 0;
+    }
+
+    //Two passes so action chords sit in front of axis chords
+    unsigned long long bindingCount = listLength(state.bindings);
+    for (unsigned long long i = 0; i < bindingCount; ++i)
+    {
+        inputBinding* binding = &state.bindings[i];
+        if (binding->kind == INPUT_BIND_ACTION_CHORD)
+        {
+            listAppend(state.chords, binding->chord);
+            listAppend(state.chordTargets, binding->target);
+            listAppend(state.chordScales, 0.0f);
+            listAppend(state.chordStates, (unsigned char) 0);
+        }
+        else if (binding->kind == INPUT_BIND_ACTION_BUTTON)
+        {
+            state.actionButtons[binding->target] |= 1 << binding->code;
+        }
+    }
+    state.actionChordCount = listLength(state.chords);
+
+    for (unsigned long long i = 0; i < bindingCount; ++i)
+    {
+        inputBinding* binding = &state.bindings[i];
+        if (binding->kind == INPUT_BIND_AXIS_KEY)
+        {
+            listAppend(state.chords, binding->chord);
+            listAppend(state.chordTargets, binding->target);
+            listAppend(state.chordScales, binding->scale);
+            listAppend(state.chordStates, (unsigned char) 0);
+        }
+        else if (binding->kind == INPUT_BIND_AXIS_MOUSE)
+        {
+            inputMouseAxisBinding mouseAxis;
+            mouseAxis.axis = binding->target;
+            mouseAxis.source = binding->code;
+            mouseAxis.scale = binding->scale;
+            listAppend(state.mouseAxes, mouseAxis);
+        }
+    }
+
+    state.isDirty = FALSE;
+}
+
+
+// - - - Query Functions - - -
+
+bool8 inputActionIsDown(inputActionId ACTION)
+{
+    if (!isInitialized || ACTION >= listLength(state.actionStates))
+    {
+        return FALSE;
+    }
+    return (state.actionStates[ACTION] & INPUT_BINDING_DOWN) != 0;
+}
+
+bool8 inputActionWasPressed(inputActionId ACTION)
+{
+    if (!isInitialized || ACTION >= listLength(state.actionStates))
+    {
+        return FALSE;
+    }
+    return (state.actionStates[ACTION] & INPUT_BINDING_PRESSED) != 0;
+}
+
+bool8 inputActionWasReleased(inputActionId ACTION)
+{
+    if (!isInitialized || ACTION >= listLength(state.actionStates))
+    {
+        return FALSE;
+    }
+    return (state.actionStates[ACTION] & INPUT_BINDING_RELEASED) != 0;
+}
+
+float inputAxisGetValue(inputAxisId AXIS)
+{
+    if (!isInitialized || AXIS >= listLength(state.axisValues))
+    {
+        return 0.0f;
+    }
+    return state.axisValues[AXIS];
+}
+
+
+// - - - Helpers - - -
+
+char* inputActionCopyName(const char* NAME)
+{
+    unsigned long long length = strlen(NAME) + 1;
+    char* name = forgeAllocateMemory(length, MEMORY_TAG_ARRAY);
+    forgeCopyMemory(name, NAME, length);
+    return name;
+}
+
+unsigned short inputActionFindName(char** NAMES, const char* NAME)
+{
+    //Only used while loading, gameplay keeps the IDs
+    unsigned long long count = listLength(NAMES);
+    for (unsigned long long i = 0; i < count; ++i)
+    {
+        if (strcmp(NAMES[i], NAME) == 0)
+        {
+            return i;
+        }
+    }
+    return 0xFFFF;
+}
+
+void inputActionAddBinding(inputBinding BINDING)
+{
+    listAppend(state.bindings, BINDING);
+    state.isDirty = TRUE;
+}
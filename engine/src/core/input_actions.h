@@ -0,0 +1,76 @@
+#pragma once
+#include "defines.h"
+#include "core/input.h"
+
+
+// - - - | Input Actions | - - -
+
+/*
+- - - | Actions and Axes | - - -
+    Gameplay asks for what the player means ("jump", "move x") instead of which key is held.
+    Actions are digital and bound to keys, key chords and mouse buttons, any one binding holds the action down.
+    Axes are analog and sum their bindings: keys contribute their scale while down, mouse sources contribute
+    their frame movement times the scale.
+
+    Bindings are compiled into flat tables and every action and axis is evaluated once per frame inside
+    inputUpdate, reading one is an array lookup by ID.
+*/
+
+
+// - - - Identifiers
+typedef unsigned short inputActionId;
+typedef unsigned short inputAxisId;
+
+#define INPUT_ACTION_INVALID 0xFFFF
+#define INPUT_AXIS_INVALID 0xFFFF
+
+// - - - Mouse Axis Sources
+typedef enum inputAxisSource
+{
+    INPUT_AXIS_MOUSE_X, //Horizontal movement this frame
+    INPUT_AXIS_MOUSE_Y, //Vertical movement this frame
+    INPUT_AXIS_MOUSE_WHEEL //Wheel movement this frame
+} inputAxisSource;
+
+
+// - - - | Input Action Functions | - - -
+
+
+// - - - System Functions - - -
+
+void inputActionsInitialize();
+void inputActionsShutdown();
+
+// Called by inputUpdate after the frame's input is latched
+void inputActionsEvaluate();
+
+
+// - - - Definition Functions - - -
+
+// Names are copied. Creating a name that exists returns the existing ID
+FORGE_API inputActionId inputActionCreate(const char* NAME);
+FORGE_API inputActionId inputActionFind(const char* NAME);
+
+FORGE_API void inputActionBindKey(inputActionId ACTION, keys KEY);
+FORGE_API void inputActionBindChord(inputActionId ACTION, inputKeyMask CHORD);
+FORGE_API void inputActionBindButton(inputActionId ACTION, buttons BUTTON);
+
+FORGE_API inputAxisId inputAxisCreate(const char* NAME);
+FORGE_API inputAxisId inputAxisFind(const char* NAME);
+
+FORGE_API void inputAxisBindKey(inputAxisId AXIS, keys KEY, float SCALE);
+FORGE_API void inputAxisBindMouse(inputAxisId AXIS, inputAxisSource SOURCE, float SCALE);
+
+// Rebuild the lookup tables now instead of at the next inputUpdate
+FORGE_API void inputActionsCompile();
+
+
+// - - - Query Functions - - -
+
+FORGE_API bool8 inputActionIsDown(inputActionId ACTION);
+
+// Edges of the action as a whole, a binding tapped within one frame counts as both
+FORGE_API bool8 inputActionWasPressed(inputActionId ACTION);
+FORGE_API bool8 inputActionWasReleased(inputActionId ACTION);
+
+FORGE_API float inputAxisGetValue(inputAxisId AXIS);
@@ -0,0 +1,423 @@
+#include "log_binary.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// - - - | Conversion Scanning | - - -
+
+
+#define LOG_CONVERSION_SPEC_MAX 32
+
+// - - - One printf conversion, from its % to its conversion character
+typedef struct logConversion
+{
+    const char* start;
+    unsigned int length;
+    unsigned char starCount; //Star widths and precisions, each an int argument before the value
+    unsigned short precision; //Capped at LOG_BINARY_STRING_MAX, or LOG_PRECISION_NONE or LOG_PRECISION_STAR
+    unsigned char kind;
+    bool8 hasValue; //FALSE for %%
+    bool8 isSupported;
+} logConversion;
+
+const char* logNextConversion(const char* FORMAT, logConversion* CONVERSION);
+
+unsigned int logArgumentSize(logArgumentKind KIND);
+
+
+// Returns where the next conversion starts and fills CONVERSION, or zero when there are no more
+const char* logNextConversion(const char* FORMAT, logConversion* CONVERSION)
+{
+    const char* start = strchr(FORMAT, '%');
+    if (!start)
+    {
+        return 0;
+    }
+
+    const char* cursor = start + 1;
+    CONVERSION->start = start;
+    CONVERSION->starCount = 0;
+    CONVERSION->precision = LOG_PRECISION_NONE;
+    CONVERSION->hasValue = TRUE;
+    CONVERSION->isSupported = TRUE;
+
+    while (*cursor && strchr("-+ #0'", *cursor))
+    {
+        ++cursor;
+    }
+
+    //Width then precision, either may come from an argument
+    if (*cursor == '*')
+    {
+        CONVERSION->starCount++;
+        ++cursor;
+    }
+    while (*cursor >= '0' && *cursor <= '9')
+    {
+        ++cursor;
+    }
+    if (*cursor == '.')
+    {
+        ++cursor;
+        CONVERSION->precision = 0;
+        if (*cursor == '*')
+        {
+            CONVERSION->starCount++;
+            CONVERSION->precision = LOG_PRECISION_STAR;
+            ++cursor;
+        }
+        while (*cursor >= '0' && *cursor <= '9')
+        {
+            unsigned int precision = CONVERSION->precision * 10 + (*cursor - '0');
+            CONVERSION->precision = precision < LOG_BINARY_STRING_MAX ? precision : LOG_BINARY_STRING_MAX;
+            ++cursor;
+        }
+    }
+
+    logArgumentKind integerKind = LOG_ARGUMENT_INT;
+    bool8 isLongDouble = FALSE;
+    bool8 isWide = FALSE;
+    switch (*cursor)
+    {
+        case 'h':
+            cursor += cursor[1] == 'h' ? 2 : 1;
+            break;
+
+        case 'l':
+            isWide = TRUE;
+            integerKind = cursor[1] == 'l' ? LOG_ARGUMENT_LONG_LONG : LOG_ARGUMENT_LONG;
+            cursor += cursor[1] == 'l' ? 2 : 1;
+            break;
+
+        case 'j':
+            integerKind = LOG_ARGUMENT_INTMAX;
+            ++cursor;
+            break;
+
+        case 'z':
+            integerKind = LOG_ARGUMENT_SIZE;
+            ++cursor;
+            break;
+
+        case 't':
+            integerKind = LOG_ARGUMENT_PTRDIFF;
+            ++cursor;
+            break;
+
+        case 'L':
+            isLongDouble = TRUE;
+            ++cursor;
+            break;
+    }
+
+    switch (*cursor)
+    {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            CONVERSION->kind = integerKind;
+            break;
+
+        case 'c':
+            CONVERSION->kind = LOG_ARGUMENT_INT;
+            CONVERSION->isSupported = !isWide;
+            break;
+
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            CONVERSION->kind = isLongDouble ? LOG_ARGUMENT_LONG_DOUBLE : LOG_ARGUMENT_DOUBLE;
+            break;
+
+        case 's':
+            CONVERSION->kind = LOG_ARGUMENT_STRING;
+            CONVERSION->isSupported = !isWide;
+            break;
+
+        case 'p':
+            CONVERSION->kind = LOG_ARGUMENT_POINTER;
+            break;
+
+        case '%':
+            CONVERSION->hasValue = FALSE;
+            break;
+
+        default:
+            //%n writes through its argument, anything else is not a conversion this knows
+            CONVERSION->isSupported = FALSE;
+            break;
+    }
+
+    if (*cursor)
+    {
+        ++cursor;
+    }
+    CONVERSION->length = (unsigned int) (cursor - start);
+    CONVERSION->isSupported = CONVERSION->isSupported && CONVERSION->length < LOG_CONVERSION_SPEC_MAX;
+    return start;
+}
+
+unsigned int logArgumentSize(logArgumentKind KIND)
+{
+    return KIND == LOG_ARGUMENT_INT ? sizeof(int) : sizeof(unsigned long long);
+}
+
+
+// - - - | Binary Logging Functions | - - -
+
+
+bool8 logParseSignature(const char* FORMAT, logSignature* SIGNATURE)
+{
+    SIGNATURE->isSupported = TRUE;
+    SIGNATURE->argumentCount = 0;
+
+    logConversion conversion;
+    const char* cursor = FORMAT;
+    while ((cursor = logNextConversion(cursor, &conversion)))
+    {
+        unsigned int needed = conversion.starCount + (conversion.hasValue ? 1 : 0);
+        if (!conversion.isSupported || SIGNATURE->argumentCount + needed > LOG_BINARY_MAX_ARGUMENTS)
+        {
+            SIGNATURE->isSupported = FALSE;
+            return FALSE;
+        }
+
+        for (unsigned int i = 0; i < conversion.starCount; ++i)
+        {
+            SIGNATURE->kinds[SIGNATURE->argumentCount++] = LOG_ARGUMENT_INT;
+        }
+        if (conversion.hasValue)
+        {
+            SIGNATURE->precisions[SIGNATURE->argumentCount] = conversion.precision;
+            SIGNATURE->kinds[SIGNATURE->argumentCount++] = conversion.kind;
+        }
+        cursor += conversion.length;
+    }
+    return TRUE;
+}
+
+unsigned int logEncodeArguments(const logSignature* SIGNATURE, va_list ARGUMENTS, unsigned char* BUFFER, unsigned int SIZE)
+{
+    unsigned int offset = 0;
+    int previousInt = 0; //A star precision is the int just before its string
+    for (unsigned int i = 0; i < SIGNATURE->argumentCount; ++i)
+    {
+        logArgumentKind kind = SIGNATURE->kinds[i];
+
+        //Fixed size values after this one always keep their room, only strings shrink
+        unsigned int reserved = 0;
+        for (unsigned int j = i + 1; j < SIGNATURE->argumentCount; ++j)
+        {
+            reserved += SIGNATURE->kinds[j] == LOG_ARGUMENT_STRING ? sizeof(unsigned short) : logArgumentSize(SIGNATURE->kinds[j]);
+        }
+
+        if (kind == LOG_ARGUMENT_STRING)
+        {
+            const char* string = va_arg(ARGUMENTS, const char*);
+            string = string ? string : "(null)";
+            unsigned long long room = SIZE - offset - reserved - sizeof(unsigned short);
+
+            //A precision lets the caller pass text that is not terminated, nothing past it is read. A negative star is no precision, as in printf
+            unsigned int precision = SIGNATURE->precisions[i];
+            precision = precision == LOG_PRECISION_STAR ? (previousInt >= 0 ? (unsigned int) previousInt : LOG_PRECISION_NONE) : precision;
+            unsigned long long length = strnlen(string, precision < LOG_BINARY_STRING_MAX ? precision : LOG_BINARY_STRING_MAX);
+            length = length < room ? length : room;
+
+            unsigned short stored = (unsigned short) length;
+            memcpy(BUFFER + offset, &stored, sizeof(stored));
+            memcpy(BUFFER + offset + sizeof(stored), string, length);
+            offset += sizeof(stored) + length;
+            continue;
+        }
+
+        if (kind == LOG_ARGUMENT_INT)
+        {
+            int value = va_arg(ARGUMENTS, int);
+            previousInt = value;
+            memcpy(BUFFER + offset, &value, sizeof(value));
+            offset += sizeof(value);
+            continue;
+        }
+
+        //Every other kind is widened to eight bytes so the file reads the same wherever long is shorter
+        unsigned long long value = 0;
+        switch (kind)
+        {
+            case LOG_ARGUMENT_LONG:
+                value = (unsigned long long) va_arg(ARGUMENTS, long);
+                break;
+
+            case LOG_ARGUMENT_LONG_LONG:
+                value = va_arg(ARGUMENTS, unsigned long long);
+                break;
+
+            case LOG_ARGUMENT_SIZE:
+                value = va_arg(ARGUMENTS, size_t);
+                break;
+
+            case LOG_ARGUMENT_INTMAX:
+                value = (unsigned long long) va_arg(ARGUMENTS, intmax_t);
+                break;
+
+            case LOG_ARGUMENT_PTRDIFF:
+                value = (unsigned long long) va_arg(ARGUMENTS, ptrdiff_t);
+                break;
+
+            case LOG_ARGUMENT_DOUBLE:
+            case LOG_ARGUMENT_LONG_DOUBLE:
+            {
+                double real = kind == LOG_ARGUMENT_DOUBLE ? va_arg(ARGUMENTS, double) : (double) va_arg(ARGUMENTS, long double);
+                memcpy(&value, &real, sizeof(real));
+                break;
+            }
+
+            case LOG_ARGUMENT_POINTER:
+                value = (unsigned long long) (uintptr_t) va_arg(ARGUMENTS, void*);
+                break;
+
+            default:
+                break;
+        }
+        memcpy(BUFFER + offset, &value, sizeof(value));
+        offset += sizeof(value);
+    }
+    return offset;
+}
+
+unsigned int logDecodeMessage(const char* FORMAT, const unsigned char* ARGUMENTS, unsigned int SIZE, char* OUTPUT, unsigned int OUTPUT_SIZE)
+{
+    if (!OUTPUT_SIZE)
+    {
+        return 0;
+    }
+
+    unsigned int length = 0;
+    unsigned int offset = 0;
+    const char* cursor = FORMAT;
+    logConversion conversion;
+    char spec[LOG_CONVERSION_SPEC_MAX];
+    char string[LOG_BINARY_STRING_MAX + 1];
+
+    while (length < OUTPUT_SIZE - 1)
+    {
+        //Text up to the next conversion goes across as it is
+        const char* next = logNextConversion(cursor, &conversion);
+        unsigned int literal = next ? (unsigned int) (next - cursor) : (unsigned int) strlen(cursor);
+        literal = literal < OUTPUT_SIZE - 1 - length ? literal : OUTPUT_SIZE - 1 - length;
+        memcpy(OUTPUT + length, cursor, literal);
+        length += literal;
+        if (!next || length >= OUTPUT_SIZE - 1)
+        {
+            break;
+        }
+        cursor = next + conversion.length;
+
+        memcpy(spec, conversion.start, conversion.length);
+        spec[conversion.length] = 0;
+
+        int stars[2] = {0, 0};
+        for (unsigned int i = 0; i < conversion.starCount; ++i)
+        {
+            if (offset + sizeof(int) <= SIZE)
+            {
+                memcpy(&stars[i], ARGUMENTS + offset, sizeof(int));
+            }
+            offset += sizeof(int);
+        }
+
+        //snprintf takes the value in the type the conversion names, and the star values first
+        unsigned int room = OUTPUT_SIZE - length;
+        int written = 0;
+        if (!conversion.hasValue)
+        {
+            written = snprintf(OUTPUT + length, room, "%%");
+        }
+        else if (conversion.kind == LOG_ARGUMENT_STRING)
+        {
+            unsigned short stored = 0;
+            if (offset + sizeof(stored) <= SIZE)
+            {
+                memcpy(&stored, ARGUMENTS + offset, sizeof(stored));
+            }
+            offset += sizeof(stored);
+            stored = offset + stored <= SIZE ? stored : 0;
+
+            //Nothing longer is ever encoded, a corrupt length must still not run past the buffer
+            unsigned short copied = stored < LOG_BINARY_STRING_MAX ? stored : LOG_BINARY_STRING_MAX;
+            memcpy(string, ARGUMENTS + offset, copied);
+            string[copied] = 0;
+            offset += stored;
+
+            written = conversion.starCount == 2 ? snprintf(OUTPUT + length, room, spec, stars[0], stars[1], string) : conversion.starCount == 1 ? snprintf(OUTPUT + length, room, spec, stars[0], string) : snprintf(OUTPUT + length, room, spec, string);
+        }
+        else
+        {
+            unsigned int size = logArgumentSize(conversion.kind);
+            unsigned long long bits = 0;
+            int integer = 0;
+            if (offset + size <= SIZE)
+            {
+                if (size == sizeof(int))
+                {
+                    memcpy(&integer, ARGUMENTS + offset, sizeof(int));
+                }
+                else
+                {
+                    memcpy(&bits, ARGUMENTS + offset, sizeof(bits));
+                }
+            }
+            offset += size;
+
+            double real;
+            memcpy(&real, &bits, sizeof(real));
+
+#define LOG_DECODE_PRINT(VALUE) (conversion.starCount == 2 ? snprintf(OUTPUT + length, room, spec, stars[0], stars[1], VALUE) : conversion.starCount == 1 ? snprintf(OUTPUT + length, room, spec, stars[0], VALUE) : snprintf(OUTPUT + length, room, spec, VALUE))
+            switch (conversion.kind)
+            {
+                case LOG_ARGUMENT_INT:
+                    written = LOG_DECODE_PRINT(integer);
+                    break;
+
+                case LOG_ARGUMENT_LONG:
+                    written = LOG_DECODE_PRINT((long) bits);
+                    break;
+
+                case LOG_ARGUMENT_LONG_LONG:
+                    written = LOG_DECODE_PRINT((long long) bits);
+                    break;
+
+                case LOG_ARGUMENT_SIZE:
+                    written = LOG_DECODE_PRINT((size_t) bits);
+                    break;
+
+                case LOG_ARGUMENT_INTMAX:
+                    written = LOG_DECODE_PRINT((intmax_t) bits);
+                    break;
+
+                case LOG_ARGUMENT_PTRDIFF:
+                    written = LOG_DECODE_PRINT((ptrdiff_t) bits);
+                    break;
+
+                case LOG_ARGUMENT_DOUBLE:
+                    written = LOG_DECODE_PRINT(real);
+                    break;
+
+                case LOG_ARGUMENT_LONG_DOUBLE:
+                    written = LOG_DECODE_PRINT((long double) real);
+                    break;
+
+                case LOG_ARGUMENT_POINTER:
+                    written = LOG_DECODE_PRINT((void*) (uintptr_t) bits);
+                    break;
+            }
+#undef LOG_DECODE_PRINT
+        }
+
+        if (written > 0)
+        {
+            length += (unsigned int) written < room ? (unsigned int) written : room - 1;
+        }
+    }
+
+    OUTPUT[length] = 0;
+    return length;
+}
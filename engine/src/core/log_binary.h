@@ -0,0 +1,96 @@
+#pragma once
+#include "defines.h"
+
+#include <stdarg.h>
+
+
+// - - - | Binary Logging | - - -
+
+/*
+- - - | Format later, or never | - - -
+    In the deferred and binary logger modes a log call does not format. Its format string is parsed once into a
+    signature of argument kinds, later calls copy their raw arguments next to the format's id and a timestamp.
+    Strings are copied in since the caller's pointer means nothing later.
+
+    The writer thread formats the record for the console, or writes it unformatted to a binary log file which the
+    log decoder tool turns back into text. The file names each format the first time it uses it, so it is readable
+    without the build that wrote it.
+
+    Everything in this file is plain C with no engine state, the decoder builds it on its own.
+*/
+
+#define LOG_BINARY_MAGIC "FLOG"
+#define LOG_BINARY_VERSION 1
+#define LOG_BINARY_MAX_ARGUMENTS 16 //Star widths and precisions count as arguments
+#define LOG_BINARY_STRING_MAX 512 //Longer string arguments are cut
+
+
+// - - - Argument Kinds, by the type printf reads
+typedef enum logArgumentKind
+{
+    LOG_ARGUMENT_INT, //Also char and short after promotion, and star widths
+    LOG_ARGUMENT_LONG,
+    LOG_ARGUMENT_LONG_LONG,
+    LOG_ARGUMENT_SIZE,
+    LOG_ARGUMENT_INTMAX,
+    LOG_ARGUMENT_PTRDIFF,
+    LOG_ARGUMENT_DOUBLE,
+    LOG_ARGUMENT_LONG_DOUBLE, //Kept as a double
+    LOG_ARGUMENT_POINTER,
+    LOG_ARGUMENT_STRING
+} logArgumentKind;
+
+// - - - String precisions, a string argument is never read past its precision, it need not be terminated before it
+#define LOG_PRECISION_NONE 0xFFFF
+#define LOG_PRECISION_STAR 0xFFFE //From the int argument in front of the string
+
+typedef struct logSignature
+{
+    bool8 isSupported; //FALSE for %n, wide strings and too many arguments, those are formatted on the spot
+    unsigned char argumentCount;
+    unsigned char kinds[LOG_BINARY_MAX_ARGUMENTS];
+    unsigned short precisions[LOG_BINARY_MAX_ARGUMENTS]; //For string arguments
+} logSignature;
+
+
+// - - - File Layout
+typedef struct logFileHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long ticksPerSecond;
+    unsigned long long startTicks; //Message times count from here
+} logFileHeader;
+
+typedef enum logRecordKind
+{
+    LOG_RECORD_FORMAT = 1, //id and the format string, before the first message using it
+    LOG_RECORD_MESSAGE, //id, level, time and the encoded arguments
+    LOG_RECORD_TEXT, //level, time and an already formatted line
+    LOG_RECORD_DROPPED //time and how many messages were dropped, as an unsigned long long
+} logRecordKind;
+
+// Every record starts with this, size bytes of payload follow
+typedef struct logRecord
+{
+    unsigned char kind;
+    unsigned char level;
+    unsigned short reserved;
+    unsigned int id;
+    unsigned long long ticks;
+    unsigned int size;
+    unsigned int reserved2;
+} logRecord;
+
+
+// - - - | Binary Logging Functions | - - -
+
+
+// FALSE when the format cannot be deferred, SIGNATURE->isSupported says the same
+bool8 logParseSignature(const char* FORMAT, logSignature* SIGNATURE);
+
+// Returns the bytes written to BUFFER, strings are cut to fit
+unsigned int logEncodeArguments(const logSignature* SIGNATURE, va_list ARGUMENTS, unsigned char* BUFFER, unsigned int SIZE);
+
+// Format encoded arguments the way printf would have. Returns the length written, OUTPUT is always terminated
+unsigned int logDecodeMessage(const char* FORMAT, const unsigned char* ARGUMENTS, unsigned int SIZE, char* OUTPUT, unsigned int OUTPUT_SIZE);
@@ -1,29 +1,352 @@
 #include "logger.h"
 #include "asserts.h"
+#include "log_binary.h"
+#include "clock.h"
 #include "platform/platform.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+
+
+// - - - | Logger State | - - -
+
+
+// - - - Entries, the few bytes at the end of the ring too short for a header are skipped without one
+typedef enum loggerEntryKind
+{
+    LOGGER_ENTRY_TEXT, //A formatted line
+    LOGGER_ENTRY_DEFERRED, //A format id and the encoded arguments
+    LOGGER_ENTRY_PAD //Filler in front of a wrap
+} loggerEntryKind;
+
+typedef struct loggerEntry
+{
+    unsigned long long sequence; //Call order across every thread
+    unsigned long long ticks; //When the call was made
+    unsigned int size; //Header, payload and padding, the next entry starts this far on
+    unsigned short length; //Text without its terminator, or the id and argument bytes
+    unsigned char level;
+    unsigned char kind;
+} loggerEntry;
+
+#define LOGGER_ENTRY_ALIGNMENT 8
+#define LOGGER_ENTRY_MAX ((sizeof(loggerEntry) + LOGGER_MESSAGE_MAX + LOGGER_ENTRY_ALIGNMENT - 1) & ~(LOGGER_ENTRY_ALIGNMENT - 1))
+#define LOGGER_WRITE_BATCH 64
+
+// - - - Format Signatures, found by the address of the format string. Only literals get here, their address is the same on every call from a site
+#define LOGGER_MAX_FORMATS 4096
+#define LOGGER_SIGNATURE_BITS 13 //Twice the formats, probes stay short
+
+typedef struct loggerSignatureSlot
+{
+    const char* format; //Published last, zero while the slot is free
+    unsigned int id;
+    logSignature signature;
+} loggerSignatureSlot;
+
+// - - - One producer and the writer, head and tail sit on their own cache lines
+typedef struct loggerRing
+{
+    unsigned long long head; //Bytes ever written, only the owning thread moves it
+    unsigned long long dropped;
+    char* buffer; //Set once the ring is claimed
+    platformMutex lock; //Only taken on the shared ring
+    unsigned long long tail __attribute__((aligned(64))); //Bytes ever written out, only the writer moves it
+    unsigned long long reportedDrops;
+} loggerRing;
+
+typedef struct loggerState
+{
+    bool8 isRunning;
+    loggerOverflowPolicy policy;
+    unsigned int generation; //Rings claimed under an earlier initialisation are claimed again
+    unsigned int claimedRings;
+    unsigned long long sequence;
+    unsigned int producers; //Calls past the isRunning check, the writer outlives them so the rings can be freed
+    loggerRing rings[LOGGER_MAX_THREADS + 1]; //The last one is shared by every thread past the limit
+    platformThread writer;
+    platformEvent wake;
+    unsigned int isWriterSleeping;
+
+    //Deferred formatting, lookups take no lock, only adding a signature does
+    loggerMode mode;
+    platformMutex signatureLock;
+    unsigned int formatCount;
+    loggerSignatureSlot signatures[1 << LOGGER_SIGNATURE_BITS];
+    const char* formats[LOGGER_MAX_FORMATS]; //By id
+
+    //Sinks, only the writer and mode changes touch these
+    platformMutex sinkLock;
+    FILE* binaryFile;
+    bool8 isFormatWritten[LOGGER_MAX_FORMATS]; //Named in the current binary file already
+    bool8 isConsoleDisabled;
+    bool8 isConsolePlain; //No colors
+
+    //Text log file, mapped whole and filled by the writer
+    char filePath[LOGGER_FILE_PATH_MAX];
+    platformWritableMapping fileMapping; //Memory zero while no file is open
+    unsigned long long fileSize;
+    unsigned long long fileWritten;
+    unsigned int fileKeepCount;
+} loggerState;
+
+static loggerState state;
+
+static _Thread_local loggerRing* threadRing;
+static _Thread_local unsigned int threadRingGeneration;
+
+static const char* levelStrings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: "};
+
+unsigned int loggerFormat(char* BUFFER, LogLevel LEVEL, const char* MESSAGE, va_list ARGUMENTS);
+
+void loggerWriteNow(LogLevel LEVEL, const char* MESSAGE, va_list ARGUMENTS);
+
+bool8 loggerEnqueue(LogLevel LEVEL, bool8 IS_LITERAL, const char* MESSAGE, va_list ARGUMENTS);
+
+const loggerSignatureSlot* loggerFindSignature(const char* FORMAT);
+
+loggerRing* loggerClaimRing();
+
+void loggerWakeWriter();
+
+unsigned int loggerWriterThread(void* ARGUMENT);
+
+unsigned int loggerWriteBatch();
+
+bool8 loggerHasPending();
+
+void loggerReportDrops();
+
+unsigned int loggerDecodeEntry(const loggerEntry* ENTRY, char* BUFFER);
+
+void loggerWriteRecord(FILE* BINARY_FILE, const loggerEntry* ENTRY);
+
+bool8 loggerMapFile();
+
+void loggerShiftFiles();
+
+void loggerAppendFile(const char* TEXT, unsigned int LENGTH);
+
+void loggerSyncFile();
+
 
 // - - - | Log Functions | - - -
 
 
 // - - - System Controls - - -
 
-// TODO: temporary
-#include <stdio.h>
-#include <string.h>
-#include <stdarg.h>
-
 bool8 initializeLogger()
 {
-    // TODO: create log file
+    if (state.isRunning)
+    {
+        return TRUE;
+    }
+
+    unsigned int generation = state.generation + 1;
+    platformZeroMemory(&state, sizeof(state));
+    state.generation = generation;
+    state.policy = LOGGER_OVERFLOW_DROP;
+    platformEventInitialize(&state.wake, FALSE);
+
+    //The shared ring is always there, so a thread that cannot get its own still logs
+    loggerRing* shared = &state.rings[LOGGER_MAX_THREADS];
+    shared->buffer = platformAllocateMemory(LOGGER_RING_SIZE, FALSE);
+    if (!shared->buffer)
+    {
+        FORGE_LOG_ERROR("Logger could not allocate its shared ring, logging stays synchronous");
+        return FALSE;
+    }
+
+    //Running before the thread starts, the writer leaves as soon as it sees it clear
+    state.isRunning = TRUE;
+    if (!platformThreadCreate(&state.writer, "forge-logger", loggerWriterThread, 0))
+    {
+        state.isRunning = FALSE;
+        platformFreeMemory(shared->buffer, FALSE);
+        shared->buffer = 0;
+        FORGE_LOG_ERROR("Logger thread could not start, logging stays synchronous");
+        return FALSE;
+    }
+
+    //A process that exits without shutting down still gets its last messages out
+    static bool8 isExitFlushRegistered = FALSE;
+    if (!isExitFlushRegistered)
+    {
+        atexit(shutdownLogger);
+        isExitFlushRegistered = TRUE;
+    }
+
     FORGE_LOG_INFO("Logger Initialized");
     return TRUE;
 }
 
 void shutdownLogger()
 {
+    if (!state.isRunning)
+    {
+        return;
+    }
+
     FORGE_LOG_INFO("Logger Shutdown");
-    // TODO: cleanup and write all queued entries
+
+    //The writer drains every ring and waits out calls already enqueueing before it leaves, later calls are written on the spot
+    __atomic_store_n(&state.isRunning, FALSE, __ATOMIC_SEQ_CST);
+    platformEventSet(&state.wake);
+    platformThreadJoin(&state.writer);
+
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        if (state.rings[i].buffer)
+        {
+            platformFreeMemory(state.rings[i].buffer, FALSE);
+            state.rings[i].buffer = 0;
+        }
+    }
+
+    if (state.binaryFile)
+    {
+        fclose(state.binaryFile);
+        state.binaryFile = 0;
+    }
+    platformUnmapFileForWriting(&state.fileMapping, state.fileWritten);
+    state.mode = LOGGER_MODE_TEXT;
+}
+
+
+// - - - Asynchronous Controls - - -
+
+void loggerSetOverflowPolicy(loggerOverflowPolicy POLICY)
+{
+    __atomic_store_n(&state.policy, POLICY, __ATOMIC_RELAXED);
+}
+
+bool8 loggerSetMode(loggerMode MODE, const char* BINARY_PATH)
+{
+    if (!state.isRunning && MODE != LOGGER_MODE_TEXT)
+    {
+        FORGE_LOG_WARNING("Logger is not running, messages are formatted on the spot");
+        return FALSE;
+    }
+
+    FILE* file = 0;
+    if (MODE == LOGGER_MODE_BINARY)
+    {
+        file = BINARY_PATH ? fopen(BINARY_PATH, "wb") : 0;
+        if (!file)
+        {
+            FORGE_LOG_ERROR("Failed to create binary log %s", BINARY_PATH ? BINARY_PATH : "(no path)");
+            return FALSE;
+        }
+
+        logFileHeader header = {};
+        memcpy(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic));
+        header.version = LOG_BINARY_VERSION;
+        header.ticksPerSecond = CLOCK_TICKS_PER_SECOND;
+        header.startTicks = platformGetTicks();
+        fwrite(&header, sizeof(header), 1, file);
+    }
+
+    //What is queued goes out to the sinks it was logged for
+    loggerFlush();
+
+    platformMutexLock(&state.sinkLock);
+    FILE* previous = state.binaryFile;
+    state.binaryFile = file;
+    platformZeroMemory(state.isFormatWritten, sizeof(state.isFormatWritten));
+    platformMutexUnlock(&state.sinkLock);
+    if (previous)
+    {
+        fclose(previous);
+    }
+
+    __atomic_store_n(&state.mode, MODE, __ATOMIC_RELAXED);
+    return TRUE;
+}
+
+void loggerFlush()
+{
+    if (!__atomic_load_n(&state.isRunning, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    unsigned long long targets[LOGGER_MAX_THREADS + 1];
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        targets[i] = __atomic_load_n(&state.rings[i].head, __ATOMIC_ACQUIRE);
+    }
+
+    platformEventSet(&state.wake);
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        while (__atomic_load_n(&state.rings[i].tail, __ATOMIC_ACQUIRE) < targets[i] && __atomic_load_n(&state.isRunning, __ATOMIC_ACQUIRE))
+        {
+            platformEventSet(&state.wake);
+            platformThreadYield();
+        }
+    }
+}
+
+
+// - - - Sink Controls - - -
+
+bool8 loggerOpenFile(const char* PATH, unsigned long long MAX_SIZE, unsigned int KEEP_COUNT)
+{
+    if (!state.isRunning)
+    {
+        FORGE_LOG_WARNING("Logger is not running, the log file is not opened");
+        return FALSE;
+    }
+    if (!PATH || strlen(PATH) >= LOGGER_FILE_PATH_MAX)
+    {
+        FORGE_LOG_ERROR("Log file path %s is missing or too long", PATH ? PATH : "(no path)");
+        return FALSE;
+    }
+
+    loggerCloseFile();
+
+    //Not the writer's yet, so the rotation and mapping happen outside the lock
+    platformMutexLock(&state.sinkLock);
+    strcpy(state.filePath, PATH);
+    state.fileSize = MAX_SIZE ? MAX_SIZE : LOGGER_FILE_DEFAULT_SIZE;
+    state.fileSize = state.fileSize < LOGGER_MESSAGE_MAX ? LOGGER_MESSAGE_MAX : state.fileSize; //The longest line always fits a fresh file
+    state.fileKeepCount = KEEP_COUNT;
+    platformMutexUnlock(&state.sinkLock);
+
+    loggerShiftFiles();
+    platformWritableMapping mapping;
+    if (!platformMapFileForWriting(PATH, state.fileSize, &mapping))
+    {
+        return FALSE;
+    }
+
+    platformMutexLock(&state.sinkLock);
+    state.fileMapping = mapping;
+    state.fileWritten = 0;
+    platformMutexUnlock(&state.sinkLock);
+    return TRUE;
+}
+
+void loggerCloseFile()
+{
+    //What is queued was logged while the file was open
+    loggerFlush();
+
+    platformMutexLock(&state.sinkLock);
+    platformWritableMapping mapping = state.fileMapping;
+    platformZeroMemory(&state.fileMapping, sizeof(state.fileMapping));
+    platformMutexUnlock(&state.sinkLock);
+
+    platformUnmapFileForWriting(&mapping, state.fileWritten);
+}
+
+void loggerSetConsole(bool8 IS_ENABLED, bool8 USE_COLOR)
+{
+    __atomic_store_n(&state.isConsoleDisabled, !IS_ENABLED, __ATOMIC_RELAXED);
+    __atomic_store_n(&state.isConsolePlain, !USE_COLOR, __ATOMIC_RELAXED);
 }
 
 
@@ -31,31 +354,539 @@ void shutdownLogger()
 
 void logOutput(LogLevel LEVEL, const char* MESSAGE, ...)
 {
-    const char* levelStrings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: "};
-    bool8 isError = LEVEL < LOG_LEVEL_WARNING;
-    const int messageLength = 32000;
-    char outputMessage[messageLength];
-    memset(outputMessage, 0, sizeof(outputMessage));
+    bool8 isLiteral = (LEVEL & LOG_FORMAT_LITERAL) != 0;
+    LEVEL = (LogLevel) (LEVEL & ~LOG_FORMAT_LITERAL);
+
+    //Counted before looking at isRunning, so shutdown either sees this call or the call sees shutdown
+    va_list arguments;
+    va_start(arguments, MESSAGE);
+    __atomic_add_fetch(&state.producers, 1, __ATOMIC_SEQ_CST);
+    bool8 isQueued = __atomic_load_n(&state.isRunning, __ATOMIC_SEQ_CST) && loggerEnqueue(LEVEL, isLiteral, MESSAGE, arguments);
+    __atomic_sub_fetch(&state.producers, 1, __ATOMIC_SEQ_CST);
+    va_end(arguments);
+
+    if (!isQueued)
+    {
+        //Before initialisation, after shutdown, or the writer left while this call waited for room
+        va_start(arguments, MESSAGE);
+        loggerWriteNow(LEVEL, MESSAGE, arguments);
+        va_end(arguments);
+        return;
+    }
+
+    //The process is probably about to go down, make sure the reason gets out and survives it
+    if (LEVEL == LOG_LEVEL_FATAL)
+    {
+        loggerFlush();
+        loggerSyncFile();
+    }
+}
+
+
+// - - - | Logger Internals | - - -
+
+
+unsigned int loggerFormat(char* BUFFER, LogLevel LEVEL, const char* MESSAGE, va_list ARGUMENTS)
+{
+    unsigned int length = strlen(levelStrings[LEVEL]);
+    platformCopyMemory(BUFFER, levelStrings[LEVEL], length);
+
+    //Room is kept for the newline and the terminator
+    int written = vsnprintf(BUFFER + length, LOGGER_MESSAGE_MAX - length - 1, MESSAGE, ARGUMENTS);
+    if (written > 0)
+    {
+        length += (unsigned int) written < LOGGER_MESSAGE_MAX - length - 2 ? (unsigned int) written : LOGGER_MESSAGE_MAX - length - 2;
+    }
+    BUFFER[length++] = '\n';
+    BUFFER[length] = 0;
+    return length;
+}
+
+void loggerWriteNow(LogLevel LEVEL, const char* MESSAGE, va_list ARGUMENTS)
+{
+    if (__atomic_load_n(&state.isConsoleDisabled, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    char message[LOGGER_MESSAGE_MAX];
+    platformConsoleBuffer buffer;
+    buffer.text = message;
+    buffer.length = loggerFormat(message, LEVEL, MESSAGE, ARGUMENTS);
+    buffer.color = LEVEL;
+    platformWriteConsoleBuffers(&buffer, 1, LEVEL < LOG_LEVEL_WARNING, !__atomic_load_n(&state.isConsolePlain, __ATOMIC_RELAXED));
+}
+
+loggerRing* loggerClaimRing()
+{
+    threadRingGeneration = state.generation;
+    threadRing = &state.rings[LOGGER_MAX_THREADS];
+
+    unsigned int index = __atomic_fetch_add(&state.claimedRings, 1, __ATOMIC_RELAXED);
+    if (index >= LOGGER_MAX_THREADS)
+    {
+        return threadRing;
+    }
+
+    char* buffer = platformAllocateMemory(LOGGER_RING_SIZE, FALSE);
+    if (buffer)
+    {
+        //Published last, the writer only looks at rings with a buffer
+        __atomic_store_n(&state.rings[index].buffer, buffer, __ATOMIC_RELEASE);
+        threadRing = &state.rings[index];
+    }
+    return threadRing;
+}
+
+const loggerSignatureSlot* loggerFindSignature(const char* FORMAT)
+{
+    const unsigned int mask = (1 << LOGGER_SIGNATURE_BITS) - 1;
+    unsigned int start = (unsigned int) (((unsigned long long) (uintptr_t) FORMAT * 0x9E3779B97F4A7C15ULL) >> (64 - LOGGER_SIGNATURE_BITS));
+
+    for (unsigned int probe = 0; probe <= mask; ++probe)
+    {
+        loggerSignatureSlot* slot = &state.signatures[(start + probe) & mask];
+        const char* key = __atomic_load_n(&slot->format, __ATOMIC_ACQUIRE);
+        if (key == FORMAT)
+        {
+            return slot->signature.isSupported ? slot : 0;
+        }
+        if (key)
+        {
+            continue;
+        }
+
+        //First call from this site, parse it once. Another thread may have claimed the slot meanwhile
+        platformMutexLock(&state.signatureLock);
+        key = __atomic_load_n(&slot->format, __ATOMIC_ACQUIRE);
+        if (!key && state.formatCount < LOGGER_MAX_FORMATS)
+        {
+            logParseSignature(FORMAT, &slot->signature);
+            slot->id = state.formatCount++;
+            state.formats[slot->id] = FORMAT;
+            __atomic_store_n(&slot->format, FORMAT, __ATOMIC_RELEASE);
+            key = FORMAT;
+        }
+        platformMutexUnlock(&state.signatureLock);
+
+        if (key == FORMAT)
+        {
+            return slot->signature.isSupported ? slot : 0;
+        }
+        if (!key)
+        {
+            return 0; //Out of format ids, formatted on the spot from here on
+        }
+    }
+    return 0;
+}
+
+bool8 loggerEnqueue(LogLevel LEVEL, bool8 IS_LITERAL, const char* MESSAGE, va_list ARGUMENTS)
+{
+    //Errors are formatted now so their text never depends on the writer or the decoder, formats built at run time so nothing holds on to them
+    const loggerSignatureSlot* signature = 0;
+    if (IS_LITERAL && LEVEL > LOG_LEVEL_ERROR && __atomic_load_n(&state.mode, __ATOMIC_RELAXED) != LOGGER_MODE_TEXT)
+    {
+        signature = loggerFindSignature(MESSAGE);
+    }
+
+    loggerRing* ring = threadRing && threadRingGeneration == state.generation ? threadRing : loggerClaimRing();
+    bool8 isShared = ring == &state.rings[LOGGER_MAX_THREADS];
+    if (isShared)
+    {
+        platformMutexLock(&ring->lock);
+    }
+
+    //Space for the longest message in one piece, plus the filler when that means wrapping to the start
+    unsigned long long head = ring->head;
+    unsigned long long offset = head & (LOGGER_RING_SIZE - 1);
+    unsigned long long toEnd = LOGGER_RING_SIZE - offset;
+    unsigned long long required = LOGGER_ENTRY_MAX + (toEnd < LOGGER_ENTRY_MAX ? toEnd : 0);
+    while (LOGGER_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) < required)
+    {
+        bool8 mayDrop = LEVEL > LOG_LEVEL_ERROR && __atomic_load_n(&state.policy, __ATOMIC_RELAXED) == LOGGER_OVERFLOW_DROP;
+        if (mayDrop || !__atomic_load_n(&state.isRunning, __ATOMIC_ACQUIRE))
+        {
+            if (mayDrop)
+            {
+                __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+            }
+            if (isShared)
+            {
+                platformMutexUnlock(&ring->lock);
+            }
+            return mayDrop;
+        }
+        platformEventSet(&state.wake);
+        platformThreadYield();
+    }
+
+    if (toEnd < LOGGER_ENTRY_MAX)
+    {
+        if (toEnd >= sizeof(loggerEntry))
+        {
+            loggerEntry* pad = (loggerEntry*) (ring->buffer + offset);
+            pad->size = (unsigned int) toEnd;
+            pad->kind = LOGGER_ENTRY_PAD;
+        }
+        head += toEnd;
+        offset = 0;
+    }
+
+    loggerEntry* entry = (loggerEntry*) (ring->buffer + offset);
+    entry->sequence = __atomic_fetch_add(&state.sequence, 1, __ATOMIC_RELAXED);
+    entry->ticks = platformGetTicks();
+    entry->level = LEVEL;
+    if (signature)
+    {
+        //The format's id and the raw arguments, the writer or the decoder formats them later
+        unsigned char* payload = (unsigned char*) (entry + 1);
+        memcpy(payload, &signature->id, sizeof(signature->id));
+        entry->kind = LOGGER_ENTRY_DEFERRED;
+        entry->length = sizeof(signature->id) + logEncodeArguments(&signature->signature, ARGUMENTS, payload + sizeof(signature->id), LOGGER_MESSAGE_MAX - sizeof(signature->id));
+        entry->size = (sizeof(loggerEntry) + entry->length + LOGGER_ENTRY_ALIGNMENT - 1) & ~(LOGGER_ENTRY_ALIGNMENT - 1);
+    }
+    else
+    {
+        entry->kind = LOGGER_ENTRY_TEXT;
+        entry->length = loggerFormat((char*) (entry + 1), LEVEL, MESSAGE, ARGUMENTS);
+        entry->size = (sizeof(loggerEntry) + entry->length + 1 + LOGGER_ENTRY_ALIGNMENT - 1) & ~(LOGGER_ENTRY_ALIGNMENT - 1);
+    }
+    __atomic_store_n(&ring->head, head + entry->size, __ATOMIC_RELEASE);
+
+    if (isShared)
+    {
+        platformMutexUnlock(&ring->lock);
+    }
+
+    loggerWakeWriter();
+    return TRUE;
+}
+
+void loggerWakeWriter()
+{
+    //Pairs with the writer announcing its sleep and then checking the rings once more
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&state.isWriterSleeping, __ATOMIC_RELAXED))
+    {
+        platformEventSet(&state.wake);
+    }
+}
+
+
+// - - - Writer Thread - - -
+
+unsigned int loggerWriterThread(void* ARGUMENT)
+{
+    while (TRUE)
+    {
+        if (loggerWriteBatch())
+        {
+            continue;
+        }
+        loggerReportDrops();
+
+        //Everything is out and no call is still writing into a ring, leave only now so shutdown loses nothing
+        if (!__atomic_load_n(&state.isRunning, __ATOMIC_ACQUIRE))
+        {
+            if (__atomic_load_n(&state.producers, __ATOMIC_SEQ_CST) == 0 && !loggerHasPending())
+            {
+                break;
+            }
+            platformThreadYield();
+            continue;
+        }
+
+        __atomic_store_n(&state.isWriterSleeping, TRUE, __ATOMIC_SEQ_CST);
+        if (!loggerHasPending() && __atomic_load_n(&state.isRunning, __ATOMIC_SEQ_CST))
+        {
+            platformEventWait(&state.wake);
+        }
+        __atomic_store_n(&state.isWriterSleeping, FALSE, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+bool8 loggerHasPending()
+{
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        if (__atomic_load_n(&state.rings[i].head, __ATOMIC_SEQ_CST) != state.rings[i].tail)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+unsigned int loggerWriteBatch()
+{
+    unsigned long long cursors[LOGGER_MAX_THREADS + 1];
+    unsigned long long heads[LOGGER_MAX_THREADS + 1];
+    char* buffers[LOGGER_MAX_THREADS + 1];
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        buffers[i] = __atomic_load_n(&state.rings[i].buffer, __ATOMIC_ACQUIRE);
+        cursors[i] = state.rings[i].tail;
+        heads[i] = buffers[i] ? __atomic_load_n(&state.rings[i].head, __ATOMIC_ACQUIRE) : cursors[i];
+    }
+
+    //Merge the rings back into call order, always taking the oldest waiting entry
+    const loggerEntry* entries[LOGGER_WRITE_BATCH];
+    unsigned int count = 0;
+    while (count < LOGGER_WRITE_BATCH)
+    {
+        int oldest = -1;
+        unsigned long long oldestSequence = 0;
+        for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+        {
+            const loggerEntry* entry = 0;
+            while (cursors[i] < heads[i])
+            {
+                unsigned long long offset = cursors[i] & (LOGGER_RING_SIZE - 1);
+                if (LOGGER_RING_SIZE - offset < sizeof(loggerEntry))
+                {
+                    cursors[i] += LOGGER_RING_SIZE - offset;
+                    continue;
+                }
+                entry = (const loggerEntry*) (buffers[i] + offset);
+                if (entry->kind != LOGGER_ENTRY_PAD)
+                {
+                    break;
+                }
+                cursors[i] += entry->size;
+                entry = 0;
+            }
+            if (entry && (oldest < 0 || entry->sequence < oldestSequence))
+            {
+                oldest = i;
+                oldestSequence = entry->sequence;
+            }
+        }
+        if (oldest < 0)
+        {
+            break;
+        }
+
+        entries[count++] = (const loggerEntry*) (buffers[oldest] + (cursors[oldest] & (LOGGER_RING_SIZE - 1)));
+        cursors[oldest] += entries[count - 1]->size;
+    }
+
+    //With a binary file open the console only gets errors, formatted text stays valid until the tails move
+    static char deferredText[LOGGER_WRITE_BATCH][LOGGER_MESSAGE_MAX];
+    platformConsoleBuffer messages[LOGGER_WRITE_BATCH];
+    unsigned int messageCount = 0;
+    bool8 isConsoleEnabled = !__atomic_load_n(&state.isConsoleDisabled, __ATOMIC_RELAXED);
+
+    platformMutexLock(&state.sinkLock);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const loggerEntry* entry = entries[i];
+        if (state.binaryFile)
+        {
+            loggerWriteRecord(state.binaryFile, entry);
+        }
+
+        bool8 isForConsole = isConsoleEnabled && (!state.binaryFile || entry->level < LOG_LEVEL_WARNING);
+        if (!isForConsole && !state.fileMapping.memory)
+        {
+            continue;
+        }
+
+        const char* text = (const char*) (entry + 1);
+        unsigned int length = entry->length;
+        if (entry->kind == LOGGER_ENTRY_DEFERRED)
+        {
+            text = deferredText[i];
+            length = loggerDecodeEntry(entry, deferredText[i]);
+        }
+
+        if (state.fileMapping.memory)
+        {
+            loggerAppendFile(text, length);
+        }
+        if (isForConsole)
+        {
+            messages[messageCount].text = text;
+            messages[messageCount].length = length;
+            messages[messageCount].color = entry->level;
+            ++messageCount;
+        }
+    }
+    if (state.binaryFile && count)
+    {
+        fflush(state.binaryFile);
+    }
+    platformMutexUnlock(&state.sinkLock);
+
+    //Runs going to the same stream share a call
+    unsigned int first = 0;
+    while (first < messageCount)
+    {
+        bool8 isError = messages[first].color < LOG_LEVEL_WARNING;
+        unsigned int last = first + 1;
+        while (last < messageCount && (messages[last].color < LOG_LEVEL_WARNING) == isError)
+        {
+            ++last;
+        }
+        platformWriteConsoleBuffers(messages + first, last - first, isError, !__atomic_load_n(&state.isConsolePlain, __ATOMIC_RELAXED));
+        first = last;
+    }
+
+    //Only now may producers reuse the space
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        __atomic_store_n(&state.rings[i].tail, cursors[i], __ATOMIC_RELEASE);
+    }
+    return count;
+}
+
+unsigned int loggerDecodeEntry(const loggerEntry* ENTRY, char* BUFFER)
+{
+    const unsigned char* payload = (const unsigned char*) (ENTRY + 1);
+    unsigned int id;
+    memcpy(&id, payload, sizeof(id));
 
-    // Add the rest of the arguments
-    __builtin_va_list argumentPointer;
-    va_start(argumentPointer, MESSAGE);
-    vsnprintf(outputMessage, sizeof(outputMessage), MESSAGE, argumentPointer);
-    va_end(argumentPointer);
+    unsigned int length = strlen(levelStrings[ENTRY->level]);
+    platformCopyMemory(BUFFER, levelStrings[ENTRY->level], length);
+    length += logDecodeMessage(state.formats[id], payload + sizeof(id), ENTRY->length - sizeof(id), BUFFER + length, LOGGER_MESSAGE_MAX - length - 1);
+    BUFFER[length++] = '\n';
+    BUFFER[length] = 0;
+    return length;
+}
 
-    //Prepend with level header
-    char finalMessage[32000];
-    sprintf(finalMessage, "%s%s\n", levelStrings[LEVEL], outputMessage);
+void loggerWriteRecord(FILE* BINARY_FILE, const loggerEntry* ENTRY)
+{
+    const unsigned char* payload = (const unsigned char*) (ENTRY + 1);
+    logRecord record = {};
+    record.level = ENTRY->level;
+    record.ticks = ENTRY->ticks;
 
-    //write to the console
-    if (isError)
+    if (ENTRY->kind == LOGGER_ENTRY_TEXT)
     {
-        platformWriteConsoleError(finalMessage, LEVEL);
+        record.kind = LOG_RECORD_TEXT;
+        record.size = ENTRY->length;
+        fwrite(&record, sizeof(record), 1, BINARY_FILE);
+        fwrite(payload, 1, record.size, BINARY_FILE);
+        return;
     }
-    else 
+
+    memcpy(&record.id, payload, sizeof(record.id));
+    if (!state.isFormatWritten[record.id])
     {
-        platformWriteConsole(finalMessage, LEVEL);    
+        //Named once per file, before its first message
+        logRecord format = {};
+        format.kind = LOG_RECORD_FORMAT;
+        format.id = record.id;
+        format.size = strlen(state.formats[record.id]);
+        fwrite(&format, sizeof(format), 1, BINARY_FILE);
+        fwrite(state.formats[record.id], 1, format.size, BINARY_FILE);
+        state.isFormatWritten[record.id] = TRUE;
     }
+
+    record.kind = LOG_RECORD_MESSAGE;
+    record.size = ENTRY->length - sizeof(record.id);
+    fwrite(&record, sizeof(record), 1, BINARY_FILE);
+    fwrite(payload + sizeof(record.id), 1, record.size, BINARY_FILE);
+}
+
+void loggerReportDrops()
+{
+    unsigned long long dropped = 0;
+    for (unsigned int i = 0; i <= LOGGER_MAX_THREADS; ++i)
+    {
+        unsigned long long total = __atomic_load_n(&state.rings[i].dropped, __ATOMIC_RELAXED);
+        dropped += total - state.rings[i].reportedDrops;
+        state.rings[i].reportedDrops = total;
+    }
+
+    if (dropped)
+    {
+        char message[128];
+        platformConsoleBuffer buffer;
+        buffer.text = message;
+        buffer.length = snprintf(message, sizeof(message), "%s%llu log messages dropped, the logging thread's ring was full\n", levelStrings[LOG_LEVEL_WARNING], dropped);
+        buffer.color = LOG_LEVEL_WARNING;
+        if (!__atomic_load_n(&state.isConsoleDisabled, __ATOMIC_RELAXED))
+        {
+            platformWriteConsoleBuffers(&buffer, 1, FALSE, !__atomic_load_n(&state.isConsolePlain, __ATOMIC_RELAXED));
+        }
+
+        platformMutexLock(&state.sinkLock);
+        if (state.fileMapping.memory)
+        {
+            loggerAppendFile(message, buffer.length);
+        }
+        if (state.binaryFile)
+        {
+            logRecord record = {};
+            record.kind = LOG_RECORD_DROPPED;
+            record.level = LOG_LEVEL_WARNING;
+            record.ticks = platformGetTicks();
+            record.size = sizeof(dropped);
+            fwrite(&record, sizeof(record), 1, state.binaryFile);
+            fwrite(&dropped, sizeof(dropped), 1, state.binaryFile);
+            fflush(state.binaryFile);
+        }
+        platformMutexUnlock(&state.sinkLock);
+    }
+}
+
+
+
+// - - - Log File - - -
+
+// Only with the sink lock held
+void loggerAppendFile(const char* TEXT, unsigned int LENGTH)
+{
+    if (state.fileWritten + LENGTH > state.fileSize)
+    {
+        //Full, cut it to the lines it holds and carry on in a fresh one
+        platformUnmapFileForWriting(&state.fileMapping, state.fileWritten);
+        if (!loggerMapFile())
+        {
+            return; //Reported, the file sink stays closed
+        }
+    }
+
+    platformCopyMemory((char*) state.fileMapping.memory + state.fileWritten, TEXT, LENGTH);
+    state.fileWritten += LENGTH;
+}
+
+bool8 loggerMapFile()
+{
+    loggerShiftFiles();
+    state.fileWritten = 0;
+    return platformMapFileForWriting(state.filePath, state.fileSize, &state.fileMapping);
+}
+
+void loggerShiftFiles()
+{
+    if (state.fileKeepCount == 0)
+    {
+        return; //Mapping the file again empties it
+    }
+
+    //Oldest first so every rename has a free name to go to, files that do not exist just fail to move
+    char from[LOGGER_FILE_PATH_MAX + 16];
+    char to[LOGGER_FILE_PATH_MAX + 16];
+    snprintf(to, sizeof(to), "%s.%u", state.filePath, state.fileKeepCount);
+    remove(to);
+    for (unsigned int i = state.fileKeepCount; i > 1; --i)
+    {
+        snprintf(from, sizeof(from), "%s.%u", state.filePath, i - 1);
+        snprintf(to, sizeof(to), "%s.%u", state.filePath, i);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", state.filePath);
+    rename(state.filePath, to);
+}
+
+void loggerSyncFile()
+{
+    platformMutexLock(&state.sinkLock);
+    platformFlushMapping(&state.fileMapping, state.fileWritten, TRUE);
+    platformMutexUnlock(&state.sinkLock);
 }
 
 
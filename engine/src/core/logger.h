@@ -36,19 +36,97 @@ typedef enum LogLevel
 } LogLevel;
 
 
+// - - - Asynchronous Logging - - -
+
+/*
+- - - | Logging off the frame thread | - - -
+    A log call formats straight into a ring buffer owned by the calling thread and returns, a writer thread
+    collects what every thread logged, puts it back in call order and hands it to the console in batches.
+    Before initializeLogger and after shutdownLogger messages are written on the spot instead.
+
+    When a ring is full the overflow policy decides what happens to warnings and below, errors and fatal
+    messages always wait for room. A fatal message also waits until everything logged before it is written.
+*/
+
+#define LOGGER_MESSAGE_MAX 4096 //Bytes with the level and newline, longer messages are cut
+#define LOGGER_RING_SIZE 131072 //Per thread, a power of two
+#define LOGGER_MAX_THREADS 32 //Threads past this share one locked ring
+
+typedef enum loggerOverflowPolicy
+{
+    LOGGER_OVERFLOW_DROP, //Throw the message away and count it, a log call never waits
+    LOGGER_OVERFLOW_BLOCK //Wait for the writer to make room, nothing is lost
+} loggerOverflowPolicy;
+
+// Warnings and below with a string literal format are the ones deferred, errors, fatal messages and formats built at run
+// time are always formatted by the call. See log_binary.h
+typedef enum loggerMode
+{
+    LOGGER_MODE_TEXT, //Format in the log call
+    LOGGER_MODE_DEFERRED, //Copy the arguments, the writer thread formats them for the console
+    LOGGER_MODE_BINARY //Copy the arguments into a binary log file for the log decoder, only errors reach the console
+} loggerMode;
+
+
+// - - - Log Files - - -
+
+/*
+- - - | Text log files | - - -
+    The log file is made full size up front and mapped, the writer thread copies lines into the mapping so a line
+    costs no system call. Once the next line does not fit the file is cut down to what it holds and rotated:
+    name.1 becomes name.2 and so on, the oldest past the kept count is deleted, and a new name is started.
+    A file left by an earlier run is rotated out the same way when the log is opened.
+
+    Written pages belong to the OS at once, a crash of the process loses nothing the writer got to. A fatal
+    message drains every ring into the file and then waits for the file to reach the disk. A file the process
+    did not get to close keeps its full size, the lines end where the zero filled space begins.
+*/
+
+#define LOGGER_FILE_DEFAULT_SIZE (16 * 1024 * 1024) //Bytes per file when none is given
+#define LOGGER_FILE_PATH_MAX 256
+
+
 // - - - | Log Functions | - - -
 
 
 // - - - System Controls - - -
 
 bool8 initializeLogger();
-void shutdownLogger();
+void shutdownLogger(); //Writes out everything still queued
+
+
+// - - - Asynchronous Controls - - -
+
+FORGE_API void loggerSetOverflowPolicy(loggerOverflowPolicy POLICY);
+
+// BINARY_PATH names the file for LOGGER_MODE_BINARY and is ignored otherwise. FALSE when the file cannot be created
+FORGE_API bool8 loggerSetMode(loggerMode MODE, const char* BINARY_PATH);
+
+// Returns once everything logged before the call has been written
+FORGE_API void loggerFlush();
+
+
+// - - - Sink Controls - - -
+
+// Every message also goes to PATH as text, whatever the mode. MAX_SIZE zero uses LOGGER_FILE_DEFAULT_SIZE, KEEP_COUNT older files
+// are kept around on rotation, zero starts the one file over. Replaces a log file already open
+FORGE_API bool8 loggerOpenFile(const char* PATH, unsigned long long MAX_SIZE, unsigned int KEEP_COUNT);
+
+FORGE_API void loggerCloseFile(); //Writes out everything still queued first
+
+// Production builds can turn the console off and rely on the log file. Colors are escape codes on linux, leave them off when the output is piped
+FORGE_API void loggerSetConsole(bool8 IS_ENABLED, bool8 USE_COLOR);
 
 
 // - - - API Controls - - -
 
 FORGE_API void logOutput(LogLevel LEVEL, const char* MESSAGE, ...); //Multivariate, takes any number of arguments greater than 1
 
+// - - - Literal formats
+//Or'd into the level by the macros. Deferred logging keys formats by address, only a literal keeps its address and text for the whole run
+#define LOG_FORMAT_LITERAL 0x80
+#define LOG_FORMAT_FLAG(MESSAGE) (__builtin_constant_p(MESSAGE) ? LOG_FORMAT_LITERAL : 0)
+
 // - - - Fatal log
 //Always define FATAL and ERROR logs.
 #ifndef FORGE_LOG_FATAL
@@ -61,25 +139,25 @@ FORGE_API void logOutput(LogLevel LEVEL, const char* MESSAGE, ...); //Multivaria
 
 //For the rest, define only when enabled, else define to nothingness
 #if LOG_WARNING_ENABLED == 1
-#define FORGE_LOG_WARNING(MESSAGE, ...) logOutput(LOG_LEVEL_WARNING, MESSAGE, ##__VA_ARGS__);
+#define FORGE_LOG_WARNING(MESSAGE, ...) logOutput(LOG_LEVEL_WARNING | LOG_FORMAT_FLAG(MESSAGE), MESSAGE, ##__VA_ARGS__);
 #else
 #define FORGE_LOG_WARNING(MESSAGE, ...)
 #endif
 
 #if LOG_INFO_ENABLED == 1
-#define FORGE_LOG_INFO(MESSAGE, ...) logOutput(LOG_LEVEL_INFO, MESSAGE, ##__VA_ARGS__);
+#define FORGE_LOG_INFO(MESSAGE, ...) logOutput(LOG_LEVEL_INFO | LOG_FORMAT_FLAG(MESSAGE), MESSAGE, ##__VA_ARGS__);
 #else
 #define FORGE_LOG_INFO(MESSAGE, ...)
 #endif
 
 #if LOG_DEBUG_ENABLED == 1
-#define FORGE_LOG_DEBUG(MESSAGE, ...) logOutput(LOG_LEVEL_DEBUG, MESSAGE, ##__VA_ARGS__);
+#define FORGE_LOG_DEBUG(MESSAGE, ...) logOutput(LOG_LEVEL_DEBUG | LOG_FORMAT_FLAG(MESSAGE), MESSAGE, ##__VA_ARGS__);
 #else
 #define FORGE_LOG_DEBUG(MESSAGE, ...)
 #endif
 
 #if LOG_TRACE_ENABLED == 1
-#define FORGE_LOG_TRACE(MESSAGE, ...) logOutput(LOG_LEVEL_TRACE, MESSAGE, ##__VA_ARGS__);
+#define FORGE_LOG_TRACE(MESSAGE, ...) logOutput(LOG_LEVEL_TRACE | LOG_FORMAT_FLAG(MESSAGE), MESSAGE, ##__VA_ARGS__);
 #else
 #define FORGE_LOG_TRACE(MESSAGE, ...)
 #endif
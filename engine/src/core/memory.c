@@ -1,10 +1,15 @@
 #include "memory.h"
 #include "core/logger.h"
+#include "core/cpu_dispatch.h"
 #include "logger.h"
 #include "platform/platform.h"
 #include "string.h"
 #include "stdio.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 
 // - - - Memory Stats - - -
 
@@ -12,6 +17,7 @@ struct memoryStats
 {
     unsigned long long totalAllocated;
     unsigned long long taggedAllocated[MEMORY_TAG_MAX];
+    unsigned long long mappedViews;
 };
 
 static struct memoryStats stats;
@@ -33,7 +39,33 @@ static const char* memoryTagAsStrings[MEMORY_TAG_MAX] = {
     "TRANSFORM      ",
     "ENTITY         ",
     "ENTITY_NODE    ",
-    "SCENE          "};
+    "SCENE          ",
+    "EVENT          ",
+    "FILE           ",
+    "MAPPED_FILE    "};
+
+// - - - Streaming Copy, chosen by CPU
+
+// Below this the copy likely fits in cache anyway and the fences cost more than they save
+#define MEMORY_STREAM_MINIMUM_SIZE 16384
+
+typedef void (*memoryStreamFunction)(void* DESTINATION, const void* SOURCE, unsigned long long SIZE);
+
+void memoryStreamPortable(void* DESTINATION, const void* SOURCE, unsigned long long SIZE);
+
+#if defined(__x86_64__) || defined(__i386__)
+void memoryStreamSse2(void* DESTINATION, const void* SOURCE, unsigned long long SIZE);
+void memoryStreamAvx2(void* DESTINATION, const void* SOURCE, unsigned long long SIZE);
+#endif
+
+static cpuKernel streamKernel = {
+    .name = "memory stream",
+    .variants = {
+#if defined(__x86_64__) || defined(__i386__)
+        {.features = PLATFORM_CPU_AVX2, .function = memoryStreamAvx2},
+        {.features = PLATFORM_CPU_SSE2, .function = memoryStreamSse2},
+#endif
+        {.features = 0, .function = memoryStreamPortable}}};
 
 
 // - - - | Memory Functions | - - -
@@ -45,10 +77,15 @@ void initializeMemory()
 {
     FORGE_LOG_INFO("Memory Initialized");
     platformZeroMemory(&stats, sizeof(stats));
+    cpuDispatchRegister(&streamKernel);
 }
 
 void shutdownMemory()
 {
+    if (stats.mappedViews > 0)
+    {
+        FORGE_LOG_WARNING("%llu file views are still mapped", stats.mappedViews);
+    }
     FORGE_LOG_INFO("Memory Shutdown");
     //TODO: cleanup of memory applications
 }
@@ -102,6 +139,145 @@ void forgeSetMemory(void* MEMORY, int VALUE, unsigned long long SIZE)
     platformSetMemory(MEMORY, VALUE, SIZE);
 }
 
+void forgeStreamMemory(void* DESTINATION, const void* SOURCE, unsigned long long SIZE)
+{
+    if (SIZE < MEMORY_STREAM_MINIMUM_SIZE || !streamKernel.function)
+    {
+        platformCopyMemory(DESTINATION, SOURCE, SIZE);
+        return;
+    }
+    ((memoryStreamFunction) streamKernel.function)(DESTINATION, SOURCE, SIZE);
+}
+
+
+// - - - Streaming Copy Kernel - - -
+
+void memoryStreamPortable(void* DESTINATION, const void* SOURCE, unsigned long long SIZE)
+{
+    platformCopyMemory(DESTINATION, SOURCE, SIZE);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+//Non temporal stores need an aligned destination, the unaligned head and the leftover tail go through a normal copy
+__attribute__((target("sse2"))) void memoryStreamSse2(void* DESTINATION, const void* SOURCE, unsigned long long SIZE)
+{
+    unsigned char* destination = DESTINATION;
+    const unsigned char* source = SOURCE;
+    unsigned long long head = (16 - ((unsigned long long) destination & 15)) & 15;
+    platformCopyMemory(destination, source, head);
+    destination += head;
+    source += head;
+    SIZE -= head;
+
+    for (; SIZE >= 64; SIZE -= 64, destination += 64, source += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*) source);
+        __m128i b = _mm_loadu_si128((const __m128i*) (source + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*) (source + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*) (source + 48));
+        _mm_stream_si128((__m128i*) destination, a);
+        _mm_stream_si128((__m128i*) (destination + 16), b);
+        _mm_stream_si128((__m128i*) (destination + 32), c);
+        _mm_stream_si128((__m128i*) (destination + 48), d);
+    }
+    _mm_sfence(); //Streamed stores are weakly ordered, make them visible before anyone is told the copy is done
+    platformCopyMemory(destination, source, SIZE);
+}
+
+__attribute__((target("avx2"))) void memoryStreamAvx2(void* DESTINATION, const void* SOURCE, unsigned long long SIZE)
+{
+    unsigned char* destination = DESTINATION;
+    const unsigned char* source = SOURCE;
+    unsigned long long head = (32 - ((unsigned long long) destination & 31)) & 31;
+    platformCopyMemory(destination, source, head);
+    destination += head;
+    source += head;
+    SIZE -= head;
+
+    for (; SIZE >= 128; SIZE -= 128, destination += 128, source += 128)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*) source);
+        __m256i b = _mm256_loadu_si256((const __m256i*) (source + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*) (source + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*) (source + 96));
+        _mm256_stream_si256((__m256i*) destination, a);
+        _mm256_stream_si256((__m256i*) (destination + 32), b);
+        _mm256_stream_si256((__m256i*) (destination + 64), c);
+        _mm256_stream_si256((__m256i*) (destination + 96), d);
+    }
+    _mm_sfence();
+    _mm256_zeroupper();
+    platformCopyMemory(destination, source, SIZE);
+}
+
+#endif
+
+// - - - File View Functions - - -
+
+bool8 forgeMapFile(const char* PATH, memoryMapHint HINT, memoryFileView* VIEW)
+{
+    void* data;
+    unsigned long long size;
+    if (!platformMapFile(PATH, HINT == MEMORY_MAP_POPULATE, &data, &size))
+    {
+        VIEW->data = 0;
+        VIEW->size = 0;
+        return FALSE;
+    }
+
+    if (HINT == MEMORY_MAP_SEQUENTIAL)
+    {
+        platformAdviseMapping(data, size, PLATFORM_MAPPING_SEQUENTIAL);
+    }
+    else if (HINT == MEMORY_MAP_RANDOM)
+    {
+        platformAdviseMapping(data, size, PLATFORM_MAPPING_RANDOM);
+    }
+
+    //Empty files have nothing mapped to count
+    if (data)
+    {
+        stats.taggedAllocated[MEMORY_TAG_MAPPED_FILE] += size;
+        stats.mappedViews++;
+    }
+    VIEW->data = data;
+    VIEW->size = size;
+    return TRUE;
+}
+
+void forgeUnmapFile(memoryFileView* VIEW)
+{
+    if (!VIEW->data)
+    {
+        return;
+    }
+
+    platformUnmapFile((void*) VIEW->data, VIEW->size);
+    stats.taggedAllocated[MEMORY_TAG_MAPPED_FILE] -= VIEW->size;
+    stats.mappedViews--;
+    VIEW->data = 0;
+    VIEW->size = 0;
+}
+
+void forgePrefetchFileRange(const memoryFileView* VIEW, unsigned long long OFFSET, unsigned long long SIZE)
+{
+    if (OFFSET < VIEW->size)
+    {
+        unsigned long long size = SIZE < VIEW->size - OFFSET ? SIZE : VIEW->size - OFFSET;
+        platformAdviseMapping((unsigned char*) VIEW->data + OFFSET, size, PLATFORM_MAPPING_WILL_NEED);
+    }
+}
+
+void forgeDiscardFileRange(const memoryFileView* VIEW, unsigned long long OFFSET, unsigned long long SIZE)
+{
+    if (OFFSET < VIEW->size)
+    {
+        unsigned long long size = SIZE < VIEW->size - OFFSET ? SIZE : VIEW->size - OFFSET;
+        platformAdviseMapping((unsigned char*) VIEW->data + OFFSET, size, PLATFORM_MAPPING_DONT_NEED);
+    }
+}
+
 // - - - Debug Function
 char* forgeGetMemoryStats()
 {
@@ -23,10 +23,32 @@ typedef enum memoryTag
     MEMORY_TAG_ENTITY,
     MEMORY_TAG_ENTITY_NODE,
     MEMORY_TAG_SCENE,
+    MEMORY_TAG_EVENT,
+    MEMORY_TAG_FILE,
+    MEMORY_TAG_MAPPED_FILE, //Address space of file views, not heap. Left out of the total
     MEMORY_TAG_MAX
 } memoryTag;
 
 
+// - - - File Views - - -
+
+// How a view will be read, decides how much the kernel loads ahead of time
+typedef enum memoryMapHint
+{
+    MEMORY_MAP_ON_DEMAND, //Pages load when first touched, untouched data costs nothing
+    MEMORY_MAP_POPULATE, //Everything is read in before forgeMapFile returns
+    MEMORY_MAP_SEQUENTIAL, //Front to back once, read far ahead
+    MEMORY_MAP_RANDOM //Scattered lookups, no read ahead
+} memoryMapHint;
+
+// Read only, writing through data faults
+typedef struct memoryFileView
+{
+    const void* data;
+    unsigned long long size;
+} memoryFileView;
+
+
 // - - - | Memory Functions | - - -
 
 
@@ -50,5 +72,21 @@ FORGE_API void forgeCopyMemory(void* DESTINATION, const void* SOURCE, unsigned l
 
 FORGE_API void forgeSetMemory(void* MEMORY, int VALUE, unsigned long long SIZE);
 
+// Copy past the caches, for large blocks nothing reads again soon like upload staging. Uses the widest stores the CPU has
+FORGE_API void forgeStreamMemory(void* DESTINATION, const void* SOURCE, unsigned long long SIZE);
+
+// - - - File View Functions - - -
+
+// Map a whole file read only, an empty file gives an empty view. Views are counted under MEMORY_TAG_MAPPED_FILE until unmapped
+FORGE_API bool8 forgeMapFile(const char* PATH, memoryMapHint HINT, memoryFileView* VIEW);
+
+FORGE_API void forgeUnmapFile(memoryFileView* VIEW);
+
+// Start reading a range in the background so touching it later does not stall
+FORGE_API void forgePrefetchFileRange(const memoryFileView* VIEW, unsigned long long OFFSET, unsigned long long SIZE);
+
+// Give back the pages of a range that will not be read again, they are read back from the file if touched
+FORGE_API void forgeDiscardFileRange(const memoryFileView* VIEW, unsigned long long OFFSET, unsigned long long SIZE);
+
 // - - - Debug Function
 FORGE_API char* forgeGetMemoryStats();
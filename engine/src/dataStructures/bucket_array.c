@@ -0,0 +1,116 @@
+#include "dataStructures/bucket_array.h"
+#include "dataStructures/list.h"
+#include "core/memory.h"
+#include "core/logger.h"
+
+
+// - - - | Bucket Array Functions | - - -
+
+
+// - - - Creation and Destruction - - -
+
+bucketArray* _bucketArrayCreate(unsigned long long PAGE_CAPACITY, unsigned long long STRIDE)
+{
+    //Round the page capacity up to a power of two so indexing is a shift and a mask
+    unsigned long long pageShift = 0;
+    while ((1ULL << pageShift) < PAGE_CAPACITY)
+    {
+        ++pageShift;
+    }
+
+    bucketArray* array = forgeAllocateMemory(sizeof(bucketArray), MEMORY_TAG_ARRAY);
+    array->stride = STRIDE;
+    array->pageShift = pageShift;
+    array->pageCapacity = 1ULL << pageShift;
+    array->pageMask = array->pageCapacity - 1;
+    array->length = 0;
+    array->pages = listCreate(void*);
+    return array;
+}
+
+void _bucketArrayDestroy(bucketArray* ARRAY)
+{
+    unsigned long long pageSize = ARRAY->pageCapacity * ARRAY->stride;
+    unsigned long long pageCount = listLength(ARRAY->pages);
+    for (unsigned long long i = 0; i < pageCount; ++i)
+    {
+        forgeFreeMemory(ARRAY->pages[i], pageSize, MEMORY_TAG_ARRAY);
+    }
+    listDestroy(ARRAY->pages);
+    forgeFreeMemory(ARRAY, sizeof(bucketArray), MEMORY_TAG_ARRAY);
+}
+
+
+// - - - Element Manipulation - - -
+
+void* _bucketArrayAppend(bucketArray* ARRAY, const void* ELEMENT)
+{
+    unsigned long long page = ARRAY->length >> ARRAY->pageShift;
+    unsigned long long slot = ARRAY->length & ARRAY->pageMask;
+
+    //Only the page table ever grows, existing pages stay where they are
+    if (page >= listLength(ARRAY->pages))
+    {
+        void* newPage = forgeAllocateMemory(ARRAY->pageCapacity * ARRAY->stride, MEMORY_TAG_ARRAY);
+        listAppend(ARRAY->pages, newPage);
+    }
+
+    unsigned long long address = (unsigned long long) ARRAY->pages[page];
+    address += slot * ARRAY->stride;
+    forgeCopyMemory((void*) address, ELEMENT, ARRAY->stride);
+    ARRAY->length++;
+    return (void*) address;
+}
+
+void _bucketArrayPop(bucketArray* ARRAY, void* DESTINATION)
+{
+    if (ARRAY->length == 0)
+    {
+        FORGE_LOG_ERROR("Cannot pop from an empty bucket array");
+        return;
+    }
+
+    forgeCopyMemory(DESTINATION, _bucketArrayGet(ARRAY, ARRAY->length - 1), ARRAY->stride);
+    ARRAY->length--;
+}
+
+void _bucketArrayClear(bucketArray* ARRAY)
+{
+    //Pages are kept around and reused by the next appends
+    ARRAY->length = 0;
+}
+
+
+// - - - Accessors - - -
+
+void* _bucketArrayGet(bucketArray* ARRAY, unsigned long long INDEX)
+{
+    if (INDEX >= ARRAY->length)
+    {
+        FORGE_LOG_ERROR("Index out of bounds of this bucket array! length: %llu, index: %llu", ARRAY->length, INDEX);
+        return 0;
+    }
+
+    unsigned long long address = (unsigned long long) ARRAY->pages[INDEX >> ARRAY->pageShift];
+    address += (INDEX & ARRAY->pageMask) * ARRAY->stride;
+    return (void*) address;
+}
+
+void* _bucketArrayGetPage(bucketArray* ARRAY, unsigned long long PAGE, unsigned long long* COUNT)
+{
+    unsigned long long first = PAGE << ARRAY->pageShift;
+    if (first >= ARRAY->length)
+    {
+        *COUNT = 0;
+        return 0;
+    }
+
+    unsigned long long remaining = ARRAY->length - first;
+    *COUNT = remaining < ARRAY->pageCapacity ? remaining : ARRAY->pageCapacity;
+    return ARRAY->pages[PAGE];
+}
+
+unsigned long long _bucketArrayPageCount(bucketArray* ARRAY)
+{
+    return (ARRAY->length + ARRAY->pageMask) >> ARRAY->pageShift;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "defines.h"
+
+/*
+- - - | Bucket Array structure | - - -
+    Elements live in fixed size pages which are never moved once allocated.
+    The page table (a list of page pointers) is the only thing that grows, so appending
+    never copies elements and every element keeps its address until the array is destroyed.
+
+    unsigned long long STRIDE : The size of each element in bytes
+    unsigned long long PAGE_CAPACITY : The number of elements in each page, always a power of two
+    unsigned long long LENGTH : The number of elements in the array
+    void** PAGES : The page table, a list of pointers to the pages
+*/
+
+
+typedef struct bucketArray
+{
+    unsigned long long stride;
+    unsigned long long pageCapacity;
+    unsigned long long pageShift;
+    unsigned long long pageMask;
+    unsigned long long length;
+    void** pages;
+} bucketArray;
+
+
+// - - - Bucket Array Controls - - -
+
+#define BUCKET_ARRAY_DEFAULT_PAGE_CAPACITY 256
+
+
+// - - - | Bucket Array Functions | - - -
+
+
+// - - - Private - - -
+
+FORGE_API bucketArray* _bucketArrayCreate(unsigned long long PAGE_CAPACITY, unsigned long long STRIDE);
+FORGE_API void _bucketArrayDestroy(bucketArray* ARRAY);
+
+FORGE_API void* _bucketArrayAppend(bucketArray* ARRAY, const void* ELEMENT);
+FORGE_API void _bucketArrayPop(bucketArray* ARRAY, void* DESTINATION);
+
+FORGE_API void* _bucketArrayGet(bucketArray* ARRAY, unsigned long long INDEX);
+FORGE_API void* _bucketArrayGetPage(bucketArray* ARRAY, unsigned long long PAGE, unsigned long long* COUNT);
+FORGE_API unsigned long long _bucketArrayPageCount(bucketArray* ARRAY);
+
+FORGE_API void _bucketArrayClear(bucketArray* ARRAY);
+
+
+// - - - Public - - -
+
+
+#define bucketArrayCreate(TYPE) \
+    _bucketArrayCreate(BUCKET_ARRAY_DEFAULT_PAGE_CAPACITY, sizeof(TYPE))
+
+#define bucketArrayReserve(TYPE, PAGE_CAPACITY) \
+    _bucketArrayCreate(PAGE_CAPACITY, sizeof(TYPE))
+
+#define bucketArrayDestroy(ARRAY) \
+    _bucketArrayDestroy(ARRAY)
+
+// Evaluates to the stable address of the appended element
+#define bucketArrayAppend(ARRAY, VALUE)  \
+    ({                                  \
+        typeof(VALUE) temp = VALUE;     \
+        _bucketArrayAppend(ARRAY, &temp); \
+    })
+
+#define bucketArrayPop(ARRAY, DESTINATION) \
+    _bucketArrayPop(ARRAY, DESTINATION)
+
+#define bucketArrayGet(ARRAY, TYPE, INDEX) \
+    ((TYPE*) _bucketArrayGet(ARRAY, INDEX))
+
+// Page wise iteration: COUNT receives the number of live elements in the page
+#define bucketArrayGetPage(ARRAY, PAGE, COUNT) \
+    _bucketArrayGetPage(ARRAY, PAGE, COUNT)
+
+#define bucketArrayPageCount(ARRAY) \
+    _bucketArrayPageCount(ARRAY)
+
+#define bucketArrayClear(ARRAY) \
+    _bucketArrayClear(ARRAY)
+
+#define bucketArrayLength(ARRAY) \
+    ((ARRAY)->length)
+
+#define bucketArrayStride(ARRAY) \
+    ((ARRAY)->stride)
@@ -17,7 +17,7 @@ int main(void)
 {
     initializeMemory();
 
-    game gameInstance;
+    game gameInstance = {};
     if (!createGame(&gameInstance))
     {
         FORGE_LOG_FATAL("Failed to create game instance");
@@ -0,0 +1,369 @@
+#include "async_io.h"
+#include "core/logger.h"
+#include "core/memory.h"
+
+
+// - - - | Async IO State | - - -
+
+
+#define ASYNC_IO_MAX_REQUESTS 1024
+#define ASYNC_IO_NO_SLOT 0xFFFFFFFF
+
+typedef enum asyncIoSlotState
+{
+    ASYNC_IO_SLOT_FREE,
+    ASYNC_IO_SLOT_QUEUED, //Waiting for room in flight
+    ASYNC_IO_SLOT_IN_FLIGHT,
+    ASYNC_IO_SLOT_DONE //Waiting to be delivered or polled
+} asyncIoSlotState;
+
+typedef struct asyncIoSlot
+{
+    unsigned int generation; //Bumped on release so stale tickets stop matching
+    unsigned char state;
+    asyncIoOperation operation;
+    asyncIoCallback callback;
+    void* user;
+    int result;
+    unsigned int next; //Next slot in whichever queue this one is in
+} asyncIoSlot;
+
+// - - - Slot Queues, linked through the slots
+typedef struct asyncIoQueue
+{
+    unsigned int head;
+    unsigned int tail;
+} asyncIoQueue;
+
+typedef struct asyncIoState
+{
+    asyncIoSlot* slots;
+    asyncIoQueue freeSlots;
+    asyncIoQueue queued[ASYNC_IO_PRIORITY_MAX];
+    asyncIoQueue finished; //Done with a callback, delivered by the next update
+    unsigned int inFlight;
+    unsigned int inFlightLimit;
+    asyncIoOperation* operations; //Scratch for one submission, inFlightLimit long
+    asyncIoCompletion* completions; //Scratch for one reap, inFlightLimit long
+} asyncIoState;
+
+static bool8 isInitialized = FALSE;
+static asyncIoState state;
+
+// - - - Helpers
+void asyncIoQueuePush(asyncIoQueue* QUEUE, unsigned int SLOT);
+unsigned int asyncIoQueuePop(asyncIoQueue* QUEUE);
+asyncIoSlot* asyncIoFindSlot(asyncIoTicket TICKET);
+asyncIoTicket asyncIoQueueRequest(asyncIoFile ASYNC_FILE, void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, bool8 IS_WRITE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER);
+unsigned int asyncIoReap(bool8 WAIT);
+asyncIoResult asyncIoMakeResult(asyncIoSlot* SLOT);
+void asyncIoRelease(asyncIoSlot* SLOT);
+
+
+// - - - | Async IO Functions | - - -
+
+
+// - - - System Functions - - -
+
+bool8 asyncIoInitialize()
+{
+    if (isInitialized)
+    {
+        return FALSE;
+    }
+
+    forgeZeroMemory(&state, sizeof(state));
+    state.inFlightLimit = platformAsyncIoInitialize(ASYNC_IO_MAX_REQUESTS);
+    if (state.inFlightLimit == 0)
+    {
+        FORGE_LOG_ERROR("Async IO failed to initialise");
+        return FALSE;
+    }
+
+    state.slots = forgeAllocateMemory(sizeof(asyncIoSlot) * ASYNC_IO_MAX_REQUESTS, MEMORY_TAG_FILE);
+    state.operations = forgeAllocateMemory(sizeof(asyncIoOperation) * state.inFlightLimit, MEMORY_TAG_FILE);
+    state.completions = forgeAllocateMemory(sizeof(asyncIoCompletion) * state.inFlightLimit, MEMORY_TAG_FILE);
+
+    state.freeSlots.head = ASYNC_IO_NO_SLOT;
+    state.finished.head = ASYNC_IO_NO_SLOT;
+    for (unsigned int priority = 0; priority < ASYNC_IO_PRIORITY_MAX; ++priority)
+    {
+        state.queued[priority].head = ASYNC_IO_NO_SLOT;
+    }
+    for (unsigned int slot = 0; slot < ASYNC_IO_MAX_REQUESTS; ++slot)
+    {
+        asyncIoQueuePush(&state.freeSlots, slot);
+    }
+
+    isInitialized = TRUE;
+    FORGE_LOG_INFO("Async IO Initialized");
+    return TRUE;
+}
+
+void asyncIoShutdown()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    //The kernel may still be writing into buffers, let everything in flight land first
+    while (state.inFlight > 0)
+    {
+        asyncIoReap(TRUE);
+    }
+
+    unsigned int dropped = 0;
+    for (unsigned int priority = 0; priority < ASYNC_IO_PRIORITY_MAX; ++priority)
+    {
+        while (asyncIoQueuePop(&state.queued[priority]) != ASYNC_IO_NO_SLOT)
+        {
+            ++dropped;
+        }
+    }
+    if (dropped > 0)
+    {
+        FORGE_LOG_WARNING("Async IO shut down with %u requests never submitted", dropped);
+    }
+
+    platformAsyncIoShutdown();
+    forgeFreeMemory(state.slots, sizeof(asyncIoSlot) * ASYNC_IO_MAX_REQUESTS, MEMORY_TAG_FILE);
+    forgeFreeMemory(state.operations, sizeof(asyncIoOperation) * state.inFlightLimit, MEMORY_TAG_FILE);
+    forgeFreeMemory(state.completions, sizeof(asyncIoCompletion) * state.inFlightLimit, MEMORY_TAG_FILE);
+    isInitialized = FALSE;
+    FORGE_LOG_INFO("Async IO Shutdown");
+}
+
+void asyncIoUpdate()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    //Completions free room in flight for whatever is still queued
+    asyncIoSubmit();
+    if (asyncIoReap(FALSE) > 0)
+    {
+        asyncIoSubmit();
+    }
+
+    //Released before the callback runs, so the callback can queue the next request into the same slot
+    unsigned int slot;
+    while ((slot = asyncIoQueuePop(&state.finished)) != ASYNC_IO_NO_SLOT)
+    {
+        asyncIoSlot* finished = &state.slots[slot];
+        asyncIoCallback callback = finished->callback;
+        asyncIoResult result = asyncIoMakeResult(finished);
+        asyncIoRelease(finished);
+        callback(&result);
+    }
+}
+
+
+// - - - Request Functions - - -
+
+asyncIoTicket asyncIoRead(asyncIoFile ASYNC_FILE, void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER)
+{
+    return asyncIoQueueRequest(ASYNC_FILE, BUFFER, OFFSET, SIZE, FALSE, PRIORITY, CALLBACK, USER);
+}
+
+asyncIoTicket asyncIoWrite(asyncIoFile ASYNC_FILE, const void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER)
+{
+    return asyncIoQueueRequest(ASYNC_FILE, (void*) BUFFER, OFFSET, SIZE, TRUE, PRIORITY, CALLBACK, USER);
+}
+
+void asyncIoSubmit()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+
+    //Highest priority first, the rest wait for room
+    unsigned int count = 0;
+    for (unsigned int priority = 0; priority < ASYNC_IO_PRIORITY_MAX; ++priority)
+    {
+        while (state.inFlight + count < state.inFlightLimit)
+        {
+            unsigned int slot = asyncIoQueuePop(&state.queued[priority]);
+            if (slot == ASYNC_IO_NO_SLOT)
+            {
+                break;
+            }
+            state.slots[slot].state = ASYNC_IO_SLOT_IN_FLIGHT;
+            state.operations[count++] = state.slots[slot].operation;
+        }
+    }
+
+    if (count > 0)
+    {
+        platformAsyncIoSubmit(state.operations, count);
+        state.inFlight += count;
+    }
+}
+
+bool8 asyncIoPoll(asyncIoTicket TICKET, asyncIoResult* RESULT)
+{
+    asyncIoSlot* slot = asyncIoFindSlot(TICKET);
+    if (!slot || slot->callback)
+    {
+        RESULT->status = ASYNC_IO_STATUS_INVALID;
+        return FALSE;
+    }
+
+    if (slot->state != ASYNC_IO_SLOT_DONE)
+    {
+        asyncIoSubmit();
+        asyncIoReap(FALSE);
+    }
+    if (slot->state != ASYNC_IO_SLOT_DONE)
+    {
+        RESULT->status = ASYNC_IO_STATUS_PENDING;
+        return FALSE;
+    }
+
+    *RESULT = asyncIoMakeResult(slot);
+    asyncIoRelease(slot);
+    return TRUE;
+}
+
+asyncIoStatus asyncIoWait(asyncIoTicket TICKET, asyncIoResult* RESULT)
+{
+    asyncIoSlot* slot = asyncIoFindSlot(TICKET);
+    if (!slot)
+    {
+        RESULT->status = ASYNC_IO_STATUS_INVALID;
+        return ASYNC_IO_STATUS_INVALID;
+    }
+
+    //Anything queued ahead of it has to go first when there is no room in flight
+    while (slot->state != ASYNC_IO_SLOT_DONE)
+    {
+        asyncIoSubmit();
+        asyncIoReap(TRUE);
+    }
+
+    *RESULT = asyncIoMakeResult(slot);
+    if (!slot->callback)
+    {
+        asyncIoRelease(slot);
+    }
+    return RESULT->status;
+}
+
+
+// - - - Helpers - - -
+
+void asyncIoQueuePush(asyncIoQueue* QUEUE, unsigned int SLOT)
+{
+    state.slots[SLOT].next = ASYNC_IO_NO_SLOT;
+    if (QUEUE->head == ASYNC_IO_NO_SLOT)
+    {
+        QUEUE->head = SLOT;
+    }
+    else
+    {
+        state.slots[QUEUE->tail].next = SLOT;
+    }
+    QUEUE->tail = SLOT;
+}
+
+unsigned int asyncIoQueuePop(asyncIoQueue* QUEUE)
+{
+    unsigned int slot = QUEUE->head;
+    if (slot != ASYNC_IO_NO_SLOT)
+    {
+        QUEUE->head = state.slots[slot].next;
+    }
+    return slot;
+}
+
+asyncIoSlot* asyncIoFindSlot(asyncIoTicket TICKET)
+{
+    //Ticket zero wraps around to an out of range slot
+    unsigned int slot = (unsigned int) (TICKET & 0xFFFFFFFF) - 1;
+    if (!isInitialized || slot >= ASYNC_IO_MAX_REQUESTS)
+    {
+        return 0;
+    }
+
+    asyncIoSlot* found = &state.slots[slot];
+    if (found->state == ASYNC_IO_SLOT_FREE || found->generation != (unsigned int) (TICKET >> 32))
+    {
+        return 0;
+    }
+    return found;
+}
+
+asyncIoTicket asyncIoQueueRequest(asyncIoFile ASYNC_FILE, void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, bool8 IS_WRITE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER)
+{
+    if (!isInitialized || ASYNC_FILE == ASYNC_IO_INVALID_FILE || PRIORITY >= ASYNC_IO_PRIORITY_MAX)
+    {
+        return ASYNC_IO_INVALID_TICKET;
+    }
+
+    unsigned int slot = asyncIoQueuePop(&state.freeSlots);
+    if (slot == ASYNC_IO_NO_SLOT)
+    {
+        FORGE_LOG_WARNING("Async IO has %u requests outstanding, request dropped", ASYNC_IO_MAX_REQUESTS);
+        return ASYNC_IO_INVALID_TICKET;
+    }
+
+    asyncIoSlot* request = &state.slots[slot];
+    request->state = ASYNC_IO_SLOT_QUEUED;
+    request->operation.slot = slot;
+    request->operation.isWrite = IS_WRITE;
+    request->operation.priority = PRIORITY;
+    request->operation.file = ASYNC_FILE;
+    request->operation.buffer = BUFFER;
+    request->operation.size = SIZE;
+    request->operation.offset = OFFSET;
+    request->callback = CALLBACK;
+    request->user = USER;
+    request->result = 0;
+    asyncIoQueuePush(&state.queued[PRIORITY], slot);
+
+    return ((unsigned long long) request->generation << 32) | (slot + 1);
+}
+
+unsigned int asyncIoReap(bool8 WAIT)
+{
+    if (state.inFlight == 0)
+    {
+        return 0;
+    }
+
+    unsigned int count = platformAsyncIoReap(state.completions, state.inFlightLimit, WAIT);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        asyncIoSlot* slot = &state.slots[state.completions[i].slot];
+        slot->result = state.completions[i].result;
+        slot->state = ASYNC_IO_SLOT_DONE;
+        if (slot->callback)
+        {
+            asyncIoQueuePush(&state.finished, state.completions[i].slot);
+        }
+    }
+    state.inFlight -= count;
+    return count;
+}
+
+asyncIoResult asyncIoMakeResult(asyncIoSlot* SLOT)
+{
+    asyncIoResult result;
+    result.ticket = ((unsigned long long) SLOT->generation << 32) | (SLOT->operation.slot + 1);
+    result.status = SLOT->result < 0 ? ASYNC_IO_STATUS_FAILED : ASYNC_IO_STATUS_COMPLETE;
+    result.error = SLOT->result < 0 ? -SLOT->result : 0;
+    result.bytes = SLOT->result < 0 ? 0 : (unsigned int) SLOT->result;
+    result.buffer = SLOT->operation.buffer;
+    result.user = SLOT->user;
+    return result;
+}
+
+void asyncIoRelease(asyncIoSlot* SLOT)
+{
+    SLOT->state = ASYNC_IO_SLOT_FREE;
+    SLOT->generation++;
+    asyncIoQueuePush(&state.freeSlots, SLOT->operation.slot);
+}
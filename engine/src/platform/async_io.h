@@ -0,0 +1,141 @@
+#pragma once
+#include "defines.h"
+
+
+// - - - | Asynchronous File IO | - - -
+
+/*
+- - - | Never wait on the disk | - - -
+    Reads and writes are queued, handed to the kernel together and completed later, the frame thread never blocks on them.
+    On linux requests go through io_uring, when the kernel has none (or a sandbox forbids it) a small pool of threads
+    runs them with pread and pwrite instead. Windows runs them on the same kind of pool with ReadFile and WriteFile.
+    Short transfers are continued until done, only a read that reaches the end of the file completes short.
+    Data moves straight between the file and the caller's buffer, which must stay alive and untouched until the
+    request completes.
+
+    Requests queued during a frame are submitted together by asyncIoUpdate, or earlier by asyncIoSubmit.
+    High priority requests are submitted before lower ones whenever more are queued than can be in flight.
+    A request completes with a callback from asyncIoUpdate, or is polled for by its ticket when it has no callback.
+
+    Everything here is called from the main thread.
+*/
+
+
+// - - - Files
+typedef unsigned long long asyncIoFile;
+#define ASYNC_IO_INVALID_FILE 0
+
+typedef enum asyncIoOpenMode
+{
+    ASYNC_IO_OPEN_READ, //Existing file, read only
+    ASYNC_IO_OPEN_WRITE, //Created or truncated, write only
+    ASYNC_IO_OPEN_READ_WRITE //Created if missing, kept otherwise
+} asyncIoOpenMode;
+
+// - - - Requests
+typedef unsigned long long asyncIoTicket;
+#define ASYNC_IO_INVALID_TICKET 0
+
+typedef enum asyncIoPriority
+{
+    ASYNC_IO_PRIORITY_HIGH, //Needed this frame or the next, blocking streaming
+    ASYNC_IO_PRIORITY_NORMAL,
+    ASYNC_IO_PRIORITY_LOW, //Prefetching and background saves
+    ASYNC_IO_PRIORITY_MAX
+} asyncIoPriority;
+
+typedef enum asyncIoStatus
+{
+    ASYNC_IO_STATUS_INVALID, //Unknown or already collected ticket
+    ASYNC_IO_STATUS_PENDING,
+    ASYNC_IO_STATUS_COMPLETE,
+    ASYNC_IO_STATUS_FAILED
+} asyncIoStatus;
+
+typedef struct asyncIoResult
+{
+    asyncIoTicket ticket;
+    asyncIoStatus status;
+    int error; //errno value when the request failed, GetLastError on windows
+    unsigned int bytes; //Transferred, short when a read runs into the end of the file
+    void* buffer;
+    void* user;
+} asyncIoResult;
+
+typedef void (*asyncIoCallback)(const asyncIoResult* RESULT);
+
+
+// - - - | Async IO Functions | - - -
+
+
+// - - - System Functions - - -
+
+bool8 asyncIoInitialize();
+void asyncIoShutdown();
+
+// Submit what was queued and deliver completions. Called once a frame by the application
+void asyncIoUpdate();
+
+
+// - - - File Functions - - -
+
+FORGE_API asyncIoFile asyncIoOpen(const char* PATH, asyncIoOpenMode MODE);
+
+// Requests still using the file must have completed
+FORGE_API void asyncIoClose(asyncIoFile ASYNC_FILE);
+
+FORGE_API unsigned long long asyncIoGetFileSize(asyncIoFile ASYNC_FILE);
+
+
+// - - - Request Functions - - -
+
+// Returns ASYNC_IO_INVALID_TICKET when too many requests are outstanding. CALLBACK may be zero to poll instead. SIZE stays under 2 GB
+FORGE_API asyncIoTicket asyncIoRead(asyncIoFile ASYNC_FILE, void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER);
+FORGE_API asyncIoTicket asyncIoWrite(asyncIoFile ASYNC_FILE, const void* BUFFER, unsigned long long OFFSET, unsigned int SIZE, asyncIoPriority PRIORITY, asyncIoCallback CALLBACK, void* USER);
+
+// Hand everything queued to the kernel now instead of at the next asyncIoUpdate
+FORGE_API void asyncIoSubmit();
+
+// Requests without a callback: TRUE once finished, the ticket is released when the result is returned
+FORGE_API bool8 asyncIoPoll(asyncIoTicket TICKET, asyncIoResult* RESULT);
+
+// Block until the request finishes, for loading screens and shutdown. Releases the ticket like asyncIoPoll,
+// except for requests with a callback, which still get it from asyncIoUpdate
+FORGE_API asyncIoStatus asyncIoWait(asyncIoTicket TICKET, asyncIoResult* RESULT);
+
+
+// - - - | Platform Backend | - - -
+
+
+// - - - Operations
+typedef struct asyncIoOperation
+{
+    unsigned int slot; //Handed back with the completion
+    bool8 isWrite;
+    unsigned char priority;
+    asyncIoFile file;
+    void* buffer;
+    unsigned int size;
+    unsigned long long offset;
+} asyncIoOperation;
+
+typedef struct asyncIoCompletion
+{
+    unsigned int slot;
+    int result; //Bytes transferred, or a negative errno value
+} asyncIoCompletion;
+
+
+// - - - Backend Functions - - -
+
+// Slots are numbered below SLOTS. Returns how many operations may be in flight at once, zero on failure
+unsigned int platformAsyncIoInitialize(unsigned int SLOTS);
+
+// Only called once every submitted operation has been reaped
+void platformAsyncIoShutdown();
+
+// Start every operation given, the caller never goes over the in flight limit
+void platformAsyncIoSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT);
+
+// Collect finished operations, blocking until at least one finishes when WAIT is set
+unsigned int platformAsyncIoReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT);
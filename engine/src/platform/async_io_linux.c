@@ -0,0 +1,530 @@
+#include "async_io.h"
+#include "platform.h"
+#if FORGE_PLATFORM_LINUX
+
+#include "core/logger.h"
+#include "core/memory.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h> //Only the kernel interface, the ring is driven with raw system calls
+
+
+// - - - | Linux Async IO | - - -
+
+
+#define ASYNC_IO_RING_ENTRIES 128
+#define ASYNC_IO_POOL_THREADS 4
+#define ASYNC_IO_POOL_IN_FLIGHT 64
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+// - - - Request priorities as best effort IO priority levels, 0 is served first
+#define ASYNC_IO_PRIORITY_CLASS_BEST_EFFORT 2
+#define ASYNC_IO_PRIORITY_CLASS_SHIFT 13
+static const unsigned short ringPriorities[ASYNC_IO_PRIORITY_MAX] = {
+    (ASYNC_IO_PRIORITY_CLASS_BEST_EFFORT << ASYNC_IO_PRIORITY_CLASS_SHIFT) | 0,
+    (ASYNC_IO_PRIORITY_CLASS_BEST_EFFORT << ASYNC_IO_PRIORITY_CLASS_SHIFT) | 4,
+    (ASYNC_IO_PRIORITY_CLASS_BEST_EFFORT << ASYNC_IO_PRIORITY_CLASS_SHIFT) | 7};
+
+// - - - io_uring, shared with the kernel
+typedef struct asyncIoRing
+{
+    int descriptor;
+    unsigned int* submitHead; //Advanced by the kernel
+    unsigned int* submitTail;
+    unsigned int submitMask;
+    unsigned int* submitArray;
+    struct io_uring_sqe* entries;
+    unsigned int* completeHead;
+    unsigned int* completeTail; //Advanced by the kernel
+    unsigned int completeMask;
+    struct io_uring_cqe* completions;
+
+    void* submitMap;
+    unsigned long long submitMapSize;
+    void* completeMap;
+    unsigned long long completeMapSize;
+    unsigned long long entriesSize;
+
+    struct iovec* vectors; //One per slot, read by the kernel until the operation completes
+    asyncIoOperation* operations; //One per slot, kept to send the rest of a short transfer again
+    unsigned int* transferred; //Bytes of each slot's operation done so far
+    unsigned int slotCount;
+} asyncIoRing;
+
+// - - - Thread pool fallback
+typedef struct asyncIoPool
+{
+    pthread_t threads[ASYNC_IO_POOL_THREADS];
+    unsigned int threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t workReady;
+    pthread_cond_t workDone;
+    bool8 isStopping;
+
+    //Waiting operations by priority, each a ring of ASYNC_IO_POOL_IN_FLIGHT
+    asyncIoOperation pending[ASYNC_IO_PRIORITY_MAX][ASYNC_IO_POOL_IN_FLIGHT];
+    unsigned int pendingHead[ASYNC_IO_PRIORITY_MAX];
+    unsigned int pendingCount[ASYNC_IO_PRIORITY_MAX];
+
+    asyncIoCompletion completions[ASYNC_IO_POOL_IN_FLIGHT];
+    unsigned int completionCount;
+} asyncIoPool;
+
+static bool8 useRing;
+static asyncIoRing ring;
+static asyncIoPool* pool;
+
+// - - - Ring
+bool8 ringCreate(unsigned int SLOTS);
+void ringDestroy();
+void ringSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT);
+void ringQueue(unsigned int SLOT, unsigned int TAIL);
+unsigned int ringReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT);
+int ringEnter(unsigned int SUBMIT, unsigned int WAIT_FOR, unsigned int FLAGS);
+
+// - - - Pool
+bool8 poolCreate();
+void poolDestroy();
+void poolSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT);
+unsigned int poolReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT);
+void* poolThreadMain(void* UNUSED);
+
+
+// - - - | File Functions | - - -
+
+
+asyncIoFile asyncIoOpen(const char* PATH, asyncIoOpenMode MODE)
+{
+    int flags = O_CLOEXEC;
+    switch (MODE)
+    {
+        case ASYNC_IO_OPEN_READ:
+            flags |= O_RDONLY;
+            break;
+
+        case ASYNC_IO_OPEN_WRITE:
+            flags |= O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+
+        case ASYNC_IO_OPEN_READ_WRITE:
+            flags |= O_RDWR | O_CREAT;
+            break;
+    }
+
+    int descriptor = open(PATH, flags, 0644);
+    if (descriptor < 0)
+    {
+        FORGE_LOG_ERROR("Failed to open %s: %s", PATH, strerror(errno));
+        return ASYNC_IO_INVALID_FILE;
+    }
+    return (asyncIoFile) descriptor + 1; //Descriptor zero is valid, the invalid file is not
+}
+
+void asyncIoClose(asyncIoFile ASYNC_FILE)
+{
+    if (ASYNC_FILE != ASYNC_IO_INVALID_FILE)
+    {
+        close((int) (ASYNC_FILE - 1));
+    }
+}
+
+unsigned long long asyncIoGetFileSize(asyncIoFile ASYNC_FILE)
+{
+    struct stat status;
+    if (ASYNC_FILE == ASYNC_IO_INVALID_FILE || fstat((int) (ASYNC_FILE - 1), &status) != 0)
+    {
+        return 0;
+    }
+    return status.st_size;
+}
+
+
+// - - - | Backend Functions | - - -
+
+
+unsigned int platformAsyncIoInitialize(unsigned int SLOTS)
+{
+    //Kernels before 5.1, seccomp profiles of containers and kernel.io_uring_disabled all end up on the pool
+    useRing = ringCreate(SLOTS);
+    if (useRing)
+    {
+        FORGE_LOG_INFO("Async IO through io_uring, %u entries", ASYNC_IO_RING_ENTRIES);
+        return ASYNC_IO_RING_ENTRIES;
+    }
+
+    if (!poolCreate())
+    {
+        return 0;
+    }
+    FORGE_LOG_INFO("Async IO through %u threads", pool->threadCount);
+    return ASYNC_IO_POOL_IN_FLIGHT;
+}
+
+void platformAsyncIoShutdown()
+{
+    if (useRing)
+    {
+        ringDestroy();
+    }
+    else
+    {
+        poolDestroy();
+    }
+}
+
+void platformAsyncIoSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT)
+{
+    if (useRing)
+    {
+        ringSubmit(OPERATIONS, COUNT);
+    }
+    else
+    {
+        poolSubmit(OPERATIONS, COUNT);
+    }
+}
+
+unsigned int platformAsyncIoReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT)
+{
+    return useRing ? ringReap(COMPLETIONS, MAX, WAIT) : poolReap(COMPLETIONS, MAX, WAIT);
+}
+
+
+// - - - | io_uring | - - -
+
+
+bool8 ringCreate(unsigned int SLOTS)
+{
+    struct io_uring_params parameters;
+    memset(&parameters, 0, sizeof(parameters));
+    ring.descriptor = (int) syscall(__NR_io_uring_setup, ASYNC_IO_RING_ENTRIES, &parameters);
+    if (ring.descriptor < 0)
+    {
+        FORGE_LOG_INFO("io_uring is not available: %s", strerror(errno));
+        return FALSE;
+    }
+
+    //Both rings are one mapping on 5.4 and later
+    ring.submitMapSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned int);
+    ring.completeMapSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+    bool8 singleMap = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap && ring.completeMapSize > ring.submitMapSize)
+    {
+        ring.submitMapSize = ring.completeMapSize;
+    }
+
+    ring.submitMap = mmap(0, ring.submitMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, IORING_OFF_SQ_RING);
+    ring.completeMap = singleMap ? ring.submitMap : mmap(0, ring.completeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, IORING_OFF_CQ_RING);
+    ring.entriesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+    ring.entries = mmap(0, ring.entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, IORING_OFF_SQES);
+    if (ring.submitMap == MAP_FAILED || ring.completeMap == MAP_FAILED || ring.entries == MAP_FAILED)
+    {
+        FORGE_LOG_WARNING("Failed to map the io_uring rings: %s", strerror(errno));
+        if (ring.submitMap != MAP_FAILED)
+        {
+            munmap(ring.submitMap, ring.submitMapSize);
+        }
+        if (!singleMap && ring.completeMap != MAP_FAILED)
+        {
+            munmap(ring.completeMap, ring.completeMapSize);
+        }
+        if (ring.entries != MAP_FAILED)
+        {
+            munmap(ring.entries, ring.entriesSize);
+        }
+        close(ring.descriptor);
+        return FALSE;
+    }
+
+    unsigned char* submit = ring.submitMap;
+    ring.submitHead = (unsigned int*) (submit + parameters.sq_off.head);
+    ring.submitTail = (unsigned int*) (submit + parameters.sq_off.tail);
+    ring.submitMask = *(unsigned int*) (submit + parameters.sq_off.ring_mask);
+    ring.submitArray = (unsigned int*) (submit + parameters.sq_off.array);
+
+    unsigned char* complete = ring.completeMap;
+    ring.completeHead = (unsigned int*) (complete + parameters.cq_off.head);
+    ring.completeTail = (unsigned int*) (complete + parameters.cq_off.tail);
+    ring.completeMask = *(unsigned int*) (complete + parameters.cq_off.ring_mask);
+    ring.completions = (struct io_uring_cqe*) (complete + parameters.cq_off.cqes);
+
+    ring.slotCount = SLOTS;
+    ring.vectors = forgeAllocateMemory(sizeof(struct iovec) * SLOTS, MEMORY_TAG_FILE);
+    ring.operations = forgeAllocateMemory(sizeof(asyncIoOperation) * SLOTS, MEMORY_TAG_FILE);
+    ring.transferred = forgeAllocateMemory(sizeof(unsigned int) * SLOTS, MEMORY_TAG_FILE);
+    return TRUE;
+}
+
+void ringDestroy()
+{
+    if (ring.completeMap != ring.submitMap)
+    {
+        munmap(ring.completeMap, ring.completeMapSize);
+    }
+    munmap(ring.submitMap, ring.submitMapSize);
+    munmap(ring.entries, ring.entriesSize);
+    close(ring.descriptor);
+    forgeFreeMemory(ring.vectors, sizeof(struct iovec) * ring.slotCount, MEMORY_TAG_FILE);
+    forgeFreeMemory(ring.operations, sizeof(asyncIoOperation) * ring.slotCount, MEMORY_TAG_FILE);
+    forgeFreeMemory(ring.transferred, sizeof(unsigned int) * ring.slotCount, MEMORY_TAG_FILE);
+    memset(&ring, 0, sizeof(ring));
+}
+
+void ringSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT)
+{
+    //Only this thread writes the tail, the caller keeps the ring from overfilling
+    unsigned int tail = *ring.submitTail;
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        unsigned int slot = OPERATIONS[i].slot;
+        ring.operations[slot] = OPERATIONS[i];
+        ring.transferred[slot] = 0;
+        ringQueue(slot, tail++);
+    }
+    __atomic_store_n(ring.submitTail, tail, __ATOMIC_RELEASE);
+
+    //One system call for the whole batch. Whatever the kernel did not take stays in the ring for the next enter
+    unsigned int unsubmitted = tail - __atomic_load_n(ring.submitHead, __ATOMIC_ACQUIRE);
+    if (unsubmitted > 0 && ringEnter(unsubmitted, 0, 0) < 0 && errno != EAGAIN && errno != EBUSY && errno != EINTR)
+    {
+        FORGE_LOG_ERROR("io_uring submission failed: %s", strerror(errno));
+    }
+}
+
+void ringQueue(unsigned int SLOT, unsigned int TAIL)
+{
+    //Picks up where the slot's operation got to, from the start when it is new
+    const asyncIoOperation* operation = &ring.operations[SLOT];
+    unsigned int done = ring.transferred[SLOT];
+    struct iovec* vector = &ring.vectors[SLOT];
+    vector->iov_base = (unsigned char*) operation->buffer + done;
+    vector->iov_len = operation->size - done;
+
+    unsigned int index = TAIL & ring.submitMask;
+    struct io_uring_sqe* entry = &ring.entries[index];
+    memset(entry, 0, sizeof(*entry));
+    entry->opcode = operation->isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+    entry->fd = (int) (operation->file - 1);
+    entry->addr = (unsigned long long) vector;
+    entry->len = 1;
+    entry->off = operation->offset + done;
+    entry->ioprio = ringPriorities[operation->priority];
+    entry->user_data = SLOT;
+    ring.submitArray[index] = index;
+}
+
+unsigned int ringReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT)
+{
+    unsigned int count = 0;
+    do
+    {
+        unsigned int head = *ring.completeHead;
+        unsigned int tail = __atomic_load_n(ring.completeTail, __ATOMIC_ACQUIRE);
+        unsigned int unsubmitted = *ring.submitTail - __atomic_load_n(ring.submitHead, __ATOMIC_ACQUIRE);
+
+        if (head == tail && (WAIT || unsubmitted > 0))
+        {
+            //Retry anything a busy kernel turned down, and sleep in the same call
+            unsigned int flags = WAIT ? IORING_ENTER_GETEVENTS : 0;
+            while (ringEnter(unsubmitted, WAIT ? 1 : 0, flags) < 0 && errno == EINTR)
+            {
+            }
+            tail = __atomic_load_n(ring.completeTail, __ATOMIC_ACQUIRE);
+        }
+
+        //Short transfers go back for the rest like the pool loops over them, a read only stops early at the end of the file
+        unsigned int submitTail = *ring.submitTail;
+        while (head != tail && count < MAX)
+        {
+            struct io_uring_cqe* completion = &ring.completions[head & ring.completeMask];
+            unsigned int slot = (unsigned int) completion->user_data;
+            int result = completion->res;
+            ++head;
+
+            if (result == -EINTR || (result > 0 && ring.transferred[slot] + result < ring.operations[slot].size))
+            {
+                ring.transferred[slot] += result > 0 ? result : 0;
+                ringQueue(slot, submitTail++);
+                continue;
+            }
+            COMPLETIONS[count].slot = slot;
+            COMPLETIONS[count].result = result < 0 ? result : (int) (ring.transferred[slot] + result);
+            ++count;
+        }
+        __atomic_store_n(ring.completeHead, head, __ATOMIC_RELEASE);
+
+        //Resubmitted slots take the place of the ones they came from, the ring cannot overfill
+        if (submitTail != *ring.submitTail)
+        {
+            __atomic_store_n(ring.submitTail, submitTail, __ATOMIC_RELEASE);
+            if (!WAIT || count > 0)
+            {
+                ringEnter(submitTail - __atomic_load_n(ring.submitHead, __ATOMIC_ACQUIRE), 0, 0);
+            }
+        }
+    } while (WAIT && count == 0); //Still waiting when every completion was sent back for more
+    return count;
+}
+
+int ringEnter(unsigned int SUBMIT, unsigned int WAIT_FOR, unsigned int FLAGS)
+{
+    return (int) syscall(__NR_io_uring_enter, ring.descriptor, SUBMIT, WAIT_FOR, FLAGS, NULL, 0);
+}
+
+
+// - - - | Thread Pool | - - -
+
+
+bool8 poolCreate()
+{
+    pool = forgeAllocateMemory(sizeof(asyncIoPool), MEMORY_TAG_FILE);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    for (unsigned int i = 0; i < ASYNC_IO_POOL_THREADS; ++i)
+    {
+        if (pthread_create(&pool->threads[i], NULL, poolThreadMain, NULL) != 0)
+        {
+            break;
+        }
+        pool->threadCount++;
+    }
+
+    if (pool->threadCount == 0)
+    {
+        FORGE_LOG_ERROR("Failed to start any async IO threads");
+        poolDestroy();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void poolDestroy()
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->isStopping = TRUE;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned int i = 0; i < pool->threadCount; ++i)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->lock);
+    forgeFreeMemory(pool, sizeof(asyncIoPool), MEMORY_TAG_FILE);
+    pool = 0;
+}
+
+void poolSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT)
+{
+    pthread_mutex_lock(&pool->lock);
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        unsigned char priority = OPERATIONS[i].priority;
+        unsigned int index = (pool->pendingHead[priority] + pool->pendingCount[priority]) % ASYNC_IO_POOL_IN_FLIGHT;
+        pool->pending[priority][index] = OPERATIONS[i];
+        pool->pendingCount[priority]++;
+    }
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+unsigned int poolReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (WAIT && pool->completionCount == 0)
+    {
+        pthread_cond_wait(&pool->workDone, &pool->lock);
+    }
+
+    unsigned int count = pool->completionCount < MAX ? pool->completionCount : MAX;
+    memcpy(COMPLETIONS, pool->completions, sizeof(asyncIoCompletion) * count);
+    pool->completionCount -= count;
+    memmove(pool->completions, pool->completions + count, sizeof(asyncIoCompletion) * pool->completionCount);
+    pthread_mutex_unlock(&pool->lock);
+    return count;
+}
+
+void* poolThreadMain(void* UNUSED)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (TRUE)
+    {
+        //Always the most urgent operation waiting
+        int priority = -1;
+        for (unsigned int i = 0; i < ASYNC_IO_PRIORITY_MAX; ++i)
+        {
+            if (pool->pendingCount[i] > 0)
+            {
+                priority = i;
+                break;
+            }
+        }
+        if (priority < 0)
+        {
+            if (pool->isStopping)
+            {
+                break;
+            }
+            pthread_cond_wait(&pool->workReady, &pool->lock);
+            continue;
+        }
+
+        asyncIoOperation operation = pool->pending[priority][pool->pendingHead[priority]];
+        pool->pendingHead[priority] = (pool->pendingHead[priority] + 1) % ASYNC_IO_POOL_IN_FLIGHT;
+        pool->pendingCount[priority]--;
+        pthread_mutex_unlock(&pool->lock);
+
+        //Loop over short transfers, a read only stops early at the end of the file
+        int descriptor = (int) (operation.file - 1);
+        unsigned char* buffer = operation.buffer;
+        unsigned int done = 0;
+        int result = 0;
+        while (done < operation.size)
+        {
+            ssize_t moved = operation.isWrite ? pwrite(descriptor, buffer + done, operation.size - done, operation.offset + done) : pread(descriptor, buffer + done, operation.size - done, operation.offset + done);
+            if (moved < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                result = -errno;
+                break;
+            }
+            if (moved == 0)
+            {
+                break;
+            }
+            done += moved;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        asyncIoCompletion* completion = &pool->completions[pool->completionCount++];
+        completion->slot = operation.slot;
+        completion->result = result < 0 ? result : (int) done;
+        pthread_cond_signal(&pool->workDone);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#include "async_io.h"
+#include "platform.h"
+#if FORGE_PLATFORM_WINDOWS
+
+#include "core/logger.h"
+#include "core/memory.h"
+
+#include <string.h>
+#include <windows.h>
+
+
+// - - - | Windows Async IO | - - -
+
+#define ASYNC_IO_WIN32_THREADS 4
+#define ASYNC_IO_WIN32_IN_FLIGHT 64
+
+// - - - Thread pool, the same design as the linux fallback on the platform threads
+typedef struct asyncIoPool
+{
+    platformThread threads[ASYNC_IO_WIN32_THREADS];
+    unsigned int threadCount;
+    platformMutex lock;
+    platformSemaphore workReady; //One count per waiting operation, and one per thread when stopping
+    platformEvent workDone;
+    bool8 isStopping;
+
+    //Waiting operations by priority, each a ring of ASYNC_IO_WIN32_IN_FLIGHT
+    asyncIoOperation pending[ASYNC_IO_PRIORITY_MAX][ASYNC_IO_WIN32_IN_FLIGHT];
+    unsigned int pendingHead[ASYNC_IO_PRIORITY_MAX];
+    unsigned int pendingCount[ASYNC_IO_PRIORITY_MAX];
+
+    asyncIoCompletion completions[ASYNC_IO_WIN32_IN_FLIGHT];
+    unsigned int completionCount;
+} asyncIoPool;
+
+static asyncIoPool* pool;
+
+unsigned int poolThreadMain(void* UNUSED);
+
+
+// - - - | File Functions | - - -
+
+
+asyncIoFile asyncIoOpen(const char* PATH, asyncIoOpenMode MODE)
+{
+    DWORD access = GENERIC_READ;
+    DWORD disposition = OPEN_EXISTING;
+    switch (MODE)
+    {
+        case ASYNC_IO_OPEN_READ:
+            break;
+
+        case ASYNC_IO_OPEN_WRITE:
+            access = GENERIC_WRITE;
+            disposition = CREATE_ALWAYS;
+            break;
+
+        case ASYNC_IO_OPEN_READ_WRITE:
+            access = GENERIC_READ | GENERIC_WRITE;
+            disposition = OPEN_ALWAYS;
+            break;
+    }
+
+    HANDLE handle = CreateFileA(PATH, access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        FORGE_LOG_ERROR("Failed to open %s: error %lu", PATH, GetLastError());
+        return ASYNC_IO_INVALID_FILE;
+    }
+    return (asyncIoFile) handle;
+}
+
+void asyncIoClose(asyncIoFile ASYNC_FILE)
+{
+    if (ASYNC_FILE != ASYNC_IO_INVALID_FILE)
+    {
+        CloseHandle((HANDLE) ASYNC_FILE);
+    }
+}
+
+unsigned long long asyncIoGetFileSize(asyncIoFile ASYNC_FILE)
+{
+    LARGE_INTEGER size;
+    if (ASYNC_FILE == ASYNC_IO_INVALID_FILE || !GetFileSizeEx((HANDLE) ASYNC_FILE, &size))
+    {
+        return 0;
+    }
+    return size.QuadPart;
+}
+
+
+// - - - | Backend Functions | - - -
+
+
+unsigned int platformAsyncIoInitialize(unsigned int SLOTS)
+{
+    //Handles are opened without FILE_FLAG_OVERLAPPED, the offset in the OVERLAPPED lets the threads share one handle
+    pool = forgeAllocateMemory(sizeof(asyncIoPool), MEMORY_TAG_FILE);
+    platformEventInitialize(&pool->workDone, FALSE);
+
+    for (unsigned int i = 0; i < ASYNC_IO_WIN32_THREADS; ++i)
+    {
+        if (!platformThreadCreate(&pool->threads[pool->threadCount], "forge-async-io", poolThreadMain, 0))
+        {
+            break;
+        }
+        pool->threadCount++;
+    }
+
+    if (pool->threadCount == 0)
+    {
+        FORGE_LOG_ERROR("Failed to start any async IO threads");
+        forgeFreeMemory(pool, sizeof(asyncIoPool), MEMORY_TAG_FILE);
+        pool = 0;
+        return 0;
+    }
+    FORGE_LOG_INFO("Async IO through %u threads", pool->threadCount);
+    return ASYNC_IO_WIN32_IN_FLIGHT;
+}
+
+void platformAsyncIoShutdown()
+{
+    platformMutexLock(&pool->lock);
+    pool->isStopping = TRUE;
+    platformMutexUnlock(&pool->lock);
+    platformSemaphorePost(&pool->workReady, pool->threadCount);
+
+    for (unsigned int i = 0; i < pool->threadCount; ++i)
+    {
+        platformThreadJoin(&pool->threads[i]);
+    }
+
+    forgeFreeMemory(pool, sizeof(asyncIoPool), MEMORY_TAG_FILE);
+    pool = 0;
+}
+
+void platformAsyncIoSubmit(const asyncIoOperation* OPERATIONS, unsigned int COUNT)
+{
+    platformMutexLock(&pool->lock);
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        unsigned char priority = OPERATIONS[i].priority;
+        unsigned int index = (pool->pendingHead[priority] + pool->pendingCount[priority]) % ASYNC_IO_WIN32_IN_FLIGHT;
+        pool->pending[priority][index] = OPERATIONS[i];
+        pool->pendingCount[priority]++;
+    }
+    platformMutexUnlock(&pool->lock);
+    platformSemaphorePost(&pool->workReady, COUNT);
+}
+
+unsigned int platformAsyncIoReap(asyncIoCompletion* COMPLETIONS, unsigned int MAX, bool8 WAIT)
+{
+    platformMutexLock(&pool->lock);
+    while (WAIT && pool->completionCount == 0)
+    {
+        //The event stays set when a completion lands before the wait starts
+        platformMutexUnlock(&pool->lock);
+        platformEventWait(&pool->workDone);
+        platformMutexLock(&pool->lock);
+    }
+
+    unsigned int count = pool->completionCount < MAX ? pool->completionCount : MAX;
+    memcpy(COMPLETIONS, pool->completions, sizeof(asyncIoCompletion) * count);
+    pool->completionCount -= count;
+    memmove(pool->completions, pool->completions + count, sizeof(asyncIoCompletion) * pool->completionCount);
+    platformMutexUnlock(&pool->lock);
+    return count;
+}
+
+
+// - - - | Thread Pool | - - -
+
+
+unsigned int poolThreadMain(void* UNUSED)
+{
+    while (TRUE)
+    {
+        platformSemaphoreWait(&pool->workReady);
+
+        //Always the most urgent operation waiting
+        platformMutexLock(&pool->lock);
+        int priority = -1;
+        for (unsigned int i = 0; i < ASYNC_IO_PRIORITY_MAX; ++i)
+        {
+            if (pool->pendingCount[i] > 0)
+            {
+                priority = i;
+                break;
+            }
+        }
+        if (priority < 0)
+        {
+            bool8 isStopping = pool->isStopping;
+            platformMutexUnlock(&pool->lock);
+            if (isStopping)
+            {
+                break;
+            }
+            continue;
+        }
+
+        asyncIoOperation operation = pool->pending[priority][pool->pendingHead[priority]];
+        pool->pendingHead[priority] = (pool->pendingHead[priority] + 1) % ASYNC_IO_WIN32_IN_FLIGHT;
+        pool->pendingCount[priority]--;
+        platformMutexUnlock(&pool->lock);
+
+        //Loop over short transfers, a read only stops early at the end of the file
+        HANDLE handle = (HANDLE) operation.file;
+        unsigned char* buffer = operation.buffer;
+        unsigned int done = 0;
+        int result = 0;
+        while (done < operation.size)
+        {
+            unsigned long long offset = operation.offset + done;
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD) offset;
+            overlapped.OffsetHigh = (DWORD) (offset >> 32);
+
+            DWORD moved = 0;
+            BOOL success = operation.isWrite ? WriteFile(handle, buffer + done, operation.size - done, &moved, &overlapped) : ReadFile(handle, buffer + done, operation.size - done, &moved, &overlapped);
+            if (!success)
+            {
+                DWORD error = GetLastError();
+                if (error != ERROR_HANDLE_EOF)
+                {
+                    result = -(int) error;
+                }
+                break;
+            }
+            if (moved == 0)
+            {
+                break;
+            }
+            done += moved;
+        }
+
+        platformMutexLock(&pool->lock);
+        asyncIoCompletion* completion = &pool->completions[pool->completionCount++];
+        completion->slot = operation.slot;
+        completion->result = result < 0 ? result : (int) done;
+        platformMutexUnlock(&pool->lock);
+        platformEventSet(&pool->workDone);
+    }
+    return 0;
+}
+
+#endif //FORGE_PLATFORM_WINDOWS
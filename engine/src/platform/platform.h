@@ -5,8 +5,128 @@
 typedef struct platformState
 {
     void* internalState;
+    bool8 isHeadless; //Set before platformInit to run without a display or window
 } platformState;
 
+// - - - File Mapping Advice
+typedef enum platformMappingAdvice
+{
+    PLATFORM_MAPPING_WILL_NEED, //Start reading the range in now
+    PLATFORM_MAPPING_DONT_NEED, //Drop the range's pages, they are read again when touched
+    PLATFORM_MAPPING_SEQUENTIAL,
+    PLATFORM_MAPPING_RANDOM
+} platformMappingAdvice;
+
+// - - - Writable File Mappings
+typedef struct platformWritableMapping
+{
+    void* memory; //Zero while nothing is mapped
+    unsigned long long size;
+    unsigned long long file; //Descriptor on linux, a file HANDLE on windows, kept open to flush and trim through
+} platformWritableMapping;
+
+// - - - Synthetic Events
+// Stands in for window messages on a headless platform. Raise input through the input process functions or post events, return FALSE to quit
+typedef bool8 (*platformSyntheticEventSource)(double TIME, void* USER);
+
+// - - - Console Output
+typedef struct platformConsoleBuffer
+{
+    const char* text; //Terminated right after length, the windows debugger output takes C strings
+    unsigned int length;
+    unsigned char color; //Log level, as for platformWriteConsole
+} platformConsoleBuffer;
+
+// - - - Threads
+typedef struct platformThread
+{
+    unsigned long long handle; //pthread_t on linux, a thread HANDLE on windows, zero when not running
+} platformThread;
+
+typedef unsigned int (*platformThreadFunction)(void* ARGUMENT);
+
+// - - - Synchronisation
+// Plain words waited on through the kernel (futex, WaitOnAddress). Zeroed memory is a ready unlocked mutex, an unset event and an empty semaphore, none need destroying
+typedef struct platformMutex
+{
+    unsigned int state; //0 unlocked, 1 locked, 2 locked with threads waiting
+} platformMutex;
+
+typedef struct platformEvent
+{
+    unsigned int isSet;
+    bool8 isManualReset; //Manual reset events release every waiter and stay set until reset, others release one waiter and clear
+} platformEvent;
+
+typedef struct platformSemaphore
+{
+    unsigned int count;
+    unsigned int waiters;
+} platformSemaphore;
+
+typedef unsigned long long platformTlsKey;
+
+// Spin wait hint, lets the sibling hyperthread run while this one waits on memory
+#if defined(__x86_64__) || defined(__i386__)
+#define PLATFORM_SPIN_PAUSE() __builtin_ia32_pause()
+#else
+#define PLATFORM_SPIN_PAUSE()
+#endif
+
+// - - - CPU Topology
+typedef struct platformCpuInfo
+{
+    unsigned int logicalCores; //Online in the system
+    unsigned int physicalCores;
+    unsigned int packages;
+    unsigned int cacheLineSize; //Bytes, cache sizes are per core for L1 and L2, usually shared for L3
+    unsigned int l1DataCacheSize;
+    unsigned int l2CacheSize;
+    unsigned int l3CacheSize;
+} platformCpuInfo;
+
+// - - - CPU Features, only set when the OS also saves the registers they use
+typedef enum platformCpuFeature
+{
+    PLATFORM_CPU_SSE2 = 1 << 0,
+    PLATFORM_CPU_SSE41 = 1 << 1,
+    PLATFORM_CPU_SSE42 = 1 << 2,
+    PLATFORM_CPU_POPCNT = 1 << 3,
+    PLATFORM_CPU_AVX = 1 << 4,
+    PLATFORM_CPU_AVX2 = 1 << 5,
+    PLATFORM_CPU_FMA = 1 << 6,
+    PLATFORM_CPU_BMI2 = 1 << 7,
+    PLATFORM_CPU_AVX512F = 1 << 8,
+    PLATFORM_CPU_AVX512BW = 1 << 9,
+    PLATFORM_CPU_AVX512VL = 1 << 10,
+    PLATFORM_CPU_NEON = 1 << 11,
+    PLATFORM_CPU_FEATURE_COUNT = 12
+} platformCpuFeature;
+
+// - - - Performance Counters
+typedef enum platformCounter
+{
+    PLATFORM_COUNTER_CYCLES,
+    PLATFORM_COUNTER_INSTRUCTIONS,
+    PLATFORM_COUNTER_CACHE_MISSES, //Last level cache, requests that went out to memory
+    PLATFORM_COUNTER_BRANCH_MISSES,
+    PLATFORM_COUNTER_MAX
+} platformCounter;
+
+// Counts for the thread that opened the group, running totals since it was opened
+typedef struct platformCounterValues
+{
+    unsigned long long values[PLATFORM_COUNTER_MAX];
+} platformCounterValues;
+
+typedef struct platformCounterGroup
+{
+    void* internalState; //Zero when the counters could not be opened
+    unsigned int available; //Bit per platformCounter that is actually counting
+} platformCounterGroup;
+
+#define PLATFORM_THREAD_NAME_LENGTH 16 //Linux keeps 15 characters and a terminator, longer names are cut
+
 
 // - - - | Platform Functions | - - -
 
@@ -20,6 +140,28 @@ void platformShutdown(platformState* STATE);
 bool8 platformGiveMessages(platformState* STATE);
 
 
+// - - - Input Thread Functions - - -
+
+// Read input on its own thread, stamping every message as it arrives. platformGiveMessages then hands over what the thread collected.
+// Linux only, other platforms return false and keep reading input once per frame
+bool8 platformStartInputThread(platformState* STATE);
+
+void platformStopInputThread(platformState* STATE);
+
+
+// - - - Headless Functions - - -
+
+// Called once per platformGiveMessages on a headless platform, zero removes it
+void platformSetSyntheticEventSource(platformState* STATE, platformSyntheticEventSource SOURCE, void* USER);
+
+// The OS platforms hand over to these when isHeadless is set, timing and memory stay with the OS
+bool8 platformHeadlessInit(platformState* STATE);
+
+void platformHeadlessShutdown(platformState* STATE);
+
+bool8 platformHeadlessGiveMessages(platformState* STATE);
+
+
 // - - - Memory Functions - - -
 
 void* platformAllocateMemory(unsigned long long SIZE, bool8 ALIGNED);
@@ -33,15 +175,145 @@ void* platformCopyMemory(void* DESTINATION, const void* SOURCE, unsigned long lo
 void* platformSetMemory(void* DESTINATION, int VALUE, unsigned long long SIZE);
 
 
+// - - - File Mapping Functions - - -
+
+// Map a whole file read only. POPULATE reads it all in before returning. Empty files succeed with no memory
+bool8 platformMapFile(const char* PATH, bool8 POPULATE, void** MEMORY, unsigned long long* SIZE);
+
+void platformUnmapFile(void* MEMORY, unsigned long long SIZE);
+
+// MEMORY does not have to be page aligned, the advice covers every page the range touches
+void platformAdviseMapping(void* MEMORY, unsigned long long SIZE, platformMappingAdvice ADVICE);
+
+bool8 platformGetFileSize(const char* PATH, unsigned long long* SIZE);
+
+// Create PATH, or empty it, and map SIZE bytes of it for writing. The disk space is reserved up front where the file system allows,
+// what is written to the memory reaches the file even if the process dies
+bool8 platformMapFileForWriting(const char* PATH, unsigned long long SIZE, platformWritableMapping* MAPPING);
+
+// Start writing the first SIZE bytes back to the file. WAIT returns only once they are on the disk, which only matters if the machine goes down
+void platformFlushMapping(const platformWritableMapping* MAPPING, unsigned long long SIZE, bool8 WAIT);
+
+// Unmap, cut the file down to the WRITTEN_SIZE bytes actually used and close it. MAPPING is left empty
+void platformUnmapFileForWriting(platformWritableMapping* MAPPING, unsigned long long WRITTEN_SIZE);
+
+
 // - - - Writing Functions - - - 
 
 void platformWriteConsole(const char* MESSAGE, unsigned char COLOR);
 
 void platformWriteConsoleError(const char* MESSAGE, unsigned char COLOR);
 
+// Many messages, each in its own color unless USE_COLOR is clear, in as few system calls as possible. Returns once all of it is written
+void platformWriteConsoleBuffers(const platformConsoleBuffer* BUFFERS, unsigned int COUNT, bool8 IS_ERROR, bool8 USE_COLOR);
+
 
 // - - - Time and Sleep Functions - - -
 
 void platformSleep(unsigned long long MILLISECONDS);
 
+// Sleep until platformGetTicks reaches TICKS, returns at once if it already has. Wakes up late by the scheduler's granularity
+void platformSleepUntil(unsigned long long TICKS);
+
+// Nanoseconds on a monotonic clock, from the TSC when it is invariant. Cheap enough to stamp profiling zones with
+unsigned long long platformGetTicks();
+
+// Seconds, platformGetTicks as a double
 double platformGetTime();
+
+
+// - - - Thread Functions - - -
+
+// NAME shows up in debuggers and profilers. Returns FALSE when the thread could not start
+bool8 platformThreadCreate(platformThread* THREAD, const char* NAME, platformThreadFunction FUNCTION, void* ARGUMENT);
+
+// Wait for the thread to finish and return what its function returned
+unsigned int platformThreadJoin(platformThread* THREAD);
+
+// Keep the thread on one logical core, numbered as the OS numbers them
+bool8 platformThreadSetAffinity(platformThread* THREAD, unsigned int LOGICAL_CORE);
+
+bool8 platformThreadSetCurrentName(const char* NAME);
+
+unsigned long long platformThreadGetCurrentId();
+
+void platformThreadYield();
+
+
+// - - - Futex Functions - - -
+
+// Sleep while *ADDRESS still holds EXPECTED. May return early for no reason, callers check again
+void platformFutexWait(unsigned int* ADDRESS, unsigned int EXPECTED);
+
+#define PLATFORM_FUTEX_WAKE_ALL 0xFFFFFFFFu
+void platformFutexWake(unsigned int* ADDRESS, unsigned int COUNT);
+
+
+// - - - Mutex Functions - - -
+
+// Take the lock with one atomic when nobody holds it, spin briefly, and only then sleep in the kernel
+void platformMutexLock(platformMutex* MUTEX);
+
+bool8 platformMutexTryLock(platformMutex* MUTEX);
+
+void platformMutexUnlock(platformMutex* MUTEX);
+
+
+// - - - Event Functions - - -
+
+void platformEventInitialize(platformEvent* EVENT, bool8 MANUAL_RESET);
+
+void platformEventSet(platformEvent* EVENT);
+
+void platformEventReset(platformEvent* EVENT);
+
+void platformEventWait(platformEvent* EVENT);
+
+
+// - - - Semaphore Functions - - -
+
+void platformSemaphoreInitialize(platformSemaphore* SEMAPHORE, unsigned int COUNT);
+
+void platformSemaphorePost(platformSemaphore* SEMAPHORE, unsigned int COUNT);
+
+void platformSemaphoreWait(platformSemaphore* SEMAPHORE);
+
+bool8 platformSemaphoreTryWait(platformSemaphore* SEMAPHORE);
+
+
+// - - - Thread Local Storage Functions - - -
+
+// For storage created at run time, static per thread variables should use _Thread_local instead
+bool8 platformTlsAllocate(platformTlsKey* KEY);
+
+void platformTlsFree(platformTlsKey KEY);
+
+void platformTlsSet(platformTlsKey KEY, void* VALUE);
+
+void* platformTlsGet(platformTlsKey KEY);
+
+
+// - - - CPU Topology Functions - - -
+
+// Read once and cached, cheap to call again
+void platformGetCpuInfo(platformCpuInfo* INFO);
+
+// One logical core per physical core this process may run on, the first hyperthread of each. Returns how many were written.
+// Pin one worker to each to fill the machine without two workers fighting over a core
+unsigned int platformGetWorkerCores(unsigned int* LOGICAL_CORES, unsigned int MAX);
+
+// platformCpuFeature flags of the running CPU, cpuid on x86 and hardware capabilities on ARM. Read once and cached
+unsigned int platformGetCpuFeatures();
+
+
+// - - - Performance Counter Functions - - -
+
+// Open hardware counters for the calling thread. FALSE when the OS does not allow it (perf_event_paranoid, containers, VMs),
+// the group then reads as zeros. Counters the processor lacks are left out of available
+bool8 platformCountersOpen(platformCounterGroup* GROUP);
+
+void platformCountersClose(platformCounterGroup* GROUP);
+
+// Only from the thread that opened the group. Reads the counter registers directly when the kernel allows it,
+// cheap enough to bracket profiling zones with
+void platformCountersRead(const platformCounterGroup* GROUP, platformCounterValues* VALUES);
@@ -0,0 +1,123 @@
+#include "platform.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__arm__) && FORGE_PLATFORM_LINUX
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+
+// - - - | CPU Features | - - -
+
+
+static bool8 featuresRead = FALSE;
+static unsigned int features;
+
+unsigned int readCpuFeatures();
+
+
+// - - - x86, cpuid says what the processor has and xgetbv whether the OS saves the wider registers on a switch
+#if defined(__x86_64__) || defined(__i386__)
+
+#define CPUID_1_ECX_SSE41 (1u << 19)
+#define CPUID_1_ECX_SSE42 (1u << 20)
+#define CPUID_1_ECX_POPCNT (1u << 23)
+#define CPUID_1_ECX_FMA (1u << 12)
+#define CPUID_1_ECX_OSXSAVE (1u << 27)
+#define CPUID_1_ECX_AVX (1u << 28)
+#define CPUID_1_EDX_SSE2 (1u << 26)
+#define CPUID_7_EBX_AVX2 (1u << 5)
+#define CPUID_7_EBX_BMI2 (1u << 8)
+#define CPUID_7_EBX_AVX512F (1u << 16)
+#define CPUID_7_EBX_AVX512BW (1u << 30)
+#define CPUID_7_EBX_AVX512VL (1u << 31)
+
+#define XCR0_AVX_STATE 0x06 //XMM and YMM registers
+#define XCR0_AVX512_STATE 0xE0 //Opmask and the upper ZMM registers
+
+unsigned int readCpuFeatures()
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int found = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+
+    found |= edx & CPUID_1_EDX_SSE2 ? PLATFORM_CPU_SSE2 : 0;
+    found |= ecx & CPUID_1_ECX_SSE41 ? PLATFORM_CPU_SSE41 : 0;
+    found |= ecx & CPUID_1_ECX_SSE42 ? PLATFORM_CPU_SSE42 : 0;
+    found |= ecx & CPUID_1_ECX_POPCNT ? PLATFORM_CPU_POPCNT : 0;
+
+    //Without OS support the YMM and ZMM registers would be lost on every context switch
+    unsigned long long enabledState = 0;
+    if (ecx & CPUID_1_ECX_OSXSAVE)
+    {
+        unsigned int low, high;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        enabledState = ((unsigned long long) high << 32) | low;
+    }
+    bool8 hasAvxState = (enabledState & XCR0_AVX_STATE) == XCR0_AVX_STATE;
+    bool8 hasAvx512State = hasAvxState && (enabledState & XCR0_AVX512_STATE) == XCR0_AVX512_STATE;
+
+    if (hasAvxState && (ecx & CPUID_1_ECX_AVX))
+    {
+        found |= PLATFORM_CPU_AVX;
+        found |= ecx & CPUID_1_ECX_FMA ? PLATFORM_CPU_FMA : 0;
+    }
+
+    unsigned int extendedEcx, extendedEdx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &extendedEcx, &extendedEdx))
+    {
+        found |= ebx & CPUID_7_EBX_BMI2 ? PLATFORM_CPU_BMI2 : 0;
+        if (found & PLATFORM_CPU_AVX)
+        {
+            found |= ebx & CPUID_7_EBX_AVX2 ? PLATFORM_CPU_AVX2 : 0;
+        }
+        if (hasAvx512State)
+        {
+            found |= ebx & CPUID_7_EBX_AVX512F ? PLATFORM_CPU_AVX512F : 0;
+            found |= ebx & CPUID_7_EBX_AVX512BW ? PLATFORM_CPU_AVX512BW : 0;
+            found |= ebx & CPUID_7_EBX_AVX512VL ? PLATFORM_CPU_AVX512VL : 0;
+        }
+    }
+    return found;
+}
+
+// - - - 64 bit ARM always has Advanced SIMD
+#elif defined(__aarch64__)
+
+unsigned int readCpuFeatures()
+{
+    return PLATFORM_CPU_NEON;
+}
+
+// - - - 32 bit ARM, the kernel reports NEON in the hardware capabilities
+#elif defined(__arm__) && FORGE_PLATFORM_LINUX
+
+unsigned int readCpuFeatures()
+{
+    return getauxval(AT_HWCAP) & HWCAP_NEON ? PLATFORM_CPU_NEON : 0;
+}
+
+#else
+
+// - - - Other architectures are not probed and always use the portable kernels
+unsigned int readCpuFeatures()
+{
+    return 0;
+}
+
+#endif
+
+
+unsigned int platformGetCpuFeatures()
+{
+    if (!featuresRead)
+    {
+        features = readCpuFeatures();
+        featuresRead = TRUE;
+    }
+    return features;
+}
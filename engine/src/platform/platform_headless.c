@@ -0,0 +1,65 @@
+#include "platform.h"
+#include "core/logger.h"
+#include "core/input.h"
+
+
+// - - - | Headless Platform | - - -
+
+/*
+- - - | No display | - - -
+    Dedicated servers and CI boxes have no X server or desktop to open a window on.
+    A headless platform opens nothing, its messages come from a synthetic event source instead of a window.
+    Time, sleep, memory and console output are the OS platform's own, so frame timings match a windowed run.
+*/
+
+
+// - - - Platform state
+typedef struct headlessState
+{
+    platformSyntheticEventSource source;
+    void* user;
+} headlessState;
+
+
+// - - - | Headless Functions | - - -
+
+
+bool8 platformHeadlessInit(platformState* STATE)
+{
+    STATE->internalState = platformAllocateMemory(sizeof(headlessState), FALSE);
+    platformZeroMemory(STATE->internalState, sizeof(headlessState));
+    FORGE_LOG_INFO("Running headless, no window will be opened");
+    return TRUE;
+}
+
+void platformHeadlessShutdown(platformState* STATE)
+{
+    platformFreeMemory(STATE->internalState, FALSE);
+    STATE->internalState = 0;
+}
+
+bool8 platformHeadlessGiveMessages(platformState* STATE)
+{
+    headlessState* state = (headlessState*)STATE->internalState;
+    if (!state->source)
+    {
+        return TRUE;
+    }
+    //Synthetic input is stamped like a windowed pump stamps its messages
+    double now = platformGetTime();
+    inputSetEventTime(now);
+    return state->source(now, state->user);
+}
+
+void platformSetSyntheticEventSource(platformState* STATE, platformSyntheticEventSource SOURCE, void* USER)
+{
+    if (!STATE->isHeadless)
+    {
+        FORGE_LOG_WARNING("Synthetic events only replace the messages of a headless platform");
+        return;
+    }
+
+    headlessState* state = (headlessState*)STATE->internalState;
+    state->source = SOURCE;
+    state->user = USER;
+}
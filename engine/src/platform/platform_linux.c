@@ -4,6 +4,7 @@
 #include "core/logger.h"
 #include "core/input.h"
 #include "core/event.h"
+#include "platform/platform_linux_gamepad.h"
 
 #include <dataStructures/list.h>
 
@@ -27,6 +28,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 #define VK_USE_PLATFORM_XCB_KHR
 #include <vulkan/vulkan.h>
@@ -35,6 +50,52 @@
 // - - - Key Transaltion
 keys translateKeycode(unsigned int X_KEYCODE);
 
+// - - - Input Thread
+#define PLATFORM_INPUT_QUEUE_CAPACITY 4096 //Power of two
+#define PLATFORM_INPUT_POLL_MILLISECONDS 2 //Other threads talking to X can pull events into xcb's queue without waking poll
+#define PLATFORM_GAMEPAD_SCAN_INTERVAL 2.0
+
+// - - - Tick Clock
+#define PLATFORM_TICK_CALIBRATION_MILLISECONDS 20
+#define PLATFORM_TICK_CALIBRATION_SAMPLES 8
+#define PLATFORM_TICK_REANCHOR_NANOSECONDS 1000000000ULL //How often ticks are checked against CLOCK_MONOTONIC again
+#define PLATFORM_TICK_MAX_CORRECTION 0.001 //Largest change of the tick rate used to close the gap, ticks never jump
+
+typedef struct tickClock
+{
+    bool8 useTimestampCounter; //Set once calibration succeeded, until then ticks come from clock_gettime
+    unsigned int sequence; //Odd while the anchor below is being replaced
+    unsigned long long baseCounter;
+    unsigned long long baseTicks; //Ticks at baseCounter
+    unsigned long long multiplier; //Nanoseconds per counter tick in 32.32 fixed point
+    unsigned long long anchorTime; //CLOCK_MONOTONIC nanoseconds at baseCounter
+    unsigned long long reanchorCounts; //Counter ticks between anchors
+    bool8 isReanchoring;
+} tickClock;
+
+static tickClock tickState;
+
+void calibrateTickClock();
+
+void reanchorTickClock();
+
+// - - - Message Batches
+#define PLATFORM_MESSAGE_BATCH_CAPACITY 512
+
+typedef struct platformWindowMessage
+{
+    double timestamp;
+    xcb_generic_event_t* event;
+    bool8 isCollapsed; //Superseded by a later message of the same kind, only freed
+} platformWindowMessage;
+
+typedef struct platformInputEntry
+{
+    double timestamp;
+    xcb_generic_event_t* event; //Window message, zero for gamepad entries. Freed by the main thread
+    platformGamepadEvent gamepad;
+} platformInputEntry;
+
 // - - - Platform state 
 typedef struct internalState
 {
@@ -45,8 +106,35 @@ typedef struct internalState
     xcb_atom_t windowProtocols;
     xcb_atom_t windowDelete;
     VkSurfaceKHR surface;
+    unsigned char keyTable[256]; //X keycode to keys, rebuilt whenever the keyboard mapping changes
+    unsigned short width;
+    unsigned short height;
+
+    //Input thread, a single producer single consumer ring from the thread to the message pump
+    pthread_t inputThread;
+    bool8 inputThreadRunning;
+    bool8 inputThreadFailed;
+    int inputWakeDescriptor;
+    platformInputEntry* inputQueue;
+    unsigned int inputHead; //Written by the input thread
+    unsigned int inputTail; //Written by the message pump
+
+    //Messages of one pump, handled by kind and freed together
+    platformWindowMessage batch[PLATFORM_MESSAGE_BATCH_CAPACITY];
+    unsigned int batchCount;
 } internalState;
 
+// - - - Key Table
+void buildKeyTable(internalState* STATE);
+
+// - - - Message Handling
+bool8 handleWindowEvents(internalState* STATE);
+bool8 handleWindowEvent(internalState* STATE, xcb_generic_event_t* EVENT);
+void handleGamepadEvent(platformGamepadEvent EVENT);
+void* inputThreadMain(void* STATE);
+void queueGamepadEvent(double TIMESTAMP, platformGamepadEvent EVENT, void* STATE);
+bool8 queueInputEntry(internalState* STATE, platformInputEntry* ENTRY);
+
 
 // - - - | Platform Functions | - - -
 
@@ -55,9 +143,21 @@ typedef struct internalState
 
 bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y, int WIDTH, int HEIGHT)
 {
+    //Before any other thread starts reading the clock
+    calibrateTickClock();
+
+    if (STATE->isHeadless)
+    {
+        return platformHeadlessInit(STATE);
+    }
+
     STATE->internalState = malloc(sizeof(internalState));
     internalState* state = (internalState*)STATE->internalState;
-    
+    memset(state, 0, sizeof(internalState));
+
+    //The input thread reads the connection while this thread renders through it
+    XInitThreads();
+
     //Connect to X
     state->display = XOpenDisplay(NULL);
     
@@ -73,6 +173,9 @@ bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y,
         return FALSE;
     }
 
+    //Events are read through xcb, keep Xlib from competing for them
+    XSetEventQueueOwner(state->display, XCBOwnsEventQueue);
+
     //Get data from X server
     const struct xcb_setup_t* setup = xcb_get_setup(state->connection);
 
@@ -85,6 +188,9 @@ bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y,
     }
     state->screen = iterator.data;
 
+    state->width = WIDTH;
+    state->height = HEIGHT;
+
     //Allocate a XID for the window to be created
     state->window = xcb_generate_id(state->connection);
 
@@ -177,100 +283,466 @@ bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y,
     }
 
     XAutoRepeatOn(state->display);
+
+    //Translate every keycode once up front instead of on every key event
+    buildKeyTable(state);
     return TRUE;
 }
 
 void platformShutdown(platformState* STATE)
 {
+    if (STATE->isHeadless)
+    {
+        platformHeadlessShutdown(STATE);
+        return;
+    }
+
     internalState* state = (internalState*)STATE->internalState;
+    platformStopInputThread(STATE);
     XAutoRepeatOn(state->display);
     xcb_destroy_window(state->connection, state->window);
 }
 
 bool8 platformGiveMessages(platformState* STATE)
 {
+    if (STATE->isHeadless)
+    {
+        return platformHeadlessGiveMessages(STATE);
+    }
+
     internalState* state = (internalState*)STATE->internalState;
-    xcb_generic_event_t* event;
-    xcb_client_message_event_t* clientMessage;
     bool8 quitFlag = FALSE;
-    
-    while ((event = xcb_poll_for_event(state->connection)))
+    state->batchCount = 0;
+
+    if (__atomic_load_n(&state->inputThreadRunning, __ATOMIC_ACQUIRE))
     {
-        if (event == 0)
+        //Hand over everything the input thread collected since the last frame
+        unsigned int tail = state->inputTail;
+        unsigned int head = __atomic_load_n(&state->inputHead, __ATOMIC_ACQUIRE);
+        while (tail != head)
         {
-            break;
+            platformInputEntry* entry = &state->inputQueue[tail & (PLATFORM_INPUT_QUEUE_CAPACITY - 1)];
+            if (entry->event)
+            {
+                if (state->batchCount == PLATFORM_MESSAGE_BATCH_CAPACITY)
+                {
+                    quitFlag |= handleWindowEvents(state);
+                }
+                platformWindowMessage* message = &state->batch[state->batchCount++];
+                message->timestamp = entry->timestamp;
+                message->event = entry->event;
+                message->isCollapsed = FALSE;
+            }
+            else
+            {
+                inputSetEventTime(entry->timestamp);
+                handleGamepadEvent(entry->gamepad);
+            }
+            ++tail;
         }
+        __atomic_store_n(&state->inputTail, tail, __ATOMIC_RELEASE);
+        quitFlag |= handleWindowEvents(state);
 
-        switch (event->response_type & ~0x80) //Documentation says so, do not question this number
+        if (__atomic_load_n(&state->inputThreadFailed, __ATOMIC_ACQUIRE))
         {
-            case XCB_KEY_PRESS:
+            FORGE_LOG_FATAL("Lost the connection to the X server");
+            quitFlag = TRUE;
+        }
+        return !quitFlag;
+    }
 
-            case XCB_KEY_RELEASE:
-            {
-                xcb_key_press_event_t* keyEvent = (xcb_key_press_event_t *) event;
-                bool8 pressed = event->response_type == XCB_KEY_PRESS;
-                xcb_keycode_t code = keyEvent->detail;
-                KeySym keySym = XkbKeycodeToKeysym(state->display, (KeyCode) code, 0, code & ShiftMask ? 1 : 0);
-                keys key = translateKeycode(keySym);
-                inputProcessKey(key, pressed);
-            } 
-            break;
+    //One read from the socket, then only what that read brought in
+    double now = platformGetTime();
+    xcb_generic_event_t* event = xcb_poll_for_event(state->connection);
+    while (event)
+    {
+        if (state->batchCount == PLATFORM_MESSAGE_BATCH_CAPACITY)
+        {
+            quitFlag |= handleWindowEvents(state);
+        }
+        platformWindowMessage* message = &state->batch[state->batchCount++];
+        message->timestamp = now;
+        message->event = event;
+        message->isCollapsed = FALSE;
+        event = xcb_poll_for_queued_event(state->connection);
+    }
+    quitFlag |= handleWindowEvents(state);
+    return !quitFlag;
+}
 
-            case XCB_BUTTON_PRESS:
 
-            case XCB_BUTTON_RELEASE:
-            {
-                xcb_button_press_event_t* mouseEvent = (xcb_button_press_event_t *) event;
-                bool8 pressed = event->response_type == XCB_BUTTON_PRESS;
-                buttons mouseButton = BUTTON_MAX_BUTTONS;
-                switch (mouseEvent->detail)
+// - - - Input Thread Functions - - -
+
+bool8 platformStartInputThread(platformState* STATE)
+{
+    if (STATE->isHeadless)
+    {
+        FORGE_LOG_WARNING("A headless platform has no input to read, the input thread was not started");
+        return FALSE;
+    }
+
+    internalState* state = (internalState*)STATE->internalState;
+    if (state->inputThreadRunning)
+    {
+        return TRUE;
+    }
+
+    state->inputWakeDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (state->inputWakeDescriptor < 0)
+    {
+        FORGE_LOG_ERROR("Failed to create the input thread wake descriptor: %s", strerror(errno));
+        return FALSE;
+    }
+
+    state->inputQueue = malloc(sizeof(platformInputEntry) * PLATFORM_INPUT_QUEUE_CAPACITY);
+    state->inputHead = 0;
+    state->inputTail = 0;
+    state->inputThreadFailed = FALSE;
+    platformGamepadInitialize();
+
+    __atomic_store_n(&state->inputThreadRunning, TRUE, __ATOMIC_RELEASE);
+    if (pthread_create(&state->inputThread, NULL, inputThreadMain, state) != 0)
+    {
+        FORGE_LOG_ERROR("Failed to create the input thread");
+        __atomic_store_n(&state->inputThreadRunning, FALSE, __ATOMIC_RELEASE);
+        close(state->inputWakeDescriptor);
+        free(state->inputQueue);
+        state->inputQueue = 0;
+        return FALSE;
+    }
+
+    FORGE_LOG_INFO("Input thread started");
+    return TRUE;
+}
+
+void platformStopInputThread(platformState* STATE)
+{
+    if (STATE->isHeadless)
+    {
+        return;
+    }
+
+    internalState* state = (internalState*)STATE->internalState;
+    if (!state->inputThreadRunning)
+    {
+        return;
+    }
+
+    __atomic_store_n(&state->inputThreadRunning, FALSE, __ATOMIC_RELEASE);
+    unsigned long long wake = 1;
+    write(state->inputWakeDescriptor, &wake, sizeof(wake));
+    pthread_join(state->inputThread, NULL);
+
+    //Whatever was never handed over
+    for (unsigned int tail = state->inputTail; tail != state->inputHead; ++tail)
+    {
+        free(state->inputQueue[tail & (PLATFORM_INPUT_QUEUE_CAPACITY - 1)].event);
+    }
+
+    platformGamepadShutdown();
+    close(state->inputWakeDescriptor);
+    free(state->inputQueue);
+    state->inputQueue = 0;
+    FORGE_LOG_INFO("Input thread stopped");
+}
+
+
+// - - - | Message Handling | - - -
+
+
+// Handles the batch and empties it. Returns TRUE when the window asked to be closed
+bool8 handleWindowEvents(internalState* STATE)
+{
+    bool8 quitFlag = FALSE;
+    platformWindowMessage* batch = STATE->batch;
+    unsigned int count = STATE->batchCount;
+
+    //Collapse runs: only the last motion before a click and the last configure count, unless someone wants every motion sample
+    bool8 keepMotion = eventHasListeners(EVENT_CODE_MOUSE_MOVE_RAW);
+    int lastMotion = -1;
+    int lastConfigure = -1;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        switch (batch[i].event->response_type & ~0x80)
+        {
+            case XCB_MOTION_NOTIFY:
+                if (lastMotion >= 0 && !keepMotion)
                 {
-                    case XCB_BUTTON_INDEX_1:
-                        mouseButton = BUTTON_LEFT;
-                        break;
+                    batch[lastMotion].isCollapsed = TRUE;
+                }
+                lastMotion = i;
+                break;
 
-                    case XCB_BUTTON_INDEX_2:
-                        mouseButton = BUTTON_MIDDLE;
-                        break;
+            case XCB_BUTTON_PRESS:
+            case XCB_BUTTON_RELEASE:
+                lastMotion = -1;
+                break;
 
-                    case XCB_MAP_INDEX_3:
-                        mouseButton = BUTTON_RIGHT;
-                        break;
+            case XCB_CONFIGURE_NOTIFY:
+                if (lastConfigure >= 0)
+                {
+                    batch[lastConfigure].isCollapsed = TRUE;
                 }
+                lastConfigure = i;
+                break;
+
+            case XCB_MAPPING_NOTIFY:
+                //Keys in this batch must already translate with the new mapping
+                handleWindowEvent(STATE, batch[i].event);
+                batch[i].isCollapsed = TRUE;
+                break;
+        }
+    }
+
+    //Input first, in the order it happened
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char type = batch[i].event->response_type & ~0x80;
+        bool8 isInput = type == XCB_KEY_PRESS || type == XCB_KEY_RELEASE || type == XCB_BUTTON_PRESS || type == XCB_BUTTON_RELEASE || type == XCB_MOTION_NOTIFY;
+        if (isInput && !batch[i].isCollapsed)
+        {
+            inputSetEventTime(batch[i].timestamp);
+            handleWindowEvent(STATE, batch[i].event);
+            batch[i].isCollapsed = TRUE;
+        }
+    }
+
+    //Then the window itself
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!batch[i].isCollapsed)
+        {
+            quitFlag |= handleWindowEvent(STATE, batch[i].event);
+        }
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        free(batch[i].event);
+    }
+    STATE->batchCount = 0;
+    return quitFlag;
+}
+
+// Returns TRUE when the window asked to be closed
+bool8 handleWindowEvent(internalState* STATE, xcb_generic_event_t* EVENT)
+{
+    xcb_client_message_event_t* clientMessage;
+    bool8 quitFlag = FALSE;
+
+    switch (EVENT->response_type & ~0x80) //Documentation says so, do not question this number
+    {
+        case XCB_KEY_PRESS:
+
+        case XCB_KEY_RELEASE:
+        {
+            xcb_key_press_event_t* keyEvent = (xcb_key_press_event_t *) EVENT;
+            bool8 pressed = EVENT->response_type == XCB_KEY_PRESS;
+            keys key = STATE->keyTable[keyEvent->detail];
+            inputProcessKey(key, pressed);
+        } 
+        break;
+
+        case XCB_BUTTON_PRESS:
+
+        case XCB_BUTTON_RELEASE:
+        {
+            xcb_button_press_event_t* mouseEvent = (xcb_button_press_event_t *) EVENT;
+            bool8 pressed = EVENT->response_type == XCB_BUTTON_PRESS;
+            buttons mouseButton = BUTTON_MAX_BUTTONS;
+            switch (mouseEvent->detail)
+            {
+                case XCB_BUTTON_INDEX_1:
+                    mouseButton = BUTTON_LEFT;
+                    break;
+
+                case XCB_BUTTON_INDEX_2:
+                    mouseButton = BUTTON_MIDDLE;
+                    break;
+
+                case XCB_MAP_INDEX_3:
+                    mouseButton = BUTTON_RIGHT;
+                    break;
+            }
+
+            if (mouseButton != BUTTON_MAX_BUTTONS)
+            {
+                inputProcessButton(mouseButton, pressed);
+            }
+        }
+        break;
 
-                if (mouseButton != BUTTON_MAX_BUTTONS)
+        case XCB_MOTION_NOTIFY:
+            {
+                xcb_motion_notify_event_t* moveEvent = (xcb_motion_notify_event_t *) EVENT;
+                inputProcessMouseMovement(moveEvent->event_x, moveEvent->event_y);
+            }
+            break;
+
+        case XCB_MAPPING_NOTIFY:
+            {
+                xcb_mapping_notify_event_t* mappingEvent = (xcb_mapping_notify_event_t *) EVENT;
+                if (mappingEvent->request != XCB_MAPPING_POINTER)
                 {
-                    inputProcessButton(mouseButton, pressed);
+                    //Xlib never sees this event since xcb read it, hand it over so its keymap gets refreshed
+                    XMappingEvent xMappingEvent = {};
+                    xMappingEvent.type = MappingNotify;
+                    xMappingEvent.display = STATE->display;
+                    xMappingEvent.request = mappingEvent->request;
+                    xMappingEvent.first_keycode = mappingEvent->first_keycode;
+                    xMappingEvent.count = mappingEvent->count;
+                    XRefreshKeyboardMapping(&xMappingEvent);
+                    buildKeyTable(STATE);
                 }
             }
             break;
 
-            case XCB_MOTION_NOTIFY:
+        case XCB_CONFIGURE_NOTIFY:
+            {
+                //Also sent when the window only moves
+                xcb_configure_notify_event_t* configureEvent = (xcb_configure_notify_event_t *) EVENT;
+                if (configureEvent->width != STATE->width || configureEvent->height != STATE->height)
                 {
-                    xcb_motion_notify_event_t* moveEvent = (xcb_motion_notify_event_t *) event;
-                    inputProcessMouseMovement(moveEvent->event_x, moveEvent->event_y);
+                    STATE->width = configureEvent->width;
+                    STATE->height = configureEvent->height;
+
+                    eventContext context;
+                    context.data.u16[0] = configureEvent->width;
+                    context.data.u16[1] = configureEvent->height;
+                    eventPost(EVENT_CODE_RESIZE, 0, context);
                 }
-                break;
+            }
+            break;
 
-            case XCB_CONFIGURE_NOTIFY:
-                // TODO: resizing
+        case XCB_CLIENT_MESSAGE:
+            clientMessage = (xcb_client_message_event_t*)EVENT;
 
-            case XCB_CLIENT_MESSAGE:
-                clientMessage = (xcb_client_message_event_t*)event;
+            //Check if the window is being closed
+            if (clientMessage->data.data32[0] == STATE->windowDelete)
+            {
+                quitFlag = TRUE;
+            }
+            break;
 
-                //Check if the window is being closed
-                if (clientMessage->data.data32[0] == state->windowDelete)
-                {
-                    quitFlag = TRUE;
-                }
-                break;
+        default:
+            break;
+    }
+    return quitFlag;
+}
 
-            default:
-                break;
+void handleGamepadEvent(platformGamepadEvent EVENT)
+{
+    switch (EVENT.kind)
+    {
+        case PLATFORM_GAMEPAD_CONNECTION:
+            inputProcessGamepadConnection(EVENT.pad, EVENT.value != 0.0f);
+            break;
+
+        case PLATFORM_GAMEPAD_BUTTON:
+            inputProcessGamepadButton(EVENT.pad, EVENT.code, EVENT.value != 0.0f);
+            break;
+
+        case PLATFORM_GAMEPAD_AXIS:
+            inputProcessGamepadAxis(EVENT.pad, EVENT.code, EVENT.value);
+            break;
+    }
+}
+
+void* inputThreadMain(void* STATE)
+{
+    internalState* state = (internalState*)STATE;
+    struct pollfd descriptors[2 + INPUT_MAX_GAMEPADS];
+    unsigned char descriptorPads[2 + INPUT_MAX_GAMEPADS];
+    double nextScan = 0.0;
+
+    while (__atomic_load_n(&state->inputThreadRunning, __ATOMIC_ACQUIRE))
+    {
+        //Pick up pads plugged in since the last look
+        double now = platformGetTime();
+        if (now >= nextScan)
+        {
+            platformGamepadScan(queueGamepadEvent, state);
+            nextScan = now + PLATFORM_GAMEPAD_SCAN_INTERVAL;
+        }
+
+        unsigned int count = 0;
+        descriptors[count].fd = state->inputWakeDescriptor;
+        descriptors[count++].events = POLLIN;
+        descriptors[count].fd = xcb_get_file_descriptor(state->connection);
+        descriptors[count++].events = POLLIN;
+        for (unsigned int pad = 0; pad < INPUT_MAX_GAMEPADS; ++pad)
+        {
+            int descriptor = platformGamepadDescriptor(pad);
+            if (descriptor >= 0)
+            {
+                descriptorPads[count] = pad;
+                descriptors[count].fd = descriptor;
+                descriptors[count++].events = POLLIN;
+            }
+        }
+
+        if (poll(descriptors, count, PLATFORM_INPUT_POLL_MILLISECONDS) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        //Stamp each window event the moment it is read, one socket read per wake up
+        xcb_generic_event_t* event = xcb_poll_for_event(state->connection);
+        while (event)
+        {
+            platformInputEntry entry = {};
+            entry.timestamp = platformGetTime();
+            entry.event = event;
+            if (!queueInputEntry(state, &entry))
+            {
+                free(event);
+            }
+            event = xcb_poll_for_queued_event(state->connection);
+        }
+
+        if (xcb_connection_has_error(state->connection))
+        {
+            __atomic_store_n(&state->inputThreadFailed, TRUE, __ATOMIC_RELEASE);
+            break;
+        }
+
+        //Gamepad events carry the kernel's own timestamps
+        for (unsigned int i = 2; i < count; ++i)
+        {
+            if (descriptors[i].revents)
+            {
+                platformGamepadRead(descriptorPads[i], queueGamepadEvent, state);
+            }
         }
-        free(event);
     }
-    return !quitFlag;
+    return NULL;
+}
+
+void queueGamepadEvent(double TIMESTAMP, platformGamepadEvent EVENT, void* STATE)
+{
+    platformInputEntry entry = {};
+    entry.timestamp = TIMESTAMP;
+    entry.gamepad = EVENT;
+    queueInputEntry((internalState*)STATE, &entry);
+}
+
+bool8 queueInputEntry(internalState* STATE, platformInputEntry* ENTRY)
+{
+    unsigned int head = STATE->inputHead;
+    while (head - __atomic_load_n(&STATE->inputTail, __ATOMIC_ACQUIRE) >= PLATFORM_INPUT_QUEUE_CAPACITY)
+    {
+        //The game fell a long way behind, wait for it rather than drop a release
+        if (!__atomic_load_n(&STATE->inputThreadRunning, __ATOMIC_ACQUIRE))
+        {
+            return FALSE;
+        }
+        struct timespec pause = {0, 100000};
+        nanosleep(&pause, NULL);
+    }
+
+    STATE->inputQueue[head & (PLATFORM_INPUT_QUEUE_CAPACITY - 1)] = *ENTRY;
+    __atomic_store_n(&STATE->inputHead, head + 1, __ATOMIC_RELEASE);
+    return TRUE;
 }
 
 
@@ -302,6 +774,148 @@ void* platformSetMemory(void* DESTINATION, int VALUE, unsigned long long SIZE)
 }
 
 
+// - - - File Mapping Functions - - -
+
+bool8 platformMapFile(const char* PATH, bool8 POPULATE, void** MEMORY, unsigned long long* SIZE)
+{
+    *MEMORY = 0;
+    *SIZE = 0;
+    int descriptor = open(PATH, O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        FORGE_LOG_ERROR("Failed to open %s for mapping: %s", PATH, strerror(errno));
+        return FALSE;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        FORGE_LOG_ERROR("Failed to read the size of %s: %s", PATH, strerror(errno));
+        close(descriptor);
+        return FALSE;
+    }
+    if (status.st_size == 0)
+    {
+        close(descriptor);
+        return TRUE;
+    }
+
+    //The mapping keeps the file alive, the descriptor is not needed past this
+    void* memory = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE | (POPULATE ? MAP_POPULATE : 0), descriptor, 0);
+    close(descriptor);
+    if (memory == MAP_FAILED)
+    {
+        FORGE_LOG_ERROR("Failed to map %s: %s", PATH, strerror(errno));
+        return FALSE;
+    }
+
+    *MEMORY = memory;
+    *SIZE = status.st_size;
+    return TRUE;
+}
+
+void platformUnmapFile(void* MEMORY, unsigned long long SIZE)
+{
+    if (MEMORY)
+    {
+        munmap(MEMORY, SIZE);
+    }
+}
+
+void platformAdviseMapping(void* MEMORY, unsigned long long SIZE, platformMappingAdvice ADVICE)
+{
+    if (!MEMORY || SIZE == 0)
+    {
+        return;
+    }
+
+    //madvise wants a page aligned start
+    unsigned long long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned long long start = (unsigned long long) MEMORY & ~(pageSize - 1);
+    unsigned long long length = (unsigned long long) MEMORY + SIZE - start;
+
+    //On a file mapping WILLNEED queues readahead of the range and returns without waiting for it
+    static const int advice[] = {MADV_WILLNEED, MADV_DONTNEED, MADV_SEQUENTIAL, MADV_RANDOM};
+    madvise((void*) start, length, advice[ADVICE]);
+}
+
+bool8 platformMapFileForWriting(const char* PATH, unsigned long long SIZE, platformWritableMapping* MAPPING)
+{
+    platformZeroMemory(MAPPING, sizeof(platformWritableMapping));
+    int descriptor = open(PATH, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0)
+    {
+        FORGE_LOG_ERROR("Failed to create %s for mapping: %s", PATH, strerror(errno));
+        return FALSE;
+    }
+
+    //Allocated blocks now means no page fault later has to find space, or fail with SIGBUS on a full disk.
+    //File systems that cannot allocate ahead still get a sparse file of the right size
+    if (posix_fallocate(descriptor, 0, SIZE) != 0 && ftruncate(descriptor, SIZE) != 0)
+    {
+        FORGE_LOG_ERROR("Failed to size %s to %llu bytes: %s", PATH, SIZE, strerror(errno));
+        close(descriptor);
+        return FALSE;
+    }
+
+    void* memory = mmap(0, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (memory == MAP_FAILED)
+    {
+        FORGE_LOG_ERROR("Failed to map %s for writing: %s", PATH, strerror(errno));
+        close(descriptor);
+        return FALSE;
+    }
+
+    MAPPING->memory = memory;
+    MAPPING->size = SIZE;
+    MAPPING->file = descriptor;
+    return TRUE;
+}
+
+void platformFlushMapping(const platformWritableMapping* MAPPING, unsigned long long SIZE, bool8 WAIT)
+{
+    if (!MAPPING->memory || SIZE == 0)
+    {
+        return;
+    }
+
+    //Shared pages are the page cache, only a machine crash loses them. msync wants a page aligned start too
+    unsigned long long pageSize = sysconf(_SC_PAGESIZE);
+    unsigned long long start = (unsigned long long) MAPPING->memory & ~(pageSize - 1);
+    unsigned long long length = (unsigned long long) MAPPING->memory + SIZE - start;
+    msync((void*) start, length, WAIT ? MS_SYNC : MS_ASYNC);
+}
+
+void platformUnmapFileForWriting(platformWritableMapping* MAPPING, unsigned long long WRITTEN_SIZE)
+{
+    if (!MAPPING->memory)
+    {
+        return;
+    }
+
+    int descriptor = (int) MAPPING->file;
+    munmap(MAPPING->memory, MAPPING->size);
+    if (ftruncate(descriptor, WRITTEN_SIZE) != 0)
+    {
+        FORGE_LOG_WARNING("Failed to trim a mapped file to %llu bytes: %s", WRITTEN_SIZE, strerror(errno));
+    }
+    close(descriptor);
+    platformZeroMemory(MAPPING, sizeof(platformWritableMapping));
+}
+
+bool8 platformGetFileSize(const char* PATH, unsigned long long* SIZE)
+{
+    struct stat status;
+    if (stat(PATH, &status) != 0)
+    {
+        *SIZE = 0;
+        return FALSE;
+    }
+    *SIZE = status.st_size;
+    return TRUE;
+}
+
+
 // - - - Writing Functions - - - 
 
 void platformWriteConsole(const char* MESSAGE, unsigned char COLOR)
@@ -333,6 +947,76 @@ void platformWriteConsoleError(const char* MESSAGE, unsigned char COLOR)
     //This is how you print colored text in the terminal
 }
 
+#define PLATFORM_CONSOLE_BATCH 64
+
+void platformWriteConsoleBuffers(const platformConsoleBuffer* BUFFERS, unsigned int COUNT, bool8 IS_ERROR, bool8 USE_COLOR)
+{
+    //Same colors as above, escape codes made up front so every message is at most three pieces of one writev
+    static const char* colorStarts[2][6] = {
+        {"\033[0;41m", "\033[1;31m", "\033[1;33m", "\033[1;32m", "\033[1;34m", "\033[1;30m"},
+        {"\033[1;41m", "\033[1;31m", "\033[1;33m", "\033[1;32m", "\033[1;34m", "\033[1;30m"}};
+    static const char colorEnd[] = "\033[0m";
+    int descriptor = IS_ERROR ? STDERR_FILENO : STDOUT_FILENO;
+    unsigned int pieces = USE_COLOR ? 3 : 1;
+
+    //Whatever printf still holds has to go out first or lines come out of order
+    fflush(IS_ERROR ? stderr : stdout);
+
+    struct iovec vectors[PLATFORM_CONSOLE_BATCH * 3];
+    for (unsigned int first = 0; first < COUNT; first += PLATFORM_CONSOLE_BATCH)
+    {
+        unsigned int count = COUNT - first < PLATFORM_CONSOLE_BATCH ? COUNT - first : PLATFORM_CONSOLE_BATCH;
+        struct iovec* piece = vectors;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const platformConsoleBuffer* buffer = &BUFFERS[first + i];
+            if (USE_COLOR)
+            {
+                const char* start = colorStarts[IS_ERROR ? 1 : 0][buffer->color < 6 ? buffer->color : 5];
+                piece->iov_base = (void*) start;
+                piece->iov_len = strlen(start);
+                ++piece;
+            }
+            piece->iov_base = (void*) buffer->text;
+            piece->iov_len = buffer->length;
+            ++piece;
+            if (USE_COLOR)
+            {
+                piece->iov_base = (void*) colorEnd;
+                piece->iov_len = sizeof(colorEnd) - 1;
+                ++piece;
+            }
+        }
+
+        //Pipes may take only part of it, carry on from wherever the write stopped
+        struct iovec* vector = vectors;
+        int remaining = count * pieces;
+        while (remaining > 0)
+        {
+            ssize_t written = writev(descriptor, vector, remaining);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return; //Nowhere left to report it
+            }
+            while (remaining > 0 && (size_t) written >= vector->iov_len)
+            {
+                written -= vector->iov_len;
+                ++vector;
+                --remaining;
+            }
+            if (remaining > 0)
+            {
+                vector->iov_base = (char*) vector->iov_base + written;
+                vector->iov_len -= written;
+            }
+        }
+    }
+}
+
 
 // - - - Time and Sleep Functions - - -
 
@@ -352,15 +1036,211 @@ void platformSleep(unsigned long long MILLISECONDS)
 #endif
 }
 
-double platformGetTime()
+void platformSleepUntil(unsigned long long TICKS)
+{
+    //TSC ticks only track CLOCK_MONOTONIC, so the deadline is moved onto it from a reading of both taken right now
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned long long ticks = platformGetTicks();
+    if (TICKS <= ticks)
+    {
+        return;
+    }
+
+    //An absolute deadline does not drift when a signal cuts the sleep short
+    unsigned long long target = now.tv_sec * 1000000000ULL + now.tv_nsec + (TICKS - ticks);
+    struct timespec deadline;
+    deadline.tv_sec = target / 1000000000ULL;
+    deadline.tv_nsec = target % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+    {
+    }
+}
+
+unsigned long long platformGetTicks()
 {
+#if defined(__x86_64__)
+    if (__atomic_load_n(&tickState.useTimestampCounter, __ATOMIC_ACQUIRE))
+    {
+        //Read the anchor again if it was replaced meanwhile
+        unsigned int processor;
+        unsigned int sequence;
+        unsigned long long elapsed;
+        unsigned long long ticks;
+        do
+        {
+            sequence = __atomic_load_n(&tickState.sequence, __ATOMIC_ACQUIRE);
+            elapsed = __rdtscp(&processor) - __atomic_load_n(&tickState.baseCounter, __ATOMIC_RELAXED);
+            ticks = __atomic_load_n(&tickState.baseTicks, __ATOMIC_RELAXED) + (unsigned long long) (((unsigned __int128) elapsed * __atomic_load_n(&tickState.multiplier, __ATOMIC_RELAXED)) >> 32);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while ((sequence & 1) || sequence != __atomic_load_n(&tickState.sequence, __ATOMIC_RELAXED));
+
+        if (elapsed > tickState.reanchorCounts)
+        {
+            reanchorTickClock();
+        }
+        return ticks;
+    }
+#endif
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
-    return now.tv_sec + now.tv_nsec * 0.000000001; //Seconds in double
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+double platformGetTime()
+{
+    return platformGetTicks() * 0.000000001; //Seconds in double
+}
+
+
+// - - - Tick Clock Calibration
+void calibrateTickClock()
+{
+#if defined(__x86_64__)
+    if (tickState.useTimestampCounter)
+    {
+        return;
+    }
+
+    //Invariant: the counter keeps a constant rate through frequency changes and sleep states
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+    {
+        FORGE_LOG_INFO("No invariant TSC, ticks come from clock_gettime");
+        return;
+    }
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 27)))
+    {
+        FORGE_LOG_INFO("No RDTSCP, ticks come from clock_gettime");
+        return;
+    }
+
+    //The kernel stops using the TSC when it finds it unsynchronised across cores or unstable under a hypervisor
+    char source[16] = {};
+    FILE* sourceFile = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (sourceFile)
+    {
+        fgets(source, sizeof(source), sourceFile);
+        fclose(sourceFile);
+    }
+    if (strncmp(source, "tsc", 3) != 0)
+    {
+        FORGE_LOG_INFO("The kernel does not trust the TSC, ticks come from clock_gettime");
+        return;
+    }
+
+    //Pair counter and clock readings, keeping the pair the fewest counter ticks apart
+    unsigned long long counters[2];
+    unsigned long long times[2];
+    for (unsigned int pair = 0; pair < 2; ++pair)
+    {
+        unsigned long long bestSpread = ~0ULL;
+        for (unsigned int sample = 0; sample < PLATFORM_TICK_CALIBRATION_SAMPLES; ++sample)
+        {
+            unsigned int processor;
+            struct timespec now;
+            unsigned long long before = __rdtscp(&processor);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            unsigned long long after = __rdtscp(&processor);
+            if (after - before < bestSpread)
+            {
+                bestSpread = after - before;
+                counters[pair] = before + (after - before) / 2;
+                times[pair] = now.tv_sec * 1000000000ULL + now.tv_nsec;
+            }
+        }
+        if (pair == 0)
+        {
+            platformSleep(PLATFORM_TICK_CALIBRATION_MILLISECONDS);
+        }
+    }
+    double frequency = (double) (counters[1] - counters[0]) * 1000000000.0 / (double) (times[1] - times[0]);
+
+    //Prefer the exact rate the processor reports, unless it disagrees with what was measured (hypervisors)
+    if (__get_cpuid(0x15, &eax, &ebx, &ecx, &edx) && eax && ebx && ecx)
+    {
+        double reported = (double) ecx * ebx / eax;
+        if (reported > frequency * 0.99 && reported < frequency * 1.01)
+        {
+            frequency = reported;
+        }
+    }
+
+    //Anchored to CLOCK_MONOTONIC here. Calibration error and NTP slewing move the two apart, reanchorTickClock steers them back
+    tickState.baseCounter = counters[1];
+    tickState.baseTicks = times[1];
+    tickState.anchorTime = times[1];
+    tickState.multiplier = (unsigned long long) (1000000000.0 * 4294967296.0 / frequency);
+    tickState.reanchorCounts = (unsigned long long) (frequency * PLATFORM_TICK_REANCHOR_NANOSECONDS / 1000000000.0);
+    __atomic_store_n(&tickState.useTimestampCounter, TRUE, __ATOMIC_RELEASE);
+    FORGE_LOG_INFO("Ticks come from the TSC at %.3f MHz", frequency / 1000000.0);
+#endif
+}
+
+
+void reanchorTickClock()
+{
+#if defined(__x86_64__)
+    //The first thread past the interval does it, the rest carry on with the current anchor
+    if (__atomic_exchange_n(&tickState.isReanchoring, TRUE, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    unsigned int processor;
+    unsigned long long bestSpread = ~0ULL;
+    unsigned long long counter = 0;
+    unsigned long long time = 0;
+    for (unsigned int sample = 0; sample < 4; ++sample)
+    {
+        struct timespec now;
+        unsigned long long before = __rdtscp(&processor);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        unsigned long long after = __rdtscp(&processor);
+        if (after - before < bestSpread)
+        {
+            bestSpread = after - before;
+            counter = before + (after - before) / 2;
+            time = now.tv_sec * 1000000000ULL + now.tv_nsec;
+        }
+    }
+
+    //The rate CLOCK_MONOTONIC actually ran at over the last interval, NTP slewing included
+    unsigned long long counts = counter - tickState.baseCounter;
+    unsigned long long ticks = tickState.baseTicks + (unsigned long long) (((unsigned __int128) counts * tickState.multiplier) >> 32);
+    double nanosecondsPerCount = (double) (time - tickState.anchorTime) / (double) counts;
+
+    //Close the gap over the next interval by running a little fast or slow, so ticks stay continuous and never go back
+    double correction = 1.0 - ((double) ticks - (double) time) / PLATFORM_TICK_REANCHOR_NANOSECONDS;
+    correction = correction < 1.0 - PLATFORM_TICK_MAX_CORRECTION ? 1.0 - PLATFORM_TICK_MAX_CORRECTION : correction;
+    correction = correction > 1.0 + PLATFORM_TICK_MAX_CORRECTION ? 1.0 + PLATFORM_TICK_MAX_CORRECTION : correction;
+
+    unsigned int sequence = tickState.sequence;
+    __atomic_store_n(&tickState.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&tickState.baseCounter, counter, __ATOMIC_RELAXED);
+    __atomic_store_n(&tickState.baseTicks, ticks, __ATOMIC_RELAXED);
+    __atomic_store_n(&tickState.multiplier, (unsigned long long) (nanosecondsPerCount * correction * 4294967296.0), __ATOMIC_RELAXED);
+    __atomic_store_n(&tickState.sequence, sequence + 2, __ATOMIC_RELEASE);
+    tickState.anchorTime = time;
+
+    __atomic_store_n(&tickState.isReanchoring, FALSE, __ATOMIC_RELEASE);
+#endif
 }
 
 
 // - - - Key Translation
+void buildKeyTable(internalState* STATE)
+{
+    //X keycodes start at 8, the unshifted keysym is enough since letters map to the same key either way
+    STATE->keyTable[0] = 0;
+    for (unsigned int code = 1; code < 256; ++code)
+    {
+        KeySym keySym = XkbKeycodeToKeysym(STATE->display, (KeyCode) code, 0, 0);
+        STATE->keyTable[code] = keySym == NoSymbol ? 0 : translateKeycode(keySym);
+    }
+}
+
 keys translateKeycode(unsigned int X_KEYCODE)
 {
     switch (X_KEYCODE)
@@ -729,6 +1609,12 @@ void platformGetRequiredExtensions(const char*** EXTENSIONS)
 
 bool8 platformCreateSurface(platformState* STATE, vulkanContext* CONTEXT)
 {
+    if (STATE->isHeadless)
+    {
+        FORGE_LOG_FATAL("A headless platform has no window to render to, use the null renderer");
+        return FALSE;
+    }
+
     internalState* state = (internalState*)STATE->internalState;
 
     VkXcbSurfaceCreateInfoKHR createInfo = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
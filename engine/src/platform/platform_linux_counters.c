@@ -0,0 +1,244 @@
+#include "platform.h"
+#if FORGE_PLATFORM_LINUX
+
+#include "core/logger.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+
+// - - - | Performance Counter State | - - -
+
+
+/*
+- - - | Counting without a system call | - - -
+    The counters are one perf_event_open group so they start, stop and get scheduled onto the processor together.
+    Each counter's first page is mapped, the kernel keeps the hardware register index and the count saved from
+    before the thread last ran there. When the kernel allows user space rdpmc the register is read directly and
+    added to that saved count, a handful of cycles instead of a read() of the whole group.
+*/
+
+typedef struct counterState
+{
+    int descriptors[PLATFORM_COUNTER_MAX]; // -1 when the counter is not available
+    struct perf_event_mmap_page* pages[PLATFORM_COUNTER_MAX];
+    int leader;
+    bool8 useRdpmc;
+} counterState;
+
+static const unsigned long long counterConfigs[PLATFORM_COUNTER_MAX] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+static bool8 restrictionReported = FALSE;
+
+int openCounter(unsigned long long CONFIG, int LEADER);
+
+unsigned long long readMappedCounter(const struct perf_event_mmap_page* PAGE);
+
+void reportCounterRestriction(int ERROR);
+
+
+// - - - | Performance Counter Functions | - - -
+
+
+int openCounter(unsigned long long CONFIG, int LEADER)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = CONFIG;
+    attributes.disabled = LEADER < 0; //The group starts together once every member is in
+    attributes.exclude_kernel = 1; //User space only, allowed at the default perf_event_paranoid level of 2
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP;
+
+    //This thread on whatever processor it runs on
+    return (int) syscall(SYS_perf_event_open, &attributes, 0, -1, LEADER, PERF_FLAG_FD_CLOEXEC);
+}
+
+void reportCounterRestriction(int ERROR)
+{
+    if (restrictionReported)
+    {
+        return;
+    }
+    restrictionReported = TRUE;
+
+    int paranoid = -1;
+    FILE* file = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (file)
+    {
+        if (fscanf(file, "%d", &paranoid) != 1)
+        {
+            paranoid = -1;
+        }
+        fclose(file);
+    }
+    FORGE_LOG_WARNING("Hardware counters unavailable (%s, perf_event_paranoid %d), frame statistics keep wall time only", strerror(ERROR), paranoid);
+}
+
+bool8 platformCountersOpen(platformCounterGroup* GROUP)
+{
+    GROUP->internalState = 0;
+    GROUP->available = 0;
+
+    counterState* state = platformAllocateMemory(sizeof(counterState), FALSE);
+    platformZeroMemory(state, sizeof(counterState));
+    state->leader = -1;
+    state->useRdpmc = TRUE;
+
+    //Whichever counter opens first leads, a processor without one of them still counts the rest
+    int error = 0;
+    for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX; ++i)
+    {
+        state->descriptors[i] = openCounter(counterConfigs[i], state->leader);
+        if (state->descriptors[i] < 0)
+        {
+            error = error ? error : errno;
+            continue;
+        }
+        if (state->leader < 0)
+        {
+            state->leader = state->descriptors[i];
+        }
+        GROUP->available |= 1u << i;
+
+        state->pages[i] = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, state->descriptors[i], 0);
+        if (state->pages[i] == MAP_FAILED)
+        {
+            state->pages[i] = 0;
+            state->useRdpmc = FALSE;
+        }
+    }
+
+    if (state->leader < 0)
+    {
+        reportCounterRestriction(error);
+        platformFreeMemory(state, FALSE);
+        GROUP->available = 0;
+        return FALSE;
+    }
+
+    ioctl(state->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(state->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+#if defined(__x86_64__) || defined(__i386__)
+    for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX; ++i)
+    {
+        if (state->pages[i] && !state->pages[i]->cap_user_rdpmc)
+        {
+            state->useRdpmc = FALSE;
+        }
+    }
+#else
+    state->useRdpmc = FALSE; //No user space counter reads wired up for other processors yet
+#endif
+
+    FORGE_LOG_DEBUG("Hardware counters open, read with %s", state->useRdpmc ? "rdpmc" : "read()");
+    GROUP->internalState = state;
+    return TRUE;
+}
+
+void platformCountersClose(platformCounterGroup* GROUP)
+{
+    counterState* state = GROUP->internalState;
+    if (!state)
+    {
+        return;
+    }
+
+    ioctl(state->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX; ++i)
+    {
+        if (state->pages[i])
+        {
+            munmap(state->pages[i], sysconf(_SC_PAGESIZE));
+        }
+        //Members go before the leader
+        if (state->descriptors[i] >= 0 && state->descriptors[i] != state->leader)
+        {
+            close(state->descriptors[i]);
+        }
+    }
+    close(state->leader);
+
+    platformFreeMemory(state, FALSE);
+    GROUP->internalState = 0;
+    GROUP->available = 0;
+}
+
+unsigned long long readMappedCounter(const struct perf_event_mmap_page* PAGE)
+{
+    unsigned long long count;
+    unsigned int sequence;
+
+    //The kernel bumps lock around every update, start over when it moved under us
+    do
+    {
+        sequence = __atomic_load_n(&PAGE->lock, __ATOMIC_ACQUIRE);
+        unsigned int index = PAGE->index;
+        count = PAGE->offset;
+#if defined(__x86_64__) || defined(__i386__)
+        if (index)
+        {
+            //Only the low pmc_width bits are live, sign extend them
+            unsigned int shift = 64 - PAGE->pmc_width;
+            long long value = (long long) ((unsigned long long) __builtin_ia32_rdpmc(index - 1) << shift) >> shift;
+            count += value;
+        }
+#endif
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    }
+    while (__atomic_load_n(&PAGE->lock, __ATOMIC_RELAXED) != sequence);
+
+    return count;
+}
+
+void platformCountersRead(const platformCounterGroup* GROUP, platformCounterValues* VALUES)
+{
+    memset(VALUES, 0, sizeof(platformCounterValues));
+    const counterState* state = GROUP->internalState;
+    if (!state)
+    {
+        return;
+    }
+
+    if (state->useRdpmc)
+    {
+        for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX; ++i)
+        {
+            if (state->pages[i])
+            {
+                VALUES->values[i] = readMappedCounter(state->pages[i]);
+            }
+        }
+        return;
+    }
+
+    //Whole group in one read, values come in the order the members were opened
+    unsigned long long buffer[1 + PLATFORM_COUNTER_MAX];
+    if (read(state->leader, buffer, sizeof(buffer)) < (long) sizeof(unsigned long long))
+    {
+        return;
+    }
+    unsigned int member = 0;
+    for (unsigned int i = 0; i < PLATFORM_COUNTER_MAX && member < buffer[0]; ++i)
+    {
+        if (GROUP->available & (1u << i))
+        {
+            VALUES->values[i] = buffer[1 + member++];
+        }
+    }
+}
+
+#endif //FORGE_PLATFORM_LINUX
@@ -0,0 +1,276 @@
+#include "platform/platform_linux_gamepad.h"
+#include "platform/platform.h"
+#if FORGE_PLATFORM_LINUX
+
+#include "core/logger.h"
+#include "core/memory.h"
+#include "core/input.h"
+
+// NOTE: linux/input.h defines KEY_* macros that clash with the engine keys, so it stays in this file and comes last
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+
+// - - - | Gamepad State | - - -
+
+
+#define PLATFORM_GAMEPAD_MAX_DEVICES 32
+
+typedef struct platformGamepad
+{
+    int descriptor; // -1 when the slot is free
+    int device; //Number in /dev/input/event*
+    struct input_absinfo axisInfo[GAMEPAD_AXIS_MAX_AXES];
+} platformGamepad;
+
+static platformGamepad gamepads[INPUT_MAX_GAMEPADS];
+
+// - - - Translation
+static const unsigned short axisCodes[GAMEPAD_AXIS_MAX_AXES] = {ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ};
+
+gamepadButtons translateGamepadButton(unsigned short CODE);
+void sendGamepadEvent(platformGamepadSink SINK, void* USER, double TIMESTAMP, platformGamepadEventKind KIND, unsigned char PAD, unsigned short CODE, float VALUE);
+void closeGamepad(unsigned char PAD, double TIMESTAMP, platformGamepadSink SINK, void* USER);
+
+
+// - - - | Gamepad Functions | - - -
+
+
+void platformGamepadInitialize()
+{
+    for (unsigned int pad = 0; pad < INPUT_MAX_GAMEPADS; ++pad)
+    {
+        gamepads[pad].descriptor = -1;
+        gamepads[pad].device = -1;
+    }
+}
+
+void platformGamepadShutdown()
+{
+    for (unsigned int pad = 0; pad < INPUT_MAX_GAMEPADS; ++pad)
+    {
+        if (gamepads[pad].descriptor >= 0)
+        {
+            close(gamepads[pad].descriptor);
+        }
+        gamepads[pad].descriptor = -1;
+        gamepads[pad].device = -1;
+    }
+}
+
+void platformGamepadScan(platformGamepadSink SINK, void* USER)
+{
+    for (int device = 0; device < PLATFORM_GAMEPAD_MAX_DEVICES; ++device)
+    {
+        //Skip devices already open and stop once every slot is taken
+        int freePad = -1;
+        bool8 isOpen = FALSE;
+        for (unsigned int pad = 0; pad < INPUT_MAX_GAMEPADS; ++pad)
+        {
+            if (gamepads[pad].device == device)
+            {
+                isOpen = TRUE;
+            }
+            else if (gamepads[pad].descriptor < 0 && freePad < 0)
+            {
+                freePad = pad;
+            }
+        }
+        if (isOpen)
+        {
+            continue;
+        }
+        if (freePad < 0)
+        {
+            return;
+        }
+
+        char path[32];
+        snprintf(path, sizeof(path), "/dev/input/event%d", device);
+        int descriptor = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (descriptor < 0)
+        {
+            continue;
+        }
+
+        //Only devices with gamepad buttons, keyboards and mice are read through the window
+        unsigned long keyBits[(KEY_MAX + 1) / (8 * sizeof(unsigned long)) + 1] = {};
+        unsigned int bitsPerWord = 8 * sizeof(unsigned long);
+        if (ioctl(descriptor, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0 || !((keyBits[BTN_GAMEPAD / bitsPerWord] >> (BTN_GAMEPAD % bitsPerWord)) & 1))
+        {
+            close(descriptor);
+            continue;
+        }
+
+        //Stamp events on the same clock as platformGetTime
+        int clockId = CLOCK_MONOTONIC;
+        ioctl(descriptor, EVIOCSCLOCKID, &clockId);
+
+        platformGamepad* gamepad = &gamepads[freePad];
+        forgeZeroMemory(gamepad->axisInfo, sizeof(gamepad->axisInfo));
+        for (unsigned int axis = 0; axis < GAMEPAD_AXIS_MAX_AXES; ++axis)
+        {
+            ioctl(descriptor, EVIOCGABS(axisCodes[axis]), &gamepad->axisInfo[axis]);
+        }
+        gamepad->descriptor = descriptor;
+        gamepad->device = device;
+
+        char name[128] = "Unknown";
+        ioctl(descriptor, EVIOCGNAME(sizeof(name)), name);
+        FORGE_LOG_INFO("Gamepad %i connected: %s", freePad, name);
+        sendGamepadEvent(SINK, USER, platformGetTime(), PLATFORM_GAMEPAD_CONNECTION, freePad, 0, 1.0f);
+    }
+}
+
+int platformGamepadDescriptor(unsigned char PAD)
+{
+    return PAD < INPUT_MAX_GAMEPADS ? gamepads[PAD].descriptor : -1;
+}
+
+void platformGamepadRead(unsigned char PAD, platformGamepadSink SINK, void* USER)
+{
+    platformGamepad* gamepad = &gamepads[PAD];
+    struct input_event events[64];
+    while (gamepad->descriptor >= 0)
+    {
+        ssize_t bytes = read(gamepad->descriptor, events, sizeof(events));
+        if (bytes < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+            {
+                closeGamepad(PAD, platformGetTime(), SINK, USER);
+            }
+            return;
+        }
+
+        unsigned int count = bytes / sizeof(struct input_event);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            struct input_event* event = &events[i];
+            double timestamp = event->input_event_sec + event->input_event_usec * 0.000001;
+
+            if (event->type == EV_KEY && event->value != 2) //2 is auto repeat
+            {
+                gamepadButtons button = translateGamepadButton(event->code);
+                if (button != GAMEPAD_BUTTON_MAX_BUTTONS)
+                {
+                    sendGamepadEvent(SINK, USER, timestamp, PLATFORM_GAMEPAD_BUTTON, PAD, button, event->value ? 1.0f : 0.0f);
+                }
+            }
+            else if (event->type == EV_ABS)
+            {
+                //Pads that report the d-pad as a hat
+                if (event->code == ABS_HAT0X || event->code == ABS_HAT0Y)
+                {
+                    gamepadButtons negative = event->code == ABS_HAT0X ? GAMEPAD_BUTTON_DPAD_LEFT : GAMEPAD_BUTTON_DPAD_UP;
+                    gamepadButtons positive = event->code == ABS_HAT0X ? GAMEPAD_BUTTON_DPAD_RIGHT : GAMEPAD_BUTTON_DPAD_DOWN;
+                    sendGamepadEvent(SINK, USER, timestamp, PLATFORM_GAMEPAD_BUTTON, PAD, negative, event->value < 0 ? 1.0f : 0.0f);
+                    sendGamepadEvent(SINK, USER, timestamp, PLATFORM_GAMEPAD_BUTTON, PAD, positive, event->value > 0 ? 1.0f : 0.0f);
+                    continue;
+                }
+
+                for (unsigned int axis = 0; axis < GAMEPAD_AXIS_MAX_AXES; ++axis)
+                {
+                    if (axisCodes[axis] != event->code)
+                    {
+                        continue;
+                    }
+
+                    struct input_absinfo* info = &gamepad->axisInfo[axis];
+                    float range = (float) (info->maximum - info->minimum);
+                    float value = range > 0.0f ? (event->value - info->minimum) / range : 0.0f;
+                    if (axis < GAMEPAD_AXIS_LEFT_TRIGGER)
+                    {
+                        value = value * 2.0f - 1.0f;
+                    }
+                    sendGamepadEvent(SINK, USER, timestamp, PLATFORM_GAMEPAD_AXIS, PAD, axis, value);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+// - - - Helpers - - -
+
+gamepadButtons translateGamepadButton(unsigned short CODE)
+{
+    switch (CODE)
+    {
+        case BTN_SOUTH:
+            return GAMEPAD_BUTTON_A;
+
+        case BTN_EAST:
+            return GAMEPAD_BUTTON_B;
+
+        case BTN_WEST:
+            return GAMEPAD_BUTTON_X;
+
+        case BTN_NORTH:
+            return GAMEPAD_BUTTON_Y;
+
+        case BTN_TL:
+            return GAMEPAD_BUTTON_LEFT_SHOULDER;
+
+        case BTN_TR:
+            return GAMEPAD_BUTTON_RIGHT_SHOULDER;
+
+        case BTN_SELECT:
+            return GAMEPAD_BUTTON_BACK;
+
+        case BTN_START:
+            return GAMEPAD_BUTTON_START;
+
+        case BTN_MODE:
+            return GAMEPAD_BUTTON_GUIDE;
+
+        case BTN_THUMBL:
+            return GAMEPAD_BUTTON_LEFT_THUMB;
+
+        case BTN_THUMBR:
+            return GAMEPAD_BUTTON_RIGHT_THUMB;
+
+        case BTN_DPAD_UP:
+            return GAMEPAD_BUTTON_DPAD_UP;
+
+        case BTN_DPAD_DOWN:
+            return GAMEPAD_BUTTON_DPAD_DOWN;
+
+        case BTN_DPAD_LEFT:
+            return GAMEPAD_BUTTON_DPAD_LEFT;
+
+        case BTN_DPAD_RIGHT:
+            return GAMEPAD_BUTTON_DPAD_RIGHT;
+
+        default:
+            return GAMEPAD_BUTTON_MAX_BUTTONS;
+    }
+}
+
+void sendGamepadEvent(platformGamepadSink SINK, void* USER, double TIMESTAMP, platformGamepadEventKind KIND, unsigned char PAD, unsigned short CODE, float VALUE)
+{
+    platformGamepadEvent event;
+    event.kind = KIND;
+    event.pad = PAD;
+    event.code = CODE;
+    event.value = VALUE;
+    SINK(TIMESTAMP, event, USER);
+}
+
+void closeGamepad(unsigned char PAD, double TIMESTAMP, platformGamepadSink SINK, void* USER)
+{
+    close(gamepads[PAD].descriptor);
+    gamepads[PAD].descriptor = -1;
+    gamepads[PAD].device = -1;
+    FORGE_LOG_INFO("Gamepad %i disconnected", PAD);
+    sendGamepadEvent(SINK, USER, TIMESTAMP, PLATFORM_GAMEPAD_CONNECTION, PAD, 0, 0.0f);
+}
+
+#endif
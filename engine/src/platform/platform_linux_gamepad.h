@@ -0,0 +1,48 @@
+#pragma once
+#include "defines.h"
+
+
+// - - - | Linux Gamepads | - - -
+
+/*
+- - - | evdev gamepads | - - -
+    Devices under /dev/input that report gamepad buttons are opened non blocking with monotonic timestamps.
+    Everything here runs on the input thread, events are handed to a sink which queues them for the main thread.
+*/
+
+
+// - - - Gamepad Events
+typedef enum platformGamepadEventKind
+{
+    PLATFORM_GAMEPAD_CONNECTION, //value 1 when connected, 0 when removed
+    PLATFORM_GAMEPAD_BUTTON, //code is a gamepadButtons, value 1 when down
+    PLATFORM_GAMEPAD_AXIS //code is a gamepadAxes, value already normalised
+} platformGamepadEventKind;
+
+typedef struct platformGamepadEvent
+{
+    unsigned char kind;
+    unsigned char pad;
+    unsigned short code;
+    float value;
+} platformGamepadEvent;
+
+// TIMESTAMP is in platformGetTime seconds
+typedef void (*platformGamepadSink)(double TIMESTAMP, platformGamepadEvent EVENT, void* USER);
+
+
+// - - - | Gamepad Functions | - - -
+
+
+void platformGamepadInitialize();
+
+void platformGamepadShutdown();
+
+// Open gamepads that appeared since the last scan
+void platformGamepadScan(platformGamepadSink SINK, void* USER);
+
+// File descriptor to poll for a pad, -1 if the slot is empty
+int platformGamepadDescriptor(unsigned char PAD);
+
+// Read everything the pad has, closes it when it was unplugged
+void platformGamepadRead(unsigned char PAD, platformGamepadSink SINK, void* USER);
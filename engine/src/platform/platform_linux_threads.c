@@ -0,0 +1,357 @@
+//Thread names, affinity and CPU sets are GNU extensions, asked for before any system header comes in
+#define _GNU_SOURCE
+#include "platform.h"
+#if FORGE_PLATFORM_LINUX
+
+#include "core/logger.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+
+// - - - | Thread State | - - -
+
+
+// - - - Start Arguments, freed by the new thread once it has them
+typedef struct platformThreadStart
+{
+    platformThreadFunction function;
+    void* argument;
+} platformThreadStart;
+
+#define PLATFORM_MAX_CPUS 1024
+
+static bool8 cpuInfoRead = FALSE;
+static platformCpuInfo cpuInfo;
+
+// - - - Topology, per logical core, -1 when offline
+static int coreIds[PLATFORM_MAX_CPUS];
+static int packageIds[PLATFORM_MAX_CPUS];
+
+void* platformThreadEntry(void* START);
+
+void readCpuTopology();
+
+bool8 readSystemNumber(const char* PATH, int* VALUE);
+
+
+// - - - | Thread Functions | - - -
+
+
+bool8 platformThreadCreate(platformThread* THREAD, const char* NAME, platformThreadFunction FUNCTION, void* ARGUMENT)
+{
+    //Plain malloc, the thread may outlive the memory system's bookkeeping
+    platformThreadStart* start = malloc(sizeof(platformThreadStart));
+    if (!start)
+    {
+        return FALSE;
+    }
+    start->function = FUNCTION;
+    start->argument = ARGUMENT;
+
+    pthread_t thread;
+    int error = pthread_create(&thread, 0, platformThreadEntry, start);
+    if (error)
+    {
+        FORGE_LOG_ERROR("Failed to create thread %s: %s", NAME ? NAME : "", strerror(error));
+        free(start);
+        THREAD->handle = 0;
+        return FALSE;
+    }
+
+    if (NAME)
+    {
+        char name[PLATFORM_THREAD_NAME_LENGTH];
+        snprintf(name, sizeof(name), "%s", NAME);
+        pthread_setname_np(thread, name);
+    }
+
+    THREAD->handle = (unsigned long long) thread;
+    return TRUE;
+}
+
+void* platformThreadEntry(void* START)
+{
+    platformThreadStart start = *(platformThreadStart*) START;
+    free(START);
+    return (void*) (unsigned long) start.function(start.argument);
+}
+
+unsigned int platformThreadJoin(platformThread* THREAD)
+{
+    if (!THREAD->handle)
+    {
+        return 0;
+    }
+
+    void* result = 0;
+    pthread_join((pthread_t) THREAD->handle, &result);
+    THREAD->handle = 0;
+    return (unsigned int) (unsigned long) result;
+}
+
+bool8 platformThreadSetAffinity(platformThread* THREAD, unsigned int LOGICAL_CORE)
+{
+    if (LOGICAL_CORE >= PLATFORM_MAX_CPUS)
+    {
+        return FALSE;
+    }
+
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(LOGICAL_CORE, &cores);
+    int error = pthread_setaffinity_np((pthread_t) THREAD->handle, sizeof(cores), &cores);
+    if (error)
+    {
+        FORGE_LOG_WARNING("Failed to pin thread to core %u: %s", LOGICAL_CORE, strerror(error));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+bool8 platformThreadSetCurrentName(const char* NAME)
+{
+    char name[PLATFORM_THREAD_NAME_LENGTH];
+    snprintf(name, sizeof(name), "%s", NAME);
+    return pthread_setname_np(pthread_self(), name) == 0;
+}
+
+unsigned long long platformThreadGetCurrentId()
+{
+    return (unsigned long long) syscall(SYS_gettid);
+}
+
+void platformThreadYield()
+{
+    sched_yield();
+}
+
+
+// - - - | Futex Functions | - - -
+
+
+void platformFutexWait(unsigned int* ADDRESS, unsigned int EXPECTED)
+{
+    //EAGAIN when the value already changed and EINTR on a signal both just return, the caller checks again
+    syscall(SYS_futex, ADDRESS, FUTEX_WAIT_PRIVATE, EXPECTED, 0, 0, 0);
+}
+
+void platformFutexWake(unsigned int* ADDRESS, unsigned int COUNT)
+{
+    int count = COUNT > INT_MAX ? INT_MAX : (int) COUNT;
+    syscall(SYS_futex, ADDRESS, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+
+// - - - | Thread Local Storage Functions | - - -
+
+
+bool8 platformTlsAllocate(platformTlsKey* KEY)
+{
+    pthread_key_t key;
+    if (pthread_key_create(&key, 0))
+    {
+        return FALSE;
+    }
+    *KEY = key;
+    return TRUE;
+}
+
+void platformTlsFree(platformTlsKey KEY)
+{
+    pthread_key_delete((pthread_key_t) KEY);
+}
+
+void platformTlsSet(platformTlsKey KEY, void* VALUE)
+{
+    pthread_setspecific((pthread_key_t) KEY, VALUE);
+}
+
+void* platformTlsGet(platformTlsKey KEY)
+{
+    return pthread_getspecific((pthread_key_t) KEY);
+}
+
+
+// - - - | CPU Topology Functions | - - -
+
+
+bool8 readSystemNumber(const char* PATH, int* VALUE)
+{
+    FILE* file = fopen(PATH, "r");
+    if (!file)
+    {
+        return FALSE;
+    }
+
+    //Cache sizes come as "32K" or "8M"
+    char suffix = 0;
+    int read = fscanf(file, "%d%c", VALUE, &suffix);
+    fclose(file);
+    if (read < 1)
+    {
+        return FALSE;
+    }
+    if (suffix == 'K')
+    {
+        *VALUE *= 1024;
+    }
+    else if (suffix == 'M')
+    {
+        *VALUE *= 1024 * 1024;
+    }
+    return TRUE;
+}
+
+void readCpuTopology()
+{
+    char path[128];
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    cpuInfo.logicalCores = online > 0 ? (unsigned int) online : 1;
+    int cpuCount = configured > 0 && configured < PLATFORM_MAX_CPUS ? (int) configured : PLATFORM_MAX_CPUS;
+
+    //Cores are told apart by package and core id, hyperthread siblings share both
+    int highestPackage = -1;
+    unsigned int physicalCores = 0;
+    for (int cpu = 0; cpu < PLATFORM_MAX_CPUS; ++cpu)
+    {
+        coreIds[cpu] = -1;
+        packageIds[cpu] = -1;
+    }
+    for (int cpu = 0; cpu < cpuCount; ++cpu)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        if (!readSystemNumber(path, &coreIds[cpu]))
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        if (!readSystemNumber(path, &packageIds[cpu]))
+        {
+            packageIds[cpu] = 0;
+        }
+
+        bool8 isSibling = FALSE;
+        for (int other = 0; other < cpu && !isSibling; ++other)
+        {
+            isSibling = coreIds[other] == coreIds[cpu] && packageIds[other] == packageIds[cpu];
+        }
+        physicalCores += !isSibling;
+        highestPackage = packageIds[cpu] > highestPackage ? packageIds[cpu] : highestPackage;
+    }
+    cpuInfo.physicalCores = physicalCores ? physicalCores : cpuInfo.logicalCores;
+    cpuInfo.packages = highestPackage >= 0 ? (unsigned int) highestPackage + 1 : 1;
+
+    //The first core's caches stand for all of them
+    for (int index = 0; index < 8; ++index)
+    {
+        int level = 0;
+        int size = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        if (!readSystemNumber(path, &level))
+        {
+            break;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        readSystemNumber(path, &size);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        char type[16] = {};
+        FILE* file = fopen(path, "r");
+        if (file)
+        {
+            if (!fgets(type, sizeof(type), file))
+            {
+                type[0] = 0;
+            }
+            fclose(file);
+        }
+
+        if (level == 1 && strncmp(type, "Instruction", 11) != 0)
+        {
+            cpuInfo.l1DataCacheSize = size;
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", index);
+            int lineSize = 0;
+            if (readSystemNumber(path, &lineSize))
+            {
+                cpuInfo.cacheLineSize = lineSize;
+            }
+        }
+        else if (level == 2)
+        {
+            cpuInfo.l2CacheSize = size;
+        }
+        else if (level == 3)
+        {
+            cpuInfo.l3CacheSize = size;
+        }
+    }
+
+    if (!cpuInfo.cacheLineSize)
+    {
+        long lineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        cpuInfo.cacheLineSize = lineSize > 0 ? (unsigned int) lineSize : 64;
+    }
+    cpuInfoRead = TRUE;
+}
+
+void platformGetCpuInfo(platformCpuInfo* INFO)
+{
+    if (!cpuInfoRead)
+    {
+        readCpuTopology();
+    }
+    *INFO = cpuInfo;
+}
+
+unsigned int platformGetWorkerCores(unsigned int* LOGICAL_CORES, unsigned int MAX)
+{
+    if (!cpuInfoRead)
+    {
+        readCpuTopology();
+    }
+
+    //Affinity may have been narrowed by taskset or a container
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+        CPU_ZERO(&allowed);
+        for (unsigned int cpu = 0; cpu < cpuInfo.logicalCores && cpu < CPU_SETSIZE; ++cpu)
+        {
+            CPU_SET(cpu, &allowed);
+        }
+    }
+
+    unsigned int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < MAX; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+        {
+            continue;
+        }
+
+        //Skip a sibling of a core already handed out
+        bool8 isSibling = FALSE;
+        for (unsigned int i = 0; i < count && !isSibling && coreIds[cpu] >= 0; ++i)
+        {
+            int other = LOGICAL_CORES[i];
+            isSibling = coreIds[other] == coreIds[cpu] && packageIds[other] == packageIds[cpu];
+        }
+        if (!isSibling)
+        {
+            LOGICAL_CORES[count++] = cpu;
+        }
+    }
+    return count;
+}
+
+#endif //FORGE_PLATFORM_LINUX
@@ -0,0 +1,153 @@
+#include "platform.h"
+
+
+// - - - | Futex Synchronisation | - - -
+
+/*
+- - - | Stay out of the kernel | - - -
+    Every primitive here is a word or two of plain memory. Taking an uncontended lock or a posted semaphore is a single
+    atomic operation, the kernel only gets involved once a thread actually has to sleep. The OS side is just
+    platformFutexWait and platformFutexWake, which is why the same code serves linux and windows.
+
+    The mutex is the three state mutex from Ulrich Drepper's "Futexes Are Tricky": unlocking only makes a system call
+    when the state says someone went to sleep.
+*/
+
+#define PLATFORM_MUTEX_SPIN_COUNT 64
+
+#define PLATFORM_MUTEX_UNLOCKED 0
+#define PLATFORM_MUTEX_LOCKED 1
+#define PLATFORM_MUTEX_CONTENDED 2
+
+
+// - - - | Mutex Functions | - - -
+
+
+void platformMutexLock(platformMutex* MUTEX)
+{
+    unsigned int state = PLATFORM_MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&MUTEX->state, &state, PLATFORM_MUTEX_LOCKED, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    //Critical sections are short, the holder is likely done before a sleep would even start
+    for (unsigned int i = 0; i < PLATFORM_MUTEX_SPIN_COUNT; ++i)
+    {
+        PLATFORM_SPIN_PAUSE();
+        state = PLATFORM_MUTEX_UNLOCKED;
+        if (__atomic_load_n(&MUTEX->state, __ATOMIC_RELAXED) == PLATFORM_MUTEX_UNLOCKED && __atomic_compare_exchange_n(&MUTEX->state, &state, PLATFORM_MUTEX_LOCKED, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+    }
+
+    //Mark it contended so the holder wakes us, taking it if it came free in between
+    state = __atomic_exchange_n(&MUTEX->state, PLATFORM_MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    while (state != PLATFORM_MUTEX_UNLOCKED)
+    {
+        platformFutexWait(&MUTEX->state, PLATFORM_MUTEX_CONTENDED);
+        state = __atomic_exchange_n(&MUTEX->state, PLATFORM_MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+}
+
+bool8 platformMutexTryLock(platformMutex* MUTEX)
+{
+    unsigned int state = PLATFORM_MUTEX_UNLOCKED;
+    return __atomic_compare_exchange_n(&MUTEX->state, &state, PLATFORM_MUTEX_LOCKED, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void platformMutexUnlock(platformMutex* MUTEX)
+{
+    if (__atomic_exchange_n(&MUTEX->state, PLATFORM_MUTEX_UNLOCKED, __ATOMIC_RELEASE) == PLATFORM_MUTEX_CONTENDED)
+    {
+        platformFutexWake(&MUTEX->state, 1);
+    }
+}
+
+
+// - - - | Event Functions | - - -
+
+
+void platformEventInitialize(platformEvent* EVENT, bool8 MANUAL_RESET)
+{
+    EVENT->isSet = FALSE;
+    EVENT->isManualReset = MANUAL_RESET;
+}
+
+void platformEventSet(platformEvent* EVENT)
+{
+    if (__atomic_exchange_n(&EVENT->isSet, TRUE, __ATOMIC_RELEASE))
+    {
+        return; //Already set, every waiter has been or is about to be released
+    }
+    platformFutexWake(&EVENT->isSet, EVENT->isManualReset ? PLATFORM_FUTEX_WAKE_ALL : 1);
+}
+
+void platformEventReset(platformEvent* EVENT)
+{
+    __atomic_store_n(&EVENT->isSet, FALSE, __ATOMIC_RELAXED);
+}
+
+void platformEventWait(platformEvent* EVENT)
+{
+    if (EVENT->isManualReset)
+    {
+        while (!__atomic_load_n(&EVENT->isSet, __ATOMIC_ACQUIRE))
+        {
+            platformFutexWait(&EVENT->isSet, FALSE);
+        }
+        return;
+    }
+
+    //Auto reset, exactly one waiter gets to clear it
+    unsigned int expected = TRUE;
+    while (!__atomic_compare_exchange_n(&EVENT->isSet, &expected, FALSE, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        platformFutexWait(&EVENT->isSet, FALSE);
+        expected = TRUE;
+    }
+}
+
+
+// - - - | Semaphore Functions | - - -
+
+
+void platformSemaphoreInitialize(platformSemaphore* SEMAPHORE, unsigned int COUNT)
+{
+    SEMAPHORE->count = COUNT;
+    SEMAPHORE->waiters = 0;
+}
+
+void platformSemaphorePost(platformSemaphore* SEMAPHORE, unsigned int COUNT)
+{
+    __atomic_add_fetch(&SEMAPHORE->count, COUNT, __ATOMIC_SEQ_CST);
+    //A waiter that has not gone to sleep yet sees the new count in its futex check, so skipping the wake is safe
+    if (__atomic_load_n(&SEMAPHORE->waiters, __ATOMIC_SEQ_CST))
+    {
+        platformFutexWake(&SEMAPHORE->count, COUNT);
+    }
+}
+
+bool8 platformSemaphoreTryWait(platformSemaphore* SEMAPHORE)
+{
+    unsigned int count = __atomic_load_n(&SEMAPHORE->count, __ATOMIC_RELAXED);
+    while (count)
+    {
+        if (__atomic_compare_exchange_n(&SEMAPHORE->count, &count, count - 1, TRUE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void platformSemaphoreWait(platformSemaphore* SEMAPHORE)
+{
+    while (!platformSemaphoreTryWait(SEMAPHORE))
+    {
+        __atomic_add_fetch(&SEMAPHORE->waiters, 1, __ATOMIC_SEQ_CST);
+        platformFutexWait(&SEMAPHORE->count, 0);
+        __atomic_sub_fetch(&SEMAPHORE->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <core/logger.h>
 #include <core/input.h>
+#include <core/event.h>
 #include <stdlib.h>
 #include <string.h>
 #include <renderer/vulkan/vulkan_platform.h>
@@ -20,8 +21,12 @@ typedef struct internalState
 } internalState;
 
 // - - - Clock
-static double clockFrequency;
-static LARGE_INTEGER startTime;
+static unsigned long long tickFrequency; //Performance counter ticks per second, zero until first read
+static HANDLE sleepTimer; //Created on first use
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 
 // - - - | Platform Functions | - - -
@@ -30,10 +35,16 @@ static LARGE_INTEGER startTime;
 // - - - State Functions - - -
 
 LRESULT CALLBACK windowsProcessMessage(HWND HANDLE_WINDOW, unsigned int MESSAGE, WPARAM WINDOW_PARAMETER, LPARAM LONG_PARAMETER);
+void windowsWriteConsoleRun(HANDLE CONSOLE, char* RUN, unsigned int LENGTH);
 
 // - - - Initialize the platform
 bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y, int WIDTH, int HEIGHT)
 {
+    if (STATE->isHeadless)
+    {
+        return platformHeadlessInit(STATE);
+    }
+
     STATE->internalState = malloc(sizeof(internalState));
     internalState* state = (internalState*) STATE->internalState;
 
@@ -119,18 +130,18 @@ bool8 platformInit(platformState* STATE, const char* APPLICATION, int X, int Y,
     //If the window is initially maximized, use SW_MAXIMIZE : SW_SHOWMAXIMIZED
     ShowWindow(state->hwnd, showWindowCommandFlags);
 
-    //Clock setup
-    LARGE_INTEGER frequency;
-    QueryPerformanceFrequency(&frequency);
-    clockFrequency = 1.0 / (double)frequency.QuadPart;
-    QueryPerformanceCounter(&startTime);
-
     return TRUE;
 }
 
 // - - - Shutdown the platform
 void platformShutdown(platformState *STATE)
 {
+    if (STATE->isHeadless)
+    {
+        platformHeadlessShutdown(STATE);
+        return;
+    }
+
     internalState* state = (internalState*)STATE->internalState;
     
     if (state->hwnd)
@@ -143,9 +154,15 @@ void platformShutdown(platformState *STATE)
 // - - - Give messages
 bool8 platformGiveMessages(platformState *STATE)
 {
+    if (STATE->isHeadless)
+    {
+        return platformHeadlessGiveMessages(STATE);
+    }
+
     MSG message;
     while (PeekMessageA(&message, NULL, 0, 0, PM_REMOVE))
     {
+        inputSetEventTime(platformGetTime());
         TranslateMessage(&message);
         DispatchMessageA(&message);
     }
@@ -154,6 +171,20 @@ bool8 platformGiveMessages(platformState *STATE)
 }
 
 
+// - - - Input Thread Functions - - -
+
+bool8 platformStartInputThread(platformState* STATE)
+{
+    //Linux only, windows keeps reading input once per frame in platformGiveMessages
+    FORGE_LOG_WARNING("The input thread is not supported on windows, input is read once per frame");
+    return FALSE;
+}
+
+void platformStopInputThread(platformState* STATE)
+{
+}
+
+
 // - - - Memory Function - - -
 
 void* platformAllocateMemory(unsigned long long SIZE, bool8 ALIGNED)
@@ -182,6 +213,166 @@ void* platformSetMemory(void* DESTINATION, int VALUE, unsigned long long SIZE)
 }
 
 
+// - - - File Mapping Functions - - -
+
+bool8 platformMapFile(const char* PATH, bool8 POPULATE, void** MEMORY, unsigned long long* SIZE)
+{
+    *MEMORY = 0;
+    *SIZE = 0;
+    HANDLE file = CreateFileA(PATH, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        FORGE_LOG_ERROR("Failed to open %s for mapping: error %lu", PATH, GetLastError());
+        return FALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        FORGE_LOG_ERROR("Failed to read the size of %s: error %lu", PATH, GetLastError());
+        CloseHandle(file);
+        return FALSE;
+    }
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return TRUE;
+    }
+
+    //The view keeps the mapping and the file alive, neither handle is needed past this
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* memory = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!memory)
+    {
+        FORGE_LOG_ERROR("Failed to map %s: error %lu", PATH, GetLastError());
+        return FALSE;
+    }
+
+    *MEMORY = memory;
+    *SIZE = size.QuadPart;
+    if (POPULATE)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range = {memory, (SIZE_T) size.QuadPart};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+    return TRUE;
+}
+
+void platformUnmapFile(void* MEMORY, unsigned long long SIZE)
+{
+    if (MEMORY)
+    {
+        UnmapViewOfFile(MEMORY);
+    }
+}
+
+void platformAdviseMapping(void* MEMORY, unsigned long long SIZE, platformMappingAdvice ADVICE)
+{
+    if (!MEMORY || SIZE == 0)
+    {
+        return;
+    }
+
+    //Windows has no access pattern hints for views, only prefetching and trimming
+    if (ADVICE == PLATFORM_MAPPING_WILL_NEED)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range = {MEMORY, (SIZE_T) SIZE};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+    else if (ADVICE == PLATFORM_MAPPING_DONT_NEED)
+    {
+        VirtualUnlock(MEMORY, SIZE); //Unlocking pages that are not locked drops them from the working set
+    }
+}
+
+bool8 platformMapFileForWriting(const char* PATH, unsigned long long SIZE, platformWritableMapping* MAPPING)
+{
+    platformZeroMemory(MAPPING, sizeof(platformWritableMapping));
+    HANDLE file = CreateFileA(PATH, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        FORGE_LOG_ERROR("Failed to create %s for mapping: error %lu", PATH, GetLastError());
+        return FALSE;
+    }
+
+    //A mapping larger than the file grows the file to its size
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD) (SIZE >> 32), (DWORD) SIZE, NULL);
+    void* memory = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : 0;
+    if (!memory)
+    {
+        FORGE_LOG_ERROR("Failed to map %s for writing: error %lu", PATH, GetLastError());
+    }
+
+    //The view keeps the mapping alive, the file stays open to flush and trim through
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    if (!memory)
+    {
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    MAPPING->memory = memory;
+    MAPPING->size = SIZE;
+    MAPPING->file = (unsigned long long) file;
+    return TRUE;
+}
+
+void platformFlushMapping(const platformWritableMapping* MAPPING, unsigned long long SIZE, bool8 WAIT)
+{
+    if (!MAPPING->memory || SIZE == 0)
+    {
+        return;
+    }
+
+    //FlushViewOfFile only starts the writes, the file's buffers have to be flushed to wait for the disk
+    FlushViewOfFile(MAPPING->memory, (SIZE_T) SIZE);
+    if (WAIT)
+    {
+        FlushFileBuffers((HANDLE) MAPPING->file);
+    }
+}
+
+void platformUnmapFileForWriting(platformWritableMapping* MAPPING, unsigned long long WRITTEN_SIZE)
+{
+    if (!MAPPING->memory)
+    {
+        return;
+    }
+
+    //The end of a file cannot move while a view of it is open
+    HANDLE file = (HANDLE) MAPPING->file;
+    UnmapViewOfFile(MAPPING->memory);
+    LARGE_INTEGER end;
+    end.QuadPart = WRITTEN_SIZE;
+    if (!SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+    {
+        FORGE_LOG_WARNING("Failed to trim a mapped file to %llu bytes: error %lu", WRITTEN_SIZE, GetLastError());
+    }
+    CloseHandle(file);
+    platformZeroMemory(MAPPING, sizeof(platformWritableMapping));
+}
+
+bool8 platformGetFileSize(const char* PATH, unsigned long long* SIZE)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(PATH, GetFileExInfoStandard, &attributes))
+    {
+        *SIZE = 0;
+        return FALSE;
+    }
+    *SIZE = ((unsigned long long) attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    return TRUE;
+}
+
+
 // - - - Writing Functions - - -
 
 
@@ -209,14 +400,84 @@ void platformWriteConsoleError(const char* MESSAGE, unsigned char COLOR)
     WriteConsoleA(consoleHandle, MESSAGE, (DWORD) length, numberWritten, 0);
 }
 
+#define PLATFORM_CONSOLE_RUN_SIZE 4096
+
+void windowsWriteConsoleRun(HANDLE CONSOLE, char* RUN, unsigned int LENGTH)
+{
+    //The debugger output takes a C string, the run always has room left for the terminator
+    RUN[LENGTH] = 0;
+    OutputDebugStringA(RUN);
+    DWORD numberWritten = 0;
+    WriteConsoleA(CONSOLE, RUN, (DWORD) LENGTH, &numberWritten, 0);
+}
+
+void platformWriteConsoleBuffers(const platformConsoleBuffer* BUFFERS, unsigned int COUNT, bool8 IS_ERROR, bool8 USE_COLOR)
+{
+    HANDLE consoleHandle = GetStdHandle(IS_ERROR ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    static unsigned char levels[6] = { 64, 4, 6, 2, 1, 8 };
+
+    //Messages of the same color are gathered into one write, the attribute only changes between runs
+    char run[PLATFORM_CONSOLE_RUN_SIZE];
+    unsigned int runLength = 0;
+    unsigned char runColor = 0;
+    int attribute = -1; //Not set by this call yet
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        const platformConsoleBuffer* buffer = &BUFFERS[i];
+        unsigned char color = USE_COLOR ? levels[buffer->color < 6 ? buffer->color : 5] : 0;
+        if (runLength > 0 && (color != runColor || runLength + buffer->length >= PLATFORM_CONSOLE_RUN_SIZE))
+        {
+            windowsWriteConsoleRun(consoleHandle, run, runLength);
+            runLength = 0;
+        }
+        if (USE_COLOR && color != attribute)
+        {
+            SetConsoleTextAttribute(consoleHandle, color);
+            attribute = color;
+        }
+        runColor = color;
+
+        if (buffer->length >= PLATFORM_CONSOLE_RUN_SIZE)
+        {
+            //Too long to gather, it is already terminated so it goes out as it is
+            OutputDebugStringA(buffer->text);
+            DWORD numberWritten = 0;
+            WriteConsoleA(consoleHandle, buffer->text, (DWORD) buffer->length, &numberWritten, 0);
+            continue;
+        }
+        memcpy(run + runLength, buffer->text, buffer->length);
+        runLength += buffer->length;
+    }
+    if (runLength > 0)
+    {
+        windowsWriteConsoleRun(consoleHandle, run, runLength);
+    }
+}
+
 
 // - - - Time and Sleep Functions - - -
 
-double platformGetTime()
+unsigned long long platformGetTicks()
 {
+    //The frequency is fixed at boot, reading it again from another thread writes the same value
+    if (!tickFrequency)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        tickFrequency = frequency.QuadPart;
+    }
+
+    //Split into whole seconds first so the scale to nanoseconds cannot overflow
     LARGE_INTEGER now;
     QueryPerformanceCounter(&now);
-    return (double) now.QuadPart * clockFrequency;
+    unsigned long long seconds = now.QuadPart / tickFrequency;
+    unsigned long long remainder = now.QuadPart % tickFrequency;
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / tickFrequency;
+}
+
+double platformGetTime()
+{
+    return platformGetTicks() * 0.000000001;
 }
 
 void platformSleep(unsigned long long MILLISECONDS)
@@ -224,6 +485,35 @@ void platformSleep(unsigned long long MILLISECONDS)
     Sleep(MILLISECONDS);
 }
 
+void platformSleepUntil(unsigned long long TICKS)
+{
+    unsigned long long now = platformGetTicks();
+    if (TICKS <= now)
+    {
+        return;
+    }
+
+    //High resolution timers wake within a fraction of a millisecond instead of the next scheduler tick (Windows 10 1803 and later)
+    if (!sleepTimer)
+    {
+        sleepTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!sleepTimer)
+        {
+            sleepTimer = INVALID_HANDLE_VALUE;
+        }
+    }
+    if (sleepTimer == INVALID_HANDLE_VALUE)
+    {
+        Sleep((TICKS - now) / 1000000);
+        return;
+    }
+
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(long long) ((TICKS - now) / 100); //Negative is relative, in 100 nanosecond units
+    SetWaitableTimer(sleepTimer, &dueTime, 0, NULL, NULL, FALSE);
+    WaitForSingleObject(sleepTimer, INFINITE);
+}
+
 
 // - - - | Window Message Procedure | - - -
 
@@ -245,11 +535,12 @@ LRESULT CALLBACK windowsProcessMessage(HWND HANDLE_WINDOW, unsigned int MESSAGE,
             return 0;
 
         case WM_SIZE:
-            // RECT r;
-            // GetClientRect(HANDLE_WINDOW, &r);
-            // unsigned int width = r.right - r.left;
-            // unsigned int height = r.bottom - r.top;
-            // TODO: fire an event for window resize
+            RECT rectangle;
+            GetClientRect(HANDLE_WINDOW, &rectangle);
+            eventContext context;
+            context.data.u16[0] = (unsigned short) (rectangle.right - rectangle.left);
+            context.data.u16[1] = (unsigned short) (rectangle.bottom - rectangle.top);
+            eventPost(EVENT_CODE_RESIZE, 0, context);
             break;
 
         case WM_KEYDOWN:
@@ -327,6 +618,12 @@ void platformGetRequiredExtensions(const char*** EXTENSIONS)
 
 bool8 platformCreateVulkanSurface(platformState* PLATFORM_STATE, vulkanContext* CONTEXT)
 {
+    if (PLATFORM_STATE->isHeadless)
+    {
+        FORGE_LOG_FATAL("A headless platform has no window to render to, use the null renderer");
+        return FALSE;
+    }
+
     internalState* state = (internalState*)PLATFORM_STATE->internalState;
 
     VkWin32SurfaceCreateInfoKHR createInfo = {VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR};
@@ -0,0 +1,28 @@
+#include "platform.h"
+#if FORGE_PLATFORM_WINDOWS
+
+#include "core/logger.h"
+
+
+// - - - | Windows Performance Counters | - - -
+
+// Not supported: user mode has no access to the counters without a kernel driver. The group stays empty and reads as zeros
+
+bool8 platformCountersOpen(platformCounterGroup* GROUP)
+{
+    GROUP->internalState = 0;
+    GROUP->available = 0;
+    FORGE_LOG_INFO("Hardware counters are not supported on windows, frame statistics keep wall time only");
+    return FALSE;
+}
+
+void platformCountersClose(platformCounterGroup* GROUP)
+{
+}
+
+void platformCountersRead(const platformCounterGroup* GROUP, platformCounterValues* VALUES)
+{
+    platformZeroMemory(VALUES, sizeof(platformCounterValues));
+}
+
+#endif //FORGE_PLATFORM_WINDOWS
@@ -0,0 +1,302 @@
+#include "platform.h"
+#if FORGE_PLATFORM_WINDOWS
+
+#include "core/logger.h"
+
+#include <stdlib.h>
+#include <windows.h>
+
+
+// - - - | Thread State | - - -
+
+
+// - - - Start Arguments, freed by the new thread once it has them
+typedef struct platformThreadStart
+{
+    platformThreadFunction function;
+    void* argument;
+} platformThreadStart;
+
+// - - - Thread Descriptions, Windows 10 1607 and later, looked up so older systems still load the engine
+typedef HRESULT (WINAPI *setThreadDescriptionFunction)(HANDLE THREAD, PCWSTR DESCRIPTION);
+
+static bool8 cpuInfoRead = FALSE;
+static platformCpuInfo cpuInfo;
+
+// - - - One mask per physical core, all its hyperthreads. Only processor group 0, at most 64 logical cores
+#define PLATFORM_MAX_CORES 64
+static ULONG_PTR coreMasks[PLATFORM_MAX_CORES];
+static unsigned int coreMaskCount;
+
+DWORD WINAPI platformThreadEntry(LPVOID START);
+
+bool8 setThreadName(HANDLE THREAD, const char* NAME);
+
+void readCpuTopology();
+
+
+// - - - | Thread Functions | - - -
+
+
+bool8 platformThreadCreate(platformThread* THREAD, const char* NAME, platformThreadFunction FUNCTION, void* ARGUMENT)
+{
+    platformThreadStart* start = malloc(sizeof(platformThreadStart));
+    if (!start)
+    {
+        return FALSE;
+    }
+    start->function = FUNCTION;
+    start->argument = ARGUMENT;
+
+    HANDLE thread = CreateThread(0, 0, platformThreadEntry, start, 0, 0);
+    if (!thread)
+    {
+        FORGE_LOG_ERROR("Failed to create thread %s: error %lu", NAME ? NAME : "", GetLastError());
+        free(start);
+        THREAD->handle = 0;
+        return FALSE;
+    }
+
+    if (NAME)
+    {
+        setThreadName(thread, NAME);
+    }
+
+    THREAD->handle = (unsigned long long) thread;
+    return TRUE;
+}
+
+DWORD WINAPI platformThreadEntry(LPVOID START)
+{
+    platformThreadStart start = *(platformThreadStart*) START;
+    free(START);
+    return start.function(start.argument);
+}
+
+unsigned int platformThreadJoin(platformThread* THREAD)
+{
+    if (!THREAD->handle)
+    {
+        return 0;
+    }
+
+    DWORD result = 0;
+    WaitForSingleObject((HANDLE) THREAD->handle, INFINITE);
+    GetExitCodeThread((HANDLE) THREAD->handle, &result);
+    CloseHandle((HANDLE) THREAD->handle);
+    THREAD->handle = 0;
+    return result;
+}
+
+bool8 platformThreadSetAffinity(platformThread* THREAD, unsigned int LOGICAL_CORE)
+{
+    if (LOGICAL_CORE >= PLATFORM_MAX_CORES)
+    {
+        return FALSE;
+    }
+
+    if (!SetThreadAffinityMask((HANDLE) THREAD->handle, (ULONG_PTR) 1 << LOGICAL_CORE))
+    {
+        FORGE_LOG_WARNING("Failed to pin thread to core %u: error %lu", LOGICAL_CORE, GetLastError());
+        return FALSE;
+    }
+    return TRUE;
+}
+
+bool8 setThreadName(HANDLE THREAD, const char* NAME)
+{
+    static setThreadDescriptionFunction setThreadDescription;
+    if (!setThreadDescription)
+    {
+        setThreadDescription = (setThreadDescriptionFunction) GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        if (!setThreadDescription)
+        {
+            return FALSE;
+        }
+    }
+
+    wchar_t name[PLATFORM_THREAD_NAME_LENGTH * 4];
+    if (!MultiByteToWideChar(CP_UTF8, 0, NAME, -1, name, sizeof(name) / sizeof(name[0])))
+    {
+        return FALSE;
+    }
+    return SUCCEEDED(setThreadDescription(THREAD, name));
+}
+
+bool8 platformThreadSetCurrentName(const char* NAME)
+{
+    return setThreadName(GetCurrentThread(), NAME);
+}
+
+unsigned long long platformThreadGetCurrentId()
+{
+    return GetCurrentThreadId();
+}
+
+void platformThreadYield()
+{
+    SwitchToThread();
+}
+
+
+// - - - | Futex Functions | - - -
+
+
+void platformFutexWait(unsigned int* ADDRESS, unsigned int EXPECTED)
+{
+    WaitOnAddress(ADDRESS, &EXPECTED, sizeof(EXPECTED), INFINITE);
+}
+
+void platformFutexWake(unsigned int* ADDRESS, unsigned int COUNT)
+{
+    if (COUNT == PLATFORM_FUTEX_WAKE_ALL)
+    {
+        WakeByAddressAll(ADDRESS);
+        return;
+    }
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        WakeByAddressSingle(ADDRESS);
+    }
+}
+
+
+// - - - | Thread Local Storage Functions | - - -
+
+
+bool8 platformTlsAllocate(platformTlsKey* KEY)
+{
+    DWORD key = TlsAlloc();
+    if (key == TLS_OUT_OF_INDEXES)
+    {
+        return FALSE;
+    }
+    *KEY = key;
+    return TRUE;
+}
+
+void platformTlsFree(platformTlsKey KEY)
+{
+    TlsFree((DWORD) KEY);
+}
+
+void platformTlsSet(platformTlsKey KEY, void* VALUE)
+{
+    TlsSetValue((DWORD) KEY, VALUE);
+}
+
+void* platformTlsGet(platformTlsKey KEY)
+{
+    return TlsGetValue((DWORD) KEY);
+}
+
+
+// - - - | CPU Topology Functions | - - -
+
+
+void readCpuTopology()
+{
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    cpuInfo.logicalCores = system.dwNumberOfProcessors;
+    cpuInfo.cacheLineSize = 64;
+    cpuInfoRead = TRUE;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, 0, &length);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* buffer = length ? malloc(length) : 0;
+    if (!buffer || !GetLogicalProcessorInformationEx(RelationAll, buffer, &length))
+    {
+        FORGE_LOG_WARNING("Could not read the processor topology, assuming one logical core per physical core");
+        free(buffer);
+        cpuInfo.physicalCores = cpuInfo.logicalCores;
+        cpuInfo.packages = 1;
+        return;
+    }
+
+    //Records vary in size, each says how long it is
+    for (DWORD offset = 0; offset < length;)
+    {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* record = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*) ((char*) buffer + offset);
+        switch (record->Relationship)
+        {
+            case RelationProcessorCore:
+                cpuInfo.physicalCores++;
+                if (coreMaskCount < PLATFORM_MAX_CORES && record->Processor.GroupMask[0].Group == 0)
+                {
+                    coreMasks[coreMaskCount++] = record->Processor.GroupMask[0].Mask;
+                }
+                break;
+
+            case RelationProcessorPackage:
+                cpuInfo.packages++;
+                break;
+
+            case RelationCache:
+                //The first core's caches stand for all of them
+                if (record->Cache.Level == 1 && record->Cache.Type != CacheInstruction && !cpuInfo.l1DataCacheSize)
+                {
+                    cpuInfo.l1DataCacheSize = record->Cache.CacheSize;
+                    cpuInfo.cacheLineSize = record->Cache.LineSize;
+                }
+                else if (record->Cache.Level == 2 && !cpuInfo.l2CacheSize)
+                {
+                    cpuInfo.l2CacheSize = record->Cache.CacheSize;
+                }
+                else if (record->Cache.Level == 3 && !cpuInfo.l3CacheSize)
+                {
+                    cpuInfo.l3CacheSize = record->Cache.CacheSize;
+                }
+                break;
+
+            default:
+                break;
+        }
+        offset += record->Size;
+    }
+    free(buffer);
+}
+
+void platformGetCpuInfo(platformCpuInfo* INFO)
+{
+    if (!cpuInfoRead)
+    {
+        readCpuTopology();
+    }
+    *INFO = cpuInfo;
+}
+
+unsigned int platformGetWorkerCores(unsigned int* LOGICAL_CORES, unsigned int MAX)
+{
+    if (!cpuInfoRead)
+    {
+        readCpuTopology();
+    }
+
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+    {
+        processMask = ~(DWORD_PTR) 0;
+    }
+
+    unsigned int count = 0;
+    for (unsigned int core = 0; core < coreMaskCount && count < MAX; ++core)
+    {
+        ULONG_PTR usable = coreMasks[core] & processMask;
+        if (!usable)
+        {
+            continue;
+        }
+
+        unsigned int logical = 0;
+        while (!(usable & ((ULONG_PTR) 1 << logical)))
+        {
+            ++logical;
+        }
+        LOGICAL_CORES[count++] = logical;
+    }
+    return count;
+}
+
+#endif //FORGE_PLATFORM_WINDOWS
@@ -0,0 +1,31 @@
+#include "null_backend.h"
+#include "core/logger.h"
+
+
+// - - - | Null Renderer Backend | - - -
+
+
+bool8 nullRendererBackendInitialize(rendererBackend* BACKEND, const char* APPLICATION, struct platformState* PLATFORM)
+{
+    FORGE_LOG_INFO("Null renderer in use, frames are accepted but nothing is drawn");
+    return TRUE;
+}
+
+void nullRendererBackendShutdown(rendererBackend* BACKEND)
+{
+    FORGE_LOG_DEBUG("Null renderer shut down after %llu frames", BACKEND->frameNumber);
+}
+
+void nullRendererBackendResized(rendererBackend* BACKEND, unsigned short WIDTH, unsigned short HEIGHT)
+{
+}
+
+bool8 nullRendererBackendBeginFrame(rendererBackend* BACKEND, float DELTA_TIME)
+{
+    return TRUE;
+}
+
+bool8 nullRendererBackendEndFrame(rendererBackend* BACKEND, float DELTA_TIME)
+{
+    return TRUE;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "renderer/renderer_backend.h"
+
+
+// - - - | Null Renderer Backend | - - -
+
+/*
+- - - | Nothing to draw | - - -
+    Accepts every frame and draws nothing, for headless servers and benchmarks of everything but rendering.
+    The frontend still counts frames so frame based code behaves as it would with a real backend.
+*/
+
+
+// - - - Start and Shutdown - - -
+
+bool8 nullRendererBackendInitialize(rendererBackend* BACKEND, const char* APPLICATION, struct platformState* PLATFORM);
+void nullRendererBackendShutdown(rendererBackend* BACKEND);
+
+// - - - Utils - - -
+void nullRendererBackendResized(rendererBackend* BACKEND, unsigned short WIDTH, unsigned short HEIGHT);
+
+// - - - Frame - - -
+bool8 nullRendererBackendBeginFrame(rendererBackend* BACKEND, float DELTA_TIME);
+bool8 nullRendererBackendEndFrame(rendererBackend* BACKEND, float DELTA_TIME);
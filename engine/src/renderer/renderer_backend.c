@@ -1,6 +1,7 @@
 #include "renderer_backend.h"
 #include "renderer_types.h"
 #include "vulkan/vulkan_backend.h"
+#include "null/null_backend.h"
 
 // - - - Renderer Backend Functions - - -
 
@@ -15,7 +16,13 @@ bool8 rendererBackendCreate(rendererBackendType TYPE, struct platformState* PLAT
             return TRUE;
 
         case RENDERER_NULL:
-            return TRUE; // If You dont want a renderer, you could just say so
+            // If You dont want a renderer, you could just say so
+            BACKEND->initialize = nullRendererBackendInitialize;
+            BACKEND->shutdown = nullRendererBackendShutdown;
+            BACKEND->resized = nullRendererBackendResized;
+            BACKEND->beginFrame = nullRendererBackendBeginFrame;
+            BACKEND->endFrame = nullRendererBackendEndFrame;
+            return TRUE;
 
         case RENDERER_DIRECTX:
             //TODO: make a DirectX renderer
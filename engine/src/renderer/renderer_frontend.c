@@ -14,14 +14,20 @@ static rendererBackend* rendererBackendInstance = 0;
 
 // - - - Renderer Frontend Class Methods - - -
 
-bool8 rendererIntitialize(const char* APPLICATION, struct platformState *PLATFORM_STATE)
+bool8 rendererIntitialize(rendererBackendType TYPE, const char* APPLICATION, struct platformState *PLATFORM_STATE)
 {
     rendererBackendInstance = forgeAllocateMemory(sizeof(rendererBackend), MEMORY_TAG_RENDERER);
 
-    //TODO: make this configurable
-    rendererBackendCreate(RENDERER_VULKAN, PLATFORM_STATE, rendererBackendInstance);
+    rendererBackendCreate(TYPE, PLATFORM_STATE, rendererBackendInstance);
     rendererBackendInstance->frameNumber = 0;
 
+    //Backends that are not written yet leave their functions empty
+    if (!rendererBackendInstance->initialize)
+    {
+        FORGE_LOG_FATAL("Renderer Backend %i is not supported yet!", TYPE);
+        return FALSE;
+    }
+
     if (!rendererBackendInstance->initialize(rendererBackendInstance, APPLICATION, PLATFORM_STATE))
     {
         FORGE_LOG_FATAL("Renderer Backend Failed to Create!");
@@ -38,6 +44,16 @@ void rendererShutdown()
     FORGE_LOG_INFO("Renderer Backend Shutdown!");
 }
 
+void rendererResized(unsigned short WIDTH, unsigned short HEIGHT)
+{
+    if (!rendererBackendInstance)
+    {
+        FORGE_LOG_WARNING("Renderer resized before it was initialised: %i x %i", WIDTH, HEIGHT);
+        return;
+    }
+    rendererBackendInstance->resized(rendererBackendInstance, WIDTH, HEIGHT);
+}
+
 bool8 rendererBeginFrame(float DELTA_TIME)
 {
     return rendererBackendInstance->beginFrame(rendererBackendInstance, DELTA_TIME);
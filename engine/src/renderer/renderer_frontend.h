@@ -12,7 +12,7 @@ struct platformState;
 
 // - - - Renderer Frontend Struct (Class) - - -
 
-bool8 rendererIntitialize(const char* APPLICATION, struct platformState* PLATFORM_STATE);
+bool8 rendererIntitialize(rendererBackendType TYPE, const char* APPLICATION, struct platformState* PLATFORM_STATE);
 
 void rendererShutdown();
 
@@ -22,6 +22,12 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vkDebugCallback(VkDebugUtilsMessageSeverityFlagBi
 // - - - FindMemoryIndex
 int findMemoryIndex(unsigned int TYPE_FILTER, unsigned int PROPERTIES_FLAGS);
 
+// - - - Swapchain Recreation
+// A window being dragged resizes every frame, wait this long after the last resize before rebuilding
+#define VULKAN_RESIZE_SETTLE_SECONDS 0.1
+
+bool8 rebuildSwapchain();
+
 
 // - - - | Vulkan as a Renderer Backend | - - -
 
@@ -143,6 +149,16 @@ bool8 vulkanRendererBackendInitialize(rendererBackend* BACKEND, const char* APPL
         return FALSE;
     }
 
+    //Start from the size the window has now
+    VkExtent2D currentExtent = context.device.swapchainSupport.capabilities.currentExtent;
+    if (currentExtent.width != UINT32_MAX)
+    {
+        context.framebufferWidth = currentExtent.width;
+        context.framebufferHeight = currentExtent.height;
+    }
+    context.cachedFramebufferWidth = context.framebufferWidth;
+    context.cachedFramebufferHeight = context.framebufferHeight;
+
     // Swapchain
     createVulkanSwapchain(&context, context.framebufferWidth, context.framebufferHeight, &context.swapchain);
     
@@ -180,10 +196,34 @@ void vulkanRendererBackendShutdown(rendererBackend* BACKEND)
 
 void vulkanRendererBackendResized(rendererBackend* BACKEND, unsigned short WIDTH, unsigned short HEIGHT)
 {
+    //Only remember it, the swapchain is rebuilt by beginFrame once the size settles
+    context.cachedFramebufferWidth = WIDTH;
+    context.cachedFramebufferHeight = HEIGHT;
+    context.framebufferSizeGeneration++;
+    context.lastResizeTime = platformGetTime();
+    FORGE_LOG_TRACE("Vulkan backend resized: %i x %i (%llu)", WIDTH, HEIGHT, context.framebufferSizeGeneration);
 }
 
 bool8 vulkanRendrerBackendBeginFrame(rendererBackend* BACKEND, float DELTA_TIME)
 {
+    bool8 sizeChanged = context.framebufferSizeGeneration != context.framebufferSizeLastGeneration;
+    if (sizeChanged || context.recreateSwapchain)
+    {
+        bool8 settled = platformGetTime() - context.lastResizeTime >= VULKAN_RESIZE_SETTLE_SECONDS;
+        if (settled)
+        {
+            //At most once per frame, and this frame is skipped
+            rebuildSwapchain();
+            return FALSE;
+        }
+
+        //An out of date swapchain cannot be drawn to, a stale sized one still can until the size settles
+        if (context.recreateSwapchain)
+        {
+            return FALSE;
+        }
+    }
+
     return TRUE;
 }
 
@@ -199,24 +239,44 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vkDebugCallback(VkDebugUtilsMessageSeverityFlagBi
         default:
 
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-            FORGE_LOG_ERROR(CALLBACK_DATA->pMessage);
+            FORGE_LOG_ERROR("%s", CALLBACK_DATA->pMessage);
             break;
 
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-            FORGE_LOG_WARNING(CALLBACK_DATA->pMessage);
+            FORGE_LOG_WARNING("%s", CALLBACK_DATA->pMessage);
             break;
 
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-            FORGE_LOG_INFO(CALLBACK_DATA->pMessage);
+            FORGE_LOG_INFO("%s", CALLBACK_DATA->pMessage);
             break;
 
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-            FORGE_LOG_TRACE(CALLBACK_DATA->pMessage);
+            FORGE_LOG_TRACE("%s", CALLBACK_DATA->pMessage);
             break;
     }
     return VK_FALSE;
 }
 
+bool8 rebuildSwapchain()
+{
+    //Minimised, nothing to present to
+    if (context.cachedFramebufferWidth == 0 || context.cachedFramebufferHeight == 0)
+    {
+        return FALSE;
+    }
+
+    vkDeviceWaitIdle(context.device.logicalDevice);
+
+    context.framebufferWidth = context.cachedFramebufferWidth;
+    context.framebufferHeight = context.cachedFramebufferHeight;
+    recreateVulkanSwapchain(&context, context.framebufferWidth, context.framebufferHeight, &context.swapchain);
+
+    context.framebufferSizeLastGeneration = context.framebufferSizeGeneration;
+    context.recreateSwapchain = FALSE;
+    FORGE_LOG_DEBUG("Swapchain recreated at %i x %i", context.framebufferWidth, context.framebufferHeight);
+    return TRUE;
+}
+
 int findMemoryIndex(unsigned int TYPE_FILTER, unsigned int PROPERTY_FLAGS)
 {
     VkPhysicalDeviceMemoryProperties memoryProperties;
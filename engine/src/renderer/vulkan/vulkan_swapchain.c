@@ -177,8 +177,8 @@ bool8 vulkanSwapchainAquireNextImageIndex(vulkanContext* CONTEXT, vulkanSwapchai
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        //Trigger swapchain recreation and boot out of render order
-        recreateVulkanSwapchain(CONTEXT, CONTEXT->framebufferWidth, CONTEXT->framebufferHeight, SWAPCHAIN);
+        //Flag swapchain recreation for the next frame and boot out of render order
+        CONTEXT->recreateSwapchain = TRUE;
         return FALSE;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
@@ -203,8 +203,8 @@ void vulkanSwapchainPresentImage(vulkanContext* CONTEXT, vulkanSwapchain* SWAPCH
     VkResult result = vkQueuePresentKHR(PRESENT_QUEUE, &presentInfo);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
-        //Trigger swapchain recreation
-        recreateVulkanSwapchain(CONTEXT, CONTEXT->framebufferWidth, CONTEXT->framebufferHeight, SWAPCHAIN);
+        //Flag swapchain recreation, the next frame does it once
+        CONTEXT->recreateSwapchain = TRUE;
     }
     else if (result != VK_SUCCESS)
     {
@@ -74,6 +74,13 @@ typedef struct vulkanContext
 {
     unsigned int framebufferHeight;
     unsigned int framebufferWidth;
+
+    //Latest size reported by the window, applied once it stops changing
+    unsigned int cachedFramebufferWidth;
+    unsigned int cachedFramebufferHeight;
+    unsigned long long framebufferSizeGeneration;
+    unsigned long long framebufferSizeLastGeneration;
+    double lastResizeTime;
     VkInstance instance;
     VkAllocationCallbacks* allocator;
     VkSurfaceKHR surface;
@@ -0,0 +1,22 @@
+REM Build script for the binary log decoder
+@ECHO OFF
+SetLocal EnableDelayedExpansion
+
+REM Get a list of all the .c files, the engine's log_binary.c is built in rather than linking the engine
+SET cFilenames=
+FOR /R %%f in (*.c) do (
+    SET cFilenames=!cFilenames! %%f
+)
+SET cFilenames=!cFilenames! ../engine/src/core/log_binary.c
+
+REM echo "Files:" %cFilenames%
+
+SET assembly=Just_Forge_Log_Decoder
+SET compilerFlags=-g 
+REM -Wall -Werror
+SET includeFlags=-Isrc -I../engine/src/
+SET linkerFlags=
+SET defines=-D_DEBUG -D_CRT_SECURE_NO_WARNINGS
+
+ECHO "Building %assembly%%..."
+clang %cFilenames% %compilerFlags% -o ../build/%assembly%.exe %defines% %includeFlags% %linkerFlags%
@@ -0,0 +1,20 @@
+#!/bin/bash
+# Build script for the binary log decoder
+set echo on
+
+mkdir -p ../build
+
+# The decoder shares the record format with the engine, its one source file is built in rather than linking the engine
+cFilenames="$(find . -type f -name "*.c") ../engine/src/core/log_binary.c"
+
+# echo "Files:" $cFilenames
+
+assembly="Just_Forge_Log_Decoder"
+compilerFlags="-g"
+# -Wall -Werror
+includeFlags="-Isrc -I../engine/src/"
+linkerFlags=""
+defines="-D_DEBUG"
+
+echo "Building $assembly..."
+clang $cFilenames $compilerFlags -o ../build/$assembly $defines $includeFlags $linkerFlags
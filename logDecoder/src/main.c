@@ -0,0 +1,170 @@
+#include <core/log_binary.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// - - - | Log Decoder | - - -
+
+// Turns a binary log from LOGGER_MODE_BINARY back into the lines the engine would have printed, each with
+// its time in seconds since the log was opened.
+// Usage: Just_Forge_Log_Decoder LOG_FILE [OUTPUT_FILE]
+
+#define DECODER_LINE_MAX 8192
+
+static const char* levelStrings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: "};
+
+// - - - Formats by id, named by the file as it goes
+static char** formats;
+static unsigned int formatCapacity;
+
+bool8 storeFormat(unsigned int ID, const char* TEXT, unsigned int LENGTH);
+
+
+int main(int ARGUMENT_COUNT, char** ARGUMENTS)
+{
+    if (ARGUMENT_COUNT < 2)
+    {
+        fprintf(stderr, "Usage: %s LOG_FILE [OUTPUT_FILE]\n", ARGUMENTS[0]);
+        return 1;
+    }
+
+    FILE* input = fopen(ARGUMENTS[1], "rb");
+    if (!input)
+    {
+        fprintf(stderr, "Cannot open %s\n", ARGUMENTS[1]);
+        return 1;
+    }
+    FILE* output = ARGUMENT_COUNT > 2 ? fopen(ARGUMENTS[2], "w") : stdout;
+    if (!output)
+    {
+        fprintf(stderr, "Cannot create %s\n", ARGUMENTS[2]);
+        return 1;
+    }
+
+    logFileHeader header;
+    if (fread(&header, sizeof(header), 1, input) != 1 || memcmp(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic)) != 0)
+    {
+        fprintf(stderr, "%s is not a binary log\n", ARGUMENTS[1]);
+        return 1;
+    }
+    if (header.version != LOG_BINARY_VERSION)
+    {
+        fprintf(stderr, "%s is version %u, this decoder reads version %u\n", ARGUMENTS[1], header.version, LOG_BINARY_VERSION);
+        return 1;
+    }
+
+    unsigned char* payload = 0;
+    unsigned int payloadCapacity = 0;
+    char line[DECODER_LINE_MAX];
+    unsigned long long messages = 0;
+
+    logRecord record;
+    while (fread(&record, sizeof(record), 1, input) == 1)
+    {
+        if (record.size > payloadCapacity)
+        {
+            unsigned char* grown = realloc(payload, record.size);
+            if (!grown)
+            {
+                fprintf(stderr, "Out of memory reading a record of %u bytes, %llu messages decoded\n", record.size, messages);
+                break;
+            }
+            payload = grown;
+            payloadCapacity = record.size;
+        }
+        //The writer flushes whole batches, a cut off record means the process died while writing it
+        if (record.size && fread(payload, 1, record.size, input) != record.size)
+        {
+            fprintf(stderr, "Log ends in the middle of a record, %llu messages decoded\n", messages);
+            break;
+        }
+
+        double seconds = (double) (record.ticks - header.startTicks) / (double) header.ticksPerSecond;
+        const char* level = record.level < 6 ? levelStrings[record.level] : "";
+        switch (record.kind)
+        {
+            case LOG_RECORD_FORMAT:
+                if (!storeFormat(record.id, (const char*) payload, record.size))
+                {
+                    fprintf(stderr, "Out of memory storing format %u\n", record.id);
+                    return 1;
+                }
+                break;
+
+            case LOG_RECORD_MESSAGE:
+                if (record.id >= formatCapacity || !formats[record.id])
+                {
+                    fprintf(output, "%12.6f %sformat %u was never named in this log\n", seconds, level, record.id);
+                    break;
+                }
+                logDecodeMessage(formats[record.id], payload, record.size, line, sizeof(line));
+                fprintf(output, "%12.6f %s%s\n", seconds, level, line);
+                ++messages;
+                break;
+
+            case LOG_RECORD_TEXT:
+                //Formatted by the engine already, level and newline included
+                fprintf(output, "%12.6f %.*s", seconds, (int) record.size, (const char*) payload);
+                ++messages;
+                break;
+
+            case LOG_RECORD_DROPPED:
+            {
+                unsigned long long dropped = 0;
+                memcpy(&dropped, payload, record.size < sizeof(dropped) ? record.size : sizeof(dropped));
+                fprintf(output, "%12.6f %s%llu log messages dropped, the logging thread's ring was full\n", seconds, level, dropped);
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unknown record kind %u, stopping\n", record.kind);
+                fclose(input);
+                return 1;
+        }
+    }
+
+    free(payload);
+    for (unsigned int i = 0; i < formatCapacity; ++i)
+    {
+        free(formats[i]);
+    }
+    free(formats);
+    fclose(input);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
+
+bool8 storeFormat(unsigned int ID, const char* TEXT, unsigned int LENGTH)
+{
+    if (ID >= formatCapacity)
+    {
+        unsigned int capacity = formatCapacity ? formatCapacity : 256;
+        while (capacity <= ID)
+        {
+            capacity *= 2;
+        }
+        char** grown = realloc(formats, sizeof(char*) * capacity);
+        if (!grown)
+        {
+            return FALSE;
+        }
+        memset(grown + formatCapacity, 0, sizeof(char*) * (capacity - formatCapacity));
+        formats = grown;
+        formatCapacity = capacity;
+    }
+
+    free(formats[ID]);
+    formats[ID] = malloc(LENGTH + 1);
+    if (!formats[ID])
+    {
+        return FALSE;
+    }
+    memcpy(formats[ID], TEXT, LENGTH);
+    formats[ID][LENGTH] = 0;
+    return TRUE;
+}